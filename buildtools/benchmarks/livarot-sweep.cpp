@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of the livarot sweep, Shape::ConvertToShape(), which boolean operations, offsets and
+ * fills of paths all go through
+ *
+ * Build with "make sweep-benchmark" (it is not built by default), then run
+ *
+ *     sweep-benchmark [polygons [sides]]
+ *
+ * It removes the intersections of three kinds of input: polygons scattered at random so that they
+ * overlap, the same polygons laid out in a grid so that they do not, and one polygon through as
+ * many random points, which intersects itself everywhere. Times are in milliseconds, the best of a
+ * few runs, and do not include making the input.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <2geom/point.h>
+
+#include "livarot/Shape.h"
+
+namespace {
+
+constexpr int RUNS = 5;
+
+/// Best time taken to convert the shape made by @a make, in milliseconds; @a edges is set to
+/// the number of edges in the result.
+double best_of(std::function<void(Shape &)> const &make, int &edges)
+{
+    double best = 1e300;
+    for (int run = 0; run < RUNS; run++) {
+        Shape source;
+        make(source);
+        Shape result;
+        auto const start = std::chrono::steady_clock::now();
+        result.ConvertToShape(&source, fill_nonZero);
+        auto const end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        edges = result.numberOfEdges();
+    }
+    return best;
+}
+
+/// Add a regular polygon of @a sides sides around @a center to @a shape.
+void add_polygon(Shape &shape, Geom::Point const &center, double radius, int sides)
+{
+    int const first = shape.numberOfPoints();
+    for (int i = 0; i < sides; i++) {
+        double const angle = 2 * M_PI * i / sides;
+        shape.AddPoint(center + radius * Geom::Point(std::cos(angle), std::sin(angle)));
+    }
+    for (int i = 0; i < sides; i++) {
+        shape.AddEdge(first + i, first + (i + 1) % sides);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int const n = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int const sides = argc > 2 ? std::atoi(argv[2]) : 32;
+    if (n <= 0 || sides < 3) {
+        std::cerr << "Usage: " << argv[0] << " [polygons [sides]]" << std::endl;
+        return 1;
+    }
+
+    std::cout << n << " polygons of " << sides << " sides" << std::endl << std::fixed << std::setprecision(1);
+
+    // Polygons a tenth of the spacing of a grid of as many apart overlap a few others each.
+    double const spacing = 100;
+    int const per_row = std::ceil(std::sqrt(n));
+    double const size = per_row * spacing;
+
+    auto const overlapping = [&](Shape &shape) {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> coord(0, size);
+        shape.Reset(n * sides, n * sides);
+        for (int i = 0; i < n; i++) {
+            add_polygon(shape, Geom::Point(coord(rng), coord(rng)), spacing * 0.8, sides);
+        }
+    };
+    auto const disjoint = [&](Shape &shape) {
+        shape.Reset(n * sides, n * sides);
+        for (int i = 0; i < n; i++) {
+            auto const center = Geom::Point(i % per_row + 0.5, i / per_row + 0.5) * spacing;
+            add_polygon(shape, center, spacing * 0.4, sides);
+        }
+    };
+    // As many points as all the polygons above have corners would make far too many intersections.
+    int const points = std::max(3, static_cast<int>(std::sqrt(n * sides) * 4));
+    auto const tangle = [&](Shape &shape) {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> coord(0, size);
+        shape.Reset(points, points);
+        for (int i = 0; i < points; i++) {
+            shape.AddPoint(Geom::Point(coord(rng), coord(rng)));
+        }
+        for (int i = 0; i < points; i++) {
+            shape.AddEdge(i, (i + 1) % points);
+        }
+    };
+
+    int edges = 0;
+    auto const report = [&](char const *name, std::function<void(Shape &)> const &make) {
+        auto const time = best_of(make, edges);
+        std::cout << name << time << " ms, " << edges << " edges out" << std::endl;
+    };
+
+    report("overlapping:        ", overlapping);
+    report("disjoint:           ", disjoint);
+    std::cout << "tangle of " << points << " points:" << std::endl;
+    report("  self-intersecting:", tangle);
+
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Benchmark of Inkscape::MeshRaster, the rasterizer of mesh gradients
+ *
+ * Build with "make mesh-benchmark" (it is not built by default), then run
+ *
+ *     mesh-benchmark [patches per side [size in pixels [tile size]]]
+ *
+ * It draws a mesh of curved patches with random colours, as a whole and then in tiles as the
+ * canvas does, first making the subdivisions and then with them made, and at a zoom of 32 with
+ * 1920x1080 pixels of the middle of the mesh in view. Times are in milliseconds, the best of a few
+ * runs.
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <cairo.h>
+#include <2geom/transforms.h>
+
+#include "display/mesh-rasterizer.h"
+
+using namespace Inkscape;
+
+namespace {
+
+constexpr int RUNS = 5;
+
+/// Best time taken by @a f over a few runs, in milliseconds.
+double best_of(std::function<void()> const &f)
+{
+    double best = 1e300;
+    for (int run = 0; run < RUNS; run++) {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        auto const end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+/// A mesh of @a n x @a n patches over @a size x @a size pixels, whose inner corners are moved at random.
+std::vector<MeshPatch> make_mesh(int n, double size)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+    std::uniform_real_distribution<float> channel(0, 1);
+
+    double const step = size / n;
+    std::vector<std::vector<Geom::Point>> corners(n + 1, std::vector<Geom::Point>(n + 1));
+    for (int i = 0; i <= n; i++) {
+        for (int j = 0; j <= n; j++) {
+            bool const edge = i == 0 || j == 0 || i == n || j == n;
+            corners[i][j] = Geom::Point(j + (edge ? 0 : jitter(rng)), i + (edge ? 0 : jitter(rng))) * step;
+        }
+    }
+
+    // Sides bulge sideways by an amount depending on where they are, so that shared sides match.
+    auto const bulge = [&](Geom::Point const &a, Geom::Point const &b) {
+        auto const mid = (a + b) / 2;
+        return Geom::rot90(b - a) * 0.2 * std::sin(mid.x() * 0.01 + mid.y() * 0.02);
+    };
+
+    std::vector<MeshPatch> patches;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            Geom::Point const c[4] = {corners[i][j], corners[i][j + 1], corners[i + 1][j + 1], corners[i + 1][j]};
+            MeshPatch patch;
+            for (int k = 0; k < 4; k++) {
+                auto const &start = c[k];
+                auto const &end = c[(k + 1) % 4];
+                auto const offset = k < 2 ? bulge(start, end) : bulge(end, start);
+                patch.side_point(3 * k) = start;
+                patch.side_point(3 * k + 1) = (2 * start + end) / 3 + offset;
+                patch.side_point(3 * k + 2) = (start + 2 * end) / 3 + offset;
+            }
+            for (int k = 0; k < 4; k++) {
+                patch.set_default_control_point(k);
+                patch.colors[k] = {channel(rng), channel(rng), channel(rng), 1.0f};
+            }
+            patches.push_back(patch);
+        }
+    }
+    return patches;
+}
+
+void draw_tiles(MeshRaster const &mesh, Geom::IntRect const &area, int tile_size)
+{
+    for (int y = area.top(); y < area.bottom(); y += tile_size) {
+        for (int x = area.left(); x < area.right(); x += tile_size) {
+            auto const tile = Geom::IntRect(x, y, x + tile_size, y + tile_size) & area;
+            cairo_surface_destroy(mesh.rasterize(*tile));
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int const n = argc > 1 ? std::atoi(argv[1]) : 100;
+    int const size = argc > 2 ? std::atoi(argv[2]) : 2000;
+    int const tile_size = argc > 3 ? std::atoi(argv[3]) : 256;
+    if (n <= 0 || size <= 0 || tile_size <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [patches per side [size in pixels [tile size]]]" << std::endl;
+        return 1;
+    }
+
+    auto const patches = make_mesh(n, size);
+    std::cout << n << "x" << n << " patches over " << size << "x" << size << " pixels, tiles of " << tile_size
+              << std::endl << std::fixed << std::setprecision(1);
+
+    std::unique_ptr<MeshRaster> mesh;
+    auto const cold = [&](std::function<void(MeshRaster const &)> const &draw) {
+        return best_of([&] {
+            mesh = std::make_unique<MeshRaster>(patches, n); // Drops the subdivisions of the previous one.
+            draw(*mesh);
+        });
+    };
+    auto const warm = [&](std::function<void(MeshRaster const &)> const &draw) {
+        return best_of([&] { draw(*mesh); });
+    };
+
+    auto const whole = [](MeshRaster const &mesh) { cairo_surface_destroy(mesh.rasterize(*mesh.bounds())); };
+    auto const tiles = [&](MeshRaster const &mesh) { draw_tiles(mesh, *mesh.bounds(), tile_size); };
+
+    std::cout << "whole, subdividing:   " << cold(whole) << " ms" << std::endl;
+    std::cout << "whole, subdivided:    " << warm(whole) << " ms" << std::endl;
+    std::cout << "tiles, subdividing:   " << cold(tiles) << " ms" << std::endl;
+    std::cout << "tiles, subdivided:    " << warm(tiles) << " ms" << std::endl;
+
+    // Zoomed in, with a screenful of the middle of the mesh in view.
+    constexpr double ZOOM = 32;
+    auto zoomed = patches;
+    for (auto &patch : zoomed) {
+        patch *= Geom::Scale(ZOOM);
+    }
+    int const middle = size * ZOOM / 2;
+    auto const view = Geom::IntRect(middle, middle, middle + 1920, middle + 1080);
+    auto const zoomed_tiles = [&](MeshRaster const &mesh) { draw_tiles(mesh, view, tile_size); };
+    auto const zoomed_cold = best_of([&] {
+        mesh = std::make_unique<MeshRaster>(zoomed, n);
+        zoomed_tiles(*mesh);
+    });
+    std::cout << "zoomed, subdividing:  " << zoomed_cold << " ms" << std::endl;
+    std::cout << "zoomed, subdivided:   " << warm(zoomed_tiles) << " ms" << std::endl;
+
+    return 0;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
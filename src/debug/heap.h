@@ -26,12 +26,15 @@ public:
     struct Stats {
         std::size_t size;
         std::size_t bytes_used;
+        unsigned long hits = 0;   ///< Lookups answered from a cache; see HITS_AVAILABLE.
+        unsigned long misses = 0;
     };
 
     enum {
         SIZE_AVAILABLE    = ( 1 << 0 ),
         USED_AVAILABLE    = ( 1 << 1 ),
-        GARBAGE_COLLECTED = ( 1 << 2 )
+        GARBAGE_COLLECTED = ( 1 << 2 ),
+        HITS_AVAILABLE    = ( 1 << 3 )
     };
 
     virtual int features() const=0;
@@ -21,6 +21,7 @@ static const int POOL_THRESHOLD = 2048;
 #include <algorithm>
 #include <cairo.h>
 #include <cmath>
+#include <concepts>
 
 #include "display/cairo-utils.h"
 #include "display/dispatch-pool.h"
@@ -57,6 +58,25 @@ struct surface_accessor {
     }
 };
 
+/*
+ * Blend and filter functors may, in addition to their per-pixel operator(), provide an overload
+ * that processes a whole row of ARGB32 pixels. It is used whenever all the surfaces involved are
+ * ARGB32, and must give exactly the same result as calling the per-pixel operator on each pixel.
+ * See display/nr-filter-kernels.h for the vectorized implementations.
+ */
+
+/// Blend functor with a row overload: blend(in1, in2, out, width).
+template <typename Blend>
+concept SpanBlend = requires(Blend &blend, guint32 const *in1, guint32 const *in2, guint32 *out, int n) {
+    blend(in1, in2, out, n);
+};
+
+/// Filter functor with a row overload: filter(in, out, width).
+template <typename Filter>
+concept SpanFilter = requires(Filter &filter, guint32 const *in, guint32 *out, int n) {
+    filter(in, out, n);
+};
+
 template <typename AccOut, typename Acc1, typename Acc2, typename Blend>
 void ink_cairo_surface_blend_internal(cairo_surface_t *out, cairo_surface_t *in1, cairo_surface_t *in2, int w, int h, Blend &blend)
 {
@@ -64,13 +84,16 @@ void ink_cairo_surface_blend_internal(cairo_surface_t *out, cairo_surface_t *in1
     surface_accessor<Acc1> acc_in1(in1);
     surface_accessor<Acc2> acc_in2(in2);
 
-    // NOTE
-    // This probably doesn't help much here.
-    // It would be better to render more than 1 tile at a time.
+    // Rows are split between threads, and handed whole to a span overload if there is one.
     auto const pool = get_global_dispatch_pool();
     pool->dispatch_threshold(h, (w * h) > POOL_THRESHOLD, [&](int i, int) {
-        for (int j = 0; j < w; ++j) {
-            acc_out.set(j, i, blend(acc_in1.get(j, i), acc_in2.get(j, i)));
+        if constexpr (SpanBlend<Blend> && sizeof(AccOut) == 4 && sizeof(Acc1) == 4 && sizeof(Acc2) == 4) {
+            blend(acc_in1.data + i * acc_in1.stride, acc_in2.data + i * acc_in2.stride,
+                  acc_out.data + i * acc_out.stride, w);
+        } else {
+            for (int j = 0; j < w; ++j) {
+                acc_out.set(j, i, blend(acc_in1.get(j, i), acc_in2.get(j, i)));
+            }
         }
     });
 }
@@ -81,13 +104,15 @@ void ink_cairo_surface_filter_internal(cairo_surface_t *out, cairo_surface_t *in
     surface_accessor<AccOut> acc_out(out);
     surface_accessor<AccIn> acc_in(in);
 
-    // NOTE
-    // This probably doesn't help much here.
-    // It would be better to render more than 1 tile at a time.
+    // Rows are split between threads, and handed whole to a span overload if there is one.
     auto const pool = get_global_dispatch_pool();
     pool->dispatch_threshold(h, (w * h) > POOL_THRESHOLD, [&](int i, int) {
-        for (int j = 0; j < w; ++j) {
-            acc_out.set(j, i, filter(acc_in.get(j, i)));
+        if constexpr (SpanFilter<Filter> && sizeof(AccOut) == 4 && sizeof(AccIn) == 4) {
+            filter(acc_in.data + i * acc_in.stride, acc_out.data + i * acc_out.stride, w);
+        } else {
+            for (int j = 0; j < w; ++j) {
+                acc_out.set(j, i, filter(acc_in.get(j, i)));
+            }
         }
     });
 }
@@ -97,9 +122,7 @@ void ink_cairo_surface_synthesize_internal(cairo_surface_t *out, int x0, int y0,
 {
     surface_accessor<AccOut> acc_out(out);
 
-    // NOTE
-    // This probably doesn't help much here.
-    // It would be better to render more than 1 tile at a time.
+    // Rows are split between threads.
     int const limit = (x1 - x0) * (y1 - y0);
     auto const pool = get_global_dispatch_pool();
     pool->dispatch_threshold(y1 - y0, limit > POOL_THRESHOLD, [&](int y, int) {
@@ -7,108 +7,108 @@
 
 #include "dispatch-pool.h"
 
-namespace Inkscape {
-
-dispatch_pool::dispatch_pool(int size)
-{
-    int const num_threads = std::max(size, 1) - 1;
-
-    _threads.reserve(num_threads);
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 
-    for (int i = 0; i < num_threads; ++i) {
-        // local_id of created threads is offset by 1 to allow calling thread to always be 0
-        _threads.emplace_back([i, this] { thread_func(local_id{i + 1}); });
-    }
-}
-
-dispatch_pool::~dispatch_pool()
-{
-    // TODO C++20: this would be completely trivial with jthread
-    // TODO C++20: dispatch_pool::~dispatch_pool() = default;
-    {
-        std::scoped_lock lk(_lock);
-        _shutdown = true;
-    }
+namespace Inkscape {
 
-    _available_cv.notify_all();
+namespace {
 
-    for (auto &thread : _threads) {
-        thread.join();
-    }
-}
+// Number of chunks per participating thread a dispatch is split into, for load balancing.
+constexpr int CHUNKS_PER_THREAD = 4;
 
-void dispatch_pool::dispatch(int count, dispatch_func function)
+struct dispatch_state
 {
-    std::scoped_lock lk(_dispatch_lock);
-    std::unique_lock lk2(_lock);
-
-    _available_work = global_id{};
-    _completed_work = global_id{};
-    _target_work = global_id{count};
-    _function = std::move(function);
-
-    // Execute the caller's batch, and signal to the next waiting thread
-    execute_batch(lk2, local_id{}, size());
+    dispatch_pool::dispatch_func function;
+    int count;
+    int chunk_size;
 
-    // Wait for other threads to finish
-    _completed_cv.wait(lk2, [&] { return _completed_work == _target_work; });
+    std::atomic<int> next{};
+    std::atomic<int> completed{};
+    std::atomic<int> participants{};
 
-    // Release any extra memory held by the function
-    _function = {};
-}
+    std::mutex lock;
+    std::condition_variable completed_cv;
+    std::exception_ptr error;
+};
 
-void dispatch_pool::thread_func(local_id id)
+// Claim and execute chunks of the dispatch until none are left.
+void participate(dispatch_state &state, dispatch_pool::local_id id)
 {
-    int const thread_count = size();
-
-    std::unique_lock lk(_lock);
-
-    // TODO C++20: no need for _shutdown member once stop_token is available
-    // TODO C++20: while (_cv.wait(lk, stop_token, [&] { ... }))
     while (true) {
-        _available_cv.wait(lk, [&] { return _shutdown || _available_work < _target_work; });
-
-        if (_shutdown) {
-            // When shutdown is requested, stop immediately
+        int const start = state.next.fetch_add(state.chunk_size, std::memory_order_relaxed);
+        if (start >= state.count) {
             return;
         }
+        int const end = std::min(start + state.chunk_size, state.count);
+
+        try {
+            for (auto index = start; index < end; index++) {
+                state.function(index, id);
+            }
+        } catch (...) {
+            std::scoped_lock lk(state.lock);
+            if (!state.error) {
+                state.error = std::current_exception();
+            }
+        }
 
-        // Otherwise, execute the batch
-        execute_batch(lk, id, thread_count);
+        if (state.completed.fetch_add(end - start, std::memory_order_acq_rel) + (end - start) == state.count) {
+            std::scoped_lock lk(state.lock);
+            state.completed_cv.notify_all();
+        }
     }
 }
 
-void dispatch_pool::execute_batch(std::unique_lock<std::mutex> &lk, local_id id, int thread_count)
+} // namespace
+
+dispatch_pool::dispatch_pool(std::shared_ptr<task_scheduler> scheduler)
+    : _scheduler(std::move(scheduler))
 {
-    // Determine how much work to take
-    global_id const batch_size = (_target_work + thread_count - 1) / thread_count;
-    global_id const start = _available_work;
-    global_id const end = std::min(start + batch_size, _target_work);
+}
 
-    // Take that much work
-    _available_work = end;
+void dispatch_pool::dispatch(int count, dispatch_func function)
+{
+    if (count <= 0) {
+        return;
+    }
 
-    // Unlock and begin executing the function
-    {
-        lk.unlock();
+    int const threads = size();
+    auto const state = std::make_shared<dispatch_state>();
+    state->function = std::move(function);
+    state->count = count;
+    state->chunk_size = std::max(count / (threads * CHUNKS_PER_THREAD), 1);
+
+    // Invite the other workers to join in. Helpers which only get to run after all chunks were
+    // claimed return immediately; they keep the state alive on their own.
+    int const chunks = (count + state->chunk_size - 1) / state->chunk_size;
+    int const helpers = std::min(chunks, threads) - 1;
+    for (int i = 0; i < helpers; i++) {
+        _scheduler->post_job([state] {
+            participate(*state, local_id{state->participants.fetch_add(1, std::memory_order_relaxed) + 1});
+        });
+    }
 
-        // Now that the lock is released, potentially signal work availability
-        // to the next waiting thread
-        _available_cv.notify_one();
+    // Execute the caller's share
+    participate(*state, local_id{});
 
-        // Execute the function
-        for (global_id index = start; index < end; index++) {
-            _function(index, id);
+    // Wait for other threads to finish, running other queued jobs in the meantime
+    auto const done = [&] { return state->completed.load(std::memory_order_acquire) == count; };
+    while (!done()) {
+        if (!_scheduler->run_pending_job()) {
+            std::unique_lock lk(state->lock);
+            state->completed_cv.wait(lk, done);
         }
-
-        lk.lock();
     }
 
-    // Signal completion
-    _completed_work += (end - start);
+    // Release any extra memory held by the function
+    state->function = {};
 
-    if (_completed_work == _target_work) {
-        _completed_cv.notify_one();
+    if (state->error) {
+        std::rethrow_exception(state->error);
     }
 }
 
@@ -8,11 +8,10 @@
 #ifndef INKSCAPE_DISPLAY_DISPATCH_POOL_H
 #define INKSCAPE_DISPLAY_DISPATCH_POOL_H
 
-#include <condition_variable>
 #include <functional>
-#include <mutex>
-#include <thread>
-#include <vector>
+#include <memory>
+
+#include "display/task-scheduler.h"
 
 namespace Inkscape {
 
@@ -40,22 +39,27 @@ namespace Inkscape {
  *         do_work(i);
  *     });
  *
- * Unlike boost's asio::thread_pool, which pushes work for threads onto a queue, this class only
- * supports operation via a counter. The simpler design allows dispatching a very large amount of
- * work (potentially millions of jobs, for every pixel in a megapixel image) with constant
- * memory and space used.
+ * Unlike posting individual tasks, a dispatch is described by a counter only. This allows
+ * dispatching a very large amount of work (potentially millions of jobs, for every pixel in a
+ * megapixel image) with constant memory and space used. The counter range is split into chunks
+ * which the participating threads claim one after the other, so uneven jobs balance out.
+ *
+ * A dispatch_pool is a thin layer over a task_scheduler, whose workers it shares with all other
+ * parallel work in the process. Any number of dispatches may run at the same time, and a
+ * dispatch may be issued from within a job of another dispatch (for example by a filter primitive
+ * that is itself being rendered as one of several tiles in parallel). The calling thread always
+ * participates, and while it waits for the other participants it runs other queued jobs.
  *
- * A pool's thread count is fixed upon construction and cannot change during operation. If you
- * allocate work buffers for each thread in the pool, you can use the size() method to determine
- * how many threads it has been created with.
+ * If you allocate work buffers for each thread in the pool, you can use the size() method to
+ * determine how many threads may participate in a single dispatch.
  *
- * By design, only one dispatch may run at a time. It is safe to call dispatch() from multiple
- * threads without extra locking.
+ * If a job throws, the first exception is rethrown from dispatch() once all jobs have run.
  *
  * Terminology used is designed to loosely follow that of OpenCL kernels or GL/VK compute shaders:
  * - Global ID within a dispatch refers to the 0-based counter value for a given job.
- * - Local ID within a dispatch refers to the 0-based index of thread which is processing the job.
- *   This will always be less than the pool's size().
+ * - Local ID within a dispatch refers to the 0-based index of the thread which processes the job.
+ *   This will always be less than the pool's size(), and is unique among the threads taking
+ *   part in the same dispatch.
  *
  * The first parameter to the callback is global ID. The second parameter, which is unused in the
  * example, is the local ID. The local ID is primarily useful if a work buffer is allocated for
@@ -68,8 +72,7 @@ public:
     using local_id = int;
     using dispatch_func = std::function<void(global_id, local_id)>;
 
-    explicit dispatch_pool(int size);
-    ~dispatch_pool();
+    explicit dispatch_pool(std::shared_ptr<task_scheduler> scheduler);
 
     void dispatch(int count, dispatch_func function);
 
@@ -87,26 +90,14 @@ public:
 
     int size() const
     {
-        // The calling thread participates in the dispatch
-        return _threads.size() + 1;
+        // The calling thread participates in the dispatch, in place of a worker if it is not one
+        return _scheduler->size();
     }
 
-private:
-    void thread_func(local_id id);
-    void execute_batch(std::unique_lock<std::mutex> &lk, local_id id, int thread_count);
+    std::shared_ptr<task_scheduler> const &scheduler() const { return _scheduler; }
 
 private:
-    global_id _available_work{};
-    global_id _completed_work{};
-    global_id _target_work{};
-    bool _shutdown{};
-
-    std::mutex _dispatch_lock;
-    std::mutex _lock;
-    std::condition_variable _available_cv;
-    std::condition_variable _completed_cv;
-    dispatch_func _function;
-    std::vector<std::thread> _threads;
+    std::shared_ptr<task_scheduler> _scheduler;
 };
 
 } // namespace Inkscape
@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
 #include <2geom/bezier-curve.h>
 
 #include "drawing.h"
@@ -17,6 +19,7 @@
 #include "drawing-image.h"
 #include "cairo-utils.h"
 #include "cairo-templates.h"
+#include "image-pyramid.h"
 
 namespace Inkscape {
 
@@ -101,7 +104,7 @@ unsigned DrawingImage::_updateItem(Geom::IntRect const &, UpdateContext const &,
     return STATE_ALL;
 }
 
-unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &/*area*/, unsigned flags, DrawingItem const */*stop_at*/) const
+unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const */*stop_at*/) const
 {
     bool const outline = (flags & RENDER_OUTLINE) && !_drawing.imageOutlineMode();
 
@@ -116,10 +119,36 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
 
         dc.translate(_origin);
         dc.scale(_scale);
-        // const_cast required since Cairo needs to modify the internal refcount variable, but we do not want to give up the
-        // benefits of const for the rest of our code. The underlying object is guaranteed to be non-const, so this is well-defined.
-        // It is also thread-safe to modify the refcount in this way, since Cairo uses atomics internally.
-        dc.setSource(const_cast<cairo_surface_t*>(_pixbuf->getSurfaceRaw()), 0, 0);
+
+        bool const smooth = style_image_rendering == SP_CSS_IMAGE_RENDERING_AUTO ||
+                            style_image_rendering == SP_CSS_IMAGE_RENDERING_OPTIMIZEQUALITY;
+        int level = 0;
+        if (smooth && _pixbuf->pixelFormat() == Inkscape::Pixbuf::PF_CAIRO) {
+            auto const image2device = _scale * _ctm * Geom::Scale(dc.surface()->device_scale());
+            level = ImagePyramid::level_for(*_pixbuf, std::max(image2device.expansionX(), image2device.expansionY()));
+        }
+
+        if (level > 0) {
+            // Zoomed out; draw the part in view from a reduced copy of the image.
+            auto const size = ImagePyramid::level_size(*_pixbuf, level);
+            auto const image2level = Geom::Scale((double)size.x() / _pixbuf->width(), (double)size.y() / _pixbuf->height());
+            auto const in_view = Geom::Rect(area) * (_scale * Geom::Translate(_origin) * _ctm).inverse() * image2level;
+            // Leave room for the filter, and keep at least one pixel to pad with.
+            int const x0 = std::clamp((int)std::floor(in_view.left()) - 2, 0, size.x() - 1);
+            int const y0 = std::clamp((int)std::floor(in_view.top()) - 2, 0, size.y() - 1);
+            int const x1 = std::clamp((int)std::ceil(in_view.right()) + 2, x0 + 1, size.x());
+            int const y1 = std::clamp((int)std::ceil(in_view.bottom()) + 2, y0 + 1, size.y());
+
+            auto const surface = ImagePyramid::get().get_area(_pixbuf, level, Geom::IntRect(x0, y0, x1, y1));
+            dc.scale(image2level.inverse());
+            dc.setSource(surface, x0, y0);
+            cairo_surface_destroy(surface);
+        } else {
+            // const_cast required since Cairo needs to modify the internal refcount variable, but we do not want to give up the
+            // benefits of const for the rest of our code. The underlying object is guaranteed to be non-const, so this is well-defined.
+            // It is also thread-safe to modify the refcount in this way, since Cairo uses atomics internally.
+            dc.setSource(const_cast<cairo_surface_t*>(_pixbuf->getSurfaceRaw()), 0, 0);
+        }
         dc.patternSetExtend(CAIRO_EXTEND_PAD);
 
         // See: http://www.w3.org/TR/SVG/painting.html#ImageRenderingProperty
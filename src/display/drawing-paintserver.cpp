@@ -1,13 +1,54 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #include "drawing-paintserver.h"
 
+#include <cmath>
 #include <utility>
+#include <2geom/transforms.h>
 
 #include "cairo-utils.h"
 #include "colors/color.h"
+#include "mesh-rasterizer.h"
 
 namespace Inkscape {
 
+namespace {
+
+/// Convert a patch of a mesh gradient, following the calls made to Cairo for it.
+MeshPatch make_mesh_patch(DrawingMeshGradient::PatchData const &data, double opacity)
+{
+    MeshPatch patch;
+
+    auto current = data.points[0][0];
+    patch.side_point(0) = current;
+    for (int k = 0; k < 4; k++) {
+        auto const end = data.points[k][3];
+        if (data.pathtype[k] == 'c' || data.pathtype[k] == 'C') {
+            patch.side_point(3 * k + 1) = data.points[k][1];
+            patch.side_point(3 * k + 2) = data.points[k][2];
+        } else {
+            patch.side_point(3 * k + 1) = (2 * current + end) / 3;
+            patch.side_point(3 * k + 2) = (current + 2 * end) / 3;
+        }
+        if (k < 3) {
+            patch.side_point(3 * k + 3) = end; // The last side ends at corner 0, whatever it says.
+        }
+        current = end;
+    }
+
+    for (int k = 0; k < 4; k++) {
+        if (data.tensorIsSet[k]) {
+            patch.control_point(k) = data.tensorpoints[k];
+        } else {
+            patch.set_default_control_point(k);
+        }
+        patch.colors[k] = {data.color[k][0], data.color[k][1], data.color[k][2], (float)(data.opacity[k] * opacity)};
+    }
+
+    return patch;
+}
+
+} // namespace
+
 DrawingPaintServer::~DrawingPaintServer() = default;
 
 DrawingSolidColor::DrawingSolidColor(Colors::Color color)
@@ -116,12 +157,25 @@ cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRec
     return pat;
 }
 
-cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity) const
+cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const
 {
 #ifdef MESH_DEBUG
     std::cout << "sp_meshgradient_create_pattern: " << bbox << " " << opacity << std::endl;
 #endif
 
+    Geom::Affine gs2user = transform;
+    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
+        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
+        gs2user *= bbox2user;
+    }
+
+    // Keep the mesh when drawing to vector surfaces, as when exporting to PDF.
+    if (cairo_surface_get_type(cairo_get_target(ct)) == CAIRO_SURFACE_TYPE_IMAGE) {
+        if (auto pat = create_raster_pattern(ct, gs2user, opacity)) {
+            return pat;
+        }
+    }
+
     auto pat = cairo_pattern_create_mesh();
 
     for (int i = 0; i < rows; i++) {
@@ -167,16 +221,73 @@ cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect co
     }
 
     // set pattern transform matrix
-    Geom::Affine gs2user = transform;
-    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
-        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
-        gs2user *= bbox2user;
-    }
     ink_cairo_pattern_set_matrix(pat, gs2user.inverse());
 
     return pat;
 }
 
+/**
+ * Draw the mesh with our own rasterizer, for painting on image surfaces at the scale of @a ct.
+ *
+ * Cairo would subdivide every patch again for each tile it is painted on. Instead, the patches
+ * are subdivided once for each transform to device pixels, and only the part being painted is
+ * drawn, as an image. The subdivision is kept while the transform changes by whole pixels only.
+ *
+ * @return The pattern, or nullptr if the mesh should be left to Cairo.
+ */
+cairo_pattern_t *DrawingMeshGradient::create_raster_pattern(cairo_t *ct, Geom::Affine const &gs2user, double opacity) const
+{
+    cairo_matrix_t ctm;
+    cairo_get_matrix(ct, &ctm);
+    double scale_x, scale_y;
+    cairo_surface_get_device_scale(cairo_get_target(ct), &scale_x, &scale_y);
+    auto const user2device = ink_matrix_to_2geom(ctm) * Geom::Scale(scale_x, scale_y);
+
+    auto gs2raster = gs2user * user2device;
+    auto const raster2device = Geom::Translate(std::floor(gs2raster[4]), std::floor(gs2raster[5]));
+    gs2raster *= raster2device.inverse();
+
+    std::shared_ptr<MeshRaster const> mesh;
+    {
+        std::scoped_lock lock(raster_mutex);
+
+        if (!raster || raster->opacity != opacity || !Geom::are_near(raster->gs2raster, gs2raster, 1e-6)) {
+            std::vector<MeshPatch> patches;
+            patches.reserve(rows * cols);
+            for (int i = 0; i < rows; i++) {
+                for (int j = 0; j < cols; j++) {
+                    patches.push_back(make_mesh_patch(patchdata[i][j], opacity));
+                    patches.back() *= gs2raster;
+                }
+            }
+            raster = Raster{gs2raster, opacity, std::make_shared<MeshRaster const>(std::move(patches), cols)};
+        }
+
+        mesh = raster->mesh;
+        gs2raster = raster->gs2raster;
+    }
+
+    if (!mesh->bounds()) {
+        return nullptr;
+    }
+
+    // Only draw the part being painted.
+    double x0, y0, x1, y1;
+    cairo_clip_extents(ct, &x0, &y0, &x1, &y1);
+    auto const clip = Geom::Rect(x0, y0, x1, y1) * user2device * raster2device.inverse();
+    auto const area = *mesh->bounds() & clip.roundOutwards();
+    if (!area || area->hasZeroArea()) {
+        return cairo_pattern_create_rgba(0, 0, 0, 0);
+    }
+
+    auto const surface = mesh->rasterize(*area);
+    auto const pat = cairo_pattern_create_for_surface(surface);
+    cairo_surface_destroy(surface);
+    ink_cairo_pattern_set_matrix(pat, gs2user.inverse() * gs2raster * Geom::Translate(-area->min()));
+
+    return pat;
+}
+
 } // namespace Inkscape
 
 /*
@@ -12,6 +12,9 @@
  */
 
 #include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 #include <cairo.h>
 #include <2geom/rect.h>
@@ -26,6 +29,7 @@ namespace Inkscape {
 namespace Colors {
 class Color;
 }
+class MeshRaster;
 
 /**
  * A DrawingPaintServer is a lightweight copy of the resources needed to paint using a paint server.
@@ -162,12 +166,26 @@ public:
         , cols(cols)
         , patchdata(std::move(patchdata)) {}
 
-    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity) const override;
+    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const override;
+
+    bool uses_cairo_ctx() const override { return true; }
 
 private:
+    cairo_pattern_t *create_raster_pattern(cairo_t *ct, Geom::Affine const &gs2user, double opacity) const;
+
     int rows;
     int cols;
     std::vector<std::vector<PatchData>> patchdata;
+
+    /// The mesh in pixels, for the last transform and opacity it was drawn at by create_raster_pattern().
+    struct Raster
+    {
+        Geom::Affine gs2raster;
+        double opacity;
+        std::shared_ptr<MeshRaster const> mesh;
+    };
+    mutable std::mutex raster_mutex;
+    mutable std::optional<Raster> raster;
 };
 
 } // namespace Inkscape
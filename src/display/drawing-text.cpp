@@ -10,7 +10,11 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <2geom/pathvector.h>
+#include <2geom/transforms.h>
 
 #include "style.h"
 
@@ -19,6 +23,7 @@
 #include "drawing-surface.h"
 #include "drawing-text.h"
 #include "drawing.h"
+#include "glyph-atlas.h"
 
 #include "helper/geom.h"
 
@@ -463,6 +468,143 @@ void DrawingText::decorateItem(DrawingContext &dc, double phase_length, bool und
     }
 }
 
+namespace {
+
+/// Whether the interiors of any two of @a rects intersect.
+bool any_overlap(std::vector<Geom::Rect> &rects)
+{
+    std::sort(rects.begin(), rects.end(), [](auto const &a, auto const &b) { return a.left() < b.left(); });
+    std::vector<Geom::Rect const *> active; ///< Rects so far reaching right of the current one's left.
+    for (auto const &rect : rects) {
+        std::erase_if(active, [&](auto other) { return other->right() <= rect.left(); });
+        for (auto other : active) {
+            if (other->interiorIntersects(rect)) {
+                return true;
+            }
+        }
+        active.push_back(&rect);
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * Draw the glyphs by adding up their masks from the glyph atlas, and filling through the result.
+ * Return false, without drawing anything, if any glyph is too large, rotated or skewed, or an SVG
+ * glyph, if the device pixels are not aligned with user space, or if any two glyphs overlap, as
+ * the masks of overlapping glyphs add up to more than filling their outlines does.
+ */
+bool DrawingText::_renderGlyphMasks(DrawingContext &dc, Geom::IntRect const &area, CairoPatternUniqPtr const &fill) const
+{
+    auto const ct = dc.raw();
+
+    cairo_matrix_t base;
+    cairo_get_matrix(ct, &base);
+    if (base.xx != 1.0 || base.yy != 1.0 || base.xy != 0.0 || base.yx != 0.0 ||
+        base.x0 != std::round(base.x0) || base.y0 != std::round(base.y0))
+    {
+        return false;
+    }
+
+    double scale_x, scale_y;
+    cairo_surface_get_device_scale(dc.rawTarget(), &scale_x, &scale_y);
+    if (scale_x != scale_y || scale_x < 1.0 || scale_x != std::round(scale_x)) {
+        return false;
+    }
+    int const device_scale = scale_x;
+
+    for (auto &i : _children) {
+        auto g = cast<DrawingGlyphs>(&i);
+        if (!g) throw InvalidItemException();
+
+        auto const &m = g->_ctm;
+        if (m.isSingular()) {
+            continue;
+        }
+        if (g->pixbuf ||
+            std::abs(m[1]) + std::abs(m[2]) > 1e-6 * (std::abs(m[0]) + std::abs(m[3])) ||
+            std::max(std::abs(m[0]), std::abs(m[3])) * device_scale > GlyphAtlas::MAX_SCALE)
+        {
+            return false;
+        }
+    }
+
+    auto const antialias = cairo_get_antialias(ct);
+    auto &atlas = GlyphAtlas::get();
+
+    struct Placed
+    {
+        std::shared_ptr<GlyphAtlas::Mask const> mask;
+        int x, y; ///< Pixel containing the glyph origin.
+    };
+    std::vector<Placed> placed;
+    std::vector<Geom::Rect> inks;
+
+    for (auto &i : _children) {
+        auto g = cast<DrawingGlyphs>(&i);
+        if (g->_ctm.isSingular() || !g->pathvec) {
+            continue;
+        }
+
+        // Position of the glyph origin in the mask, split into whole and quarter pixels.
+        auto const origin = (g->_ctm.translation() - Geom::Point(area.left(), area.top())) * device_scale;
+        int x = std::floor(origin.x());
+        int y = std::floor(origin.y());
+        int phase_x = std::round((origin.x() - x) * GlyphAtlas::SUBPIXEL_STEPS);
+        int phase_y = std::round((origin.y() - y) * GlyphAtlas::SUBPIXEL_STEPS);
+        if (phase_x == GlyphAtlas::SUBPIXEL_STEPS) {
+            x++;
+            phase_x = 0;
+        }
+        if (phase_y == GlyphAtlas::SUBPIXEL_STEPS) {
+            y++;
+            phase_y = 0;
+        }
+
+        auto const scale = Geom::Point(g->_ctm[0], g->_ctm[3]) * device_scale;
+        auto mask = atlas.lookup(g->_font_data, g->_glyph, *g->pathvec, scale, phase_x, phase_y, antialias,
+                                 _nrstyle.data.fill_rule);
+        if (mask->ink) {
+            inks.push_back(*mask->ink * Geom::Translate(x, y));
+        }
+        placed.push_back({std::move(mask), x, y});
+    }
+
+    if (any_overlap(inks)) {
+        return false;
+    }
+
+    int const width = area.width() * device_scale;
+    int const height = area.height() * device_scale;
+    auto const surface = cairo_image_surface_create(CAIRO_FORMAT_A8, width, height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return false;
+    }
+    auto const data = cairo_image_surface_get_data(surface);
+    auto const stride = cairo_image_surface_get_stride(surface);
+
+    for (auto const &[mask, x, y] : placed) {
+        GlyphAtlas::composite(*mask, data, width, height, stride, x, y);
+    }
+
+    cairo_surface_mark_dirty(surface);
+    cairo_surface_set_device_scale(surface, device_scale, device_scale);
+
+    {
+        // The fill pattern is set up in item coordinates, as for paths.
+        Inkscape::DrawingContext::Save save(dc);
+        dc.transform(_ctm);
+        _nrstyle.applyFill(dc, fill);
+        cairo_set_matrix(ct, &base);
+        cairo_mask_surface(ct, surface, area.left(), area.top());
+    }
+
+    cairo_surface_destroy(surface);
+    return true;
+}
+
 unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const
 {
     auto visible = area & _bbox;
@@ -520,6 +662,11 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
         }
     }
 
+    // Small, upright text with only a fill is drawn from cached glyph masks.
+    if (has_fill && !has_stroke && !decorate && _renderGlyphMasks(dc, *visible, has_fill)) {
+        return RENDER_OK;
+    }
+
     if (has_fill || has_stroke || has_td_fill || has_td_stroke) {
 
         // Determine order for fill and stroke.
@@ -41,7 +41,7 @@ protected:
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
 
-    std::shared_ptr<void const> _font_data; // keeps alive pathvec, pathvec_ref, and pixbuf
+    std::shared_ptr<void const> _font_data; // keeps alive pixbuf
     int            _glyph;
     float          _width;          // These three are used to set up bounding box
     float          _asc;            //
@@ -50,8 +50,8 @@ protected:
     Geom::IntRect  _pick_bbox;
 
     double design_units;
-    Geom::PathVector const *pathvec; // pathvector of actual glyph
-    Geom::PathVector const *pathvec_ref; // pathvector of reference glyph 42
+    std::shared_ptr<Geom::PathVector const> pathvec; // pathvector of actual glyph
+    std::shared_ptr<Geom::PathVector const> pathvec_ref; // pathvector of reference glyph 42
     Inkscape::Pixbuf const *pixbuf; // pixbuf, if SVG font
 
     friend class DrawingText;
@@ -77,6 +77,7 @@ protected:
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
     bool _canClip() const override { return true; }
 
+    bool _renderGlyphMasks(DrawingContext &dc, Geom::IntRect const &area, CairoPatternUniqPtr const &fill) const;
     void decorateItem(DrawingContext &dc, double phase_length, bool under) const;
     void decorateStyle(DrawingContext &dc, double vextent, double xphase, Geom::Point const &p1, Geom::Point const &p2, double thickness) const;
     NRStyle _nrstyle;
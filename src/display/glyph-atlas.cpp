@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::GlyphAtlas - rasterized masks of glyphs rendered at small sizes
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "glyph-atlas.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <2geom/pathvector.h>
+
+#include "cairo-utils.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Least recently used masks are discarded above this size, shared equally between the shards.
+constexpr std::size_t MAX_BYTES = 8 << 20;
+
+// Scales are rounded to multiples of 1 / SCALE_STEPS.
+constexpr int SCALE_STEPS = 64;
+
+} // namespace
+
+GlyphAtlas &GlyphAtlas::get()
+{
+    static GlyphAtlas atlas;
+    return atlas;
+}
+
+std::size_t GlyphAtlas::KeyHash::operator()(Key const &key) const
+{
+    auto hash = std::hash<void const *>{}(key.font);
+    for (int x : {key.glyph, key.scale_x, key.scale_y, key.phase_x, key.phase_y, (int)key.antialias, (int)key.fill_rule}) {
+        hash = hash * 1128467 + x;
+    }
+    return hash;
+}
+
+std::shared_ptr<GlyphAtlas::Mask const> GlyphAtlas::lookup(std::shared_ptr<void const> const &font_data, int glyph,
+                                                           Geom::PathVector const &path, Geom::Point const &scale,
+                                                           int phase_x, int phase_y, cairo_antialias_t antialias,
+                                                           cairo_fill_rule_t fill_rule)
+{
+    auto const key = Key{font_data.get(), glyph,
+                         (int)std::round(scale.x() * SCALE_STEPS), (int)std::round(scale.y() * SCALE_STEPS),
+                         phase_x, phase_y, antialias, fill_rule};
+
+    auto &shard = _shards[KeyHash{}(key) % SHARDS];
+
+    {
+        std::scoped_lock lock(shard.mutex);
+        if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            return it->second->mask;
+        }
+    }
+
+    // Render without holding the lock, so that other threads can use the shard meanwhile.
+    auto mask = _render(path, key);
+
+    std::scoped_lock lock(shard.mutex);
+    if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+        return it->second->mask;
+    }
+    shard.lru.push_front({key, font_data, mask});
+    shard.entries.emplace(key, shard.lru.begin());
+    shard.bytes += sizeof(Entry) + mask->data.size();
+
+    while (shard.bytes > MAX_BYTES / SHARDS && shard.lru.size() > 1) {
+        auto const &entry = shard.lru.back();
+        shard.bytes -= sizeof(Entry) + entry.mask->data.size();
+        shard.entries.erase(entry.key);
+        shard.lru.pop_back();
+    }
+
+    return mask;
+}
+
+std::shared_ptr<GlyphAtlas::Mask const> GlyphAtlas::_render(Geom::PathVector const &path, Key const &key)
+{
+    auto mask = std::make_shared<Mask>();
+    mask->left = mask->top = mask->width = mask->height = 0;
+
+    auto const transform = Geom::Affine((double)key.scale_x / SCALE_STEPS, 0, 0, (double)key.scale_y / SCALE_STEPS,
+                                        (double)key.phase_x / SUBPIXEL_STEPS, (double)key.phase_y / SUBPIXEL_STEPS);
+    auto const bounds = Geom::bounds_exact(path * transform);
+    if (!bounds) {
+        return mask;
+    }
+    mask->ink = bounds;
+
+    // Leave a pixel of room for antialiasing.
+    mask->left = (int)std::floor(bounds->left()) - 1;
+    mask->top = (int)std::floor(bounds->top()) - 1;
+    mask->width = (int)std::ceil(bounds->right()) + 1 - mask->left;
+    mask->height = (int)std::ceil(bounds->bottom()) + 1 - mask->top;
+
+    auto const surface = cairo_image_surface_create(CAIRO_FORMAT_A8, mask->width, mask->height);
+    auto const ct = cairo_create(surface);
+    cairo_set_antialias(ct, key.antialias);
+    cairo_set_fill_rule(ct, key.fill_rule);
+    cairo_translate(ct, -mask->left, -mask->top);
+    auto const matrix = cairo_matrix_t{transform[0], transform[1], transform[2], transform[3], transform[4], transform[5]};
+    cairo_transform(ct, &matrix);
+    feed_pathvector_to_cairo(ct, path);
+    cairo_fill(ct);
+    cairo_destroy(ct);
+
+    cairo_surface_flush(surface);
+    auto const data = cairo_image_surface_get_data(surface);
+    auto const stride = cairo_image_surface_get_stride(surface);
+    mask->data.resize(mask->width * mask->height);
+    for (int y = 0; y < mask->height; y++) {
+        std::memcpy(mask->data.data() + y * mask->width, data + y * stride, mask->width);
+    }
+    cairo_surface_destroy(surface);
+
+    return mask;
+}
+
+void GlyphAtlas::composite(Mask const &mask, unsigned char *data, int width, int height, int stride, int x, int y)
+{
+    int const x0 = std::max(x + mask.left, 0);
+    int const y0 = std::max(y + mask.top, 0);
+    int const x1 = std::min(x + mask.left + mask.width, width);
+    int const y1 = std::min(y + mask.top + mask.height, height);
+
+    for (int j = y0; j < y1; j++) {
+        auto src = mask.data.data() + (j - y - mask.top) * mask.width + (x0 - x - mask.left);
+        auto dst = data + j * stride;
+        for (int i = x0; i < x1; i++, src++) {
+            dst[i] = std::min(dst[i] + *src, 255);
+        }
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::GlyphAtlas - rasterized masks of glyphs rendered at small sizes
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_GLYPH_ATLAS_H
+#define INKSCAPE_DISPLAY_GLYPH_ATLAS_H
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cairo.h>
+#include <2geom/pathvector.h>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+
+/**
+ * A cache of alpha masks of glyphs, shared by all drawings and render threads.
+ *
+ * Filling a glyph outline costs about the same at 8 pixels as at 800, most of it in setting up
+ * the path. Text that is small on screen, and not rotated or skewed, is therefore drawn by
+ * adding up cached masks of its glyphs instead. This is only the same as filling the outlines
+ * of all the glyphs at once if no two glyphs overlap, which callers check with Mask::ink.
+ *
+ * Masks are made for a glyph at a given scale, rounded to 1/64 of a pixel per em, and a given
+ * subpixel position, rounded to a quarter of a pixel in each direction. The least recently used
+ * masks are discarded first.
+ *
+ * Masks are spread over several shards by their key, each with its own lock, so that threads
+ * rendering text at the same time rarely wait for each other.
+ */
+class GlyphAtlas
+{
+public:
+    /// Largest glyph scale, in device pixels per em, that masks are made for.
+    static constexpr double MAX_SCALE = 32.0;
+    /// Number of subpixel positions per pixel in each direction.
+    static constexpr int SUBPIXEL_STEPS = 4;
+
+    struct Mask
+    {
+        int left, top; ///< Position of the mask relative to the pixel containing the glyph origin.
+        int width, height;
+        std::vector<unsigned char> data; ///< Rows of width bytes.
+        Geom::OptRect ink;               ///< Exact bounds of the glyph, relative to the same pixel.
+    };
+
+    static GlyphAtlas &get();
+
+    GlyphAtlas(GlyphAtlas const &) = delete;
+    GlyphAtlas &operator=(GlyphAtlas const &) = delete;
+
+    /**
+     * Get the mask of a glyph, making it if needed.
+     *
+     * @param font_data Identifies the font, and keeps @a path alive (FontInstance::share_data()).
+     * @param path The glyph outline, in ems.
+     * @param scale Device pixels per em, horizontally and vertically; may be negative.
+     * @param phase_x, phase_y Subpixel position of the glyph origin, in [0, SUBPIXEL_STEPS).
+     */
+    std::shared_ptr<Mask const> lookup(std::shared_ptr<void const> const &font_data, int glyph,
+                                       Geom::PathVector const &path, Geom::Point const &scale, int phase_x,
+                                       int phase_y, cairo_antialias_t antialias, cairo_fill_rule_t fill_rule);
+
+    /// Add @a mask, with the glyph origin in pixel (@a x, @a y), to an A8 buffer. This is exact
+    /// where the glyphs covering a pixel do not overlap.
+    static void composite(Mask const &mask, unsigned char *data, int width, int height, int stride, int x, int y);
+
+private:
+    GlyphAtlas() = default;
+
+    struct Key
+    {
+        void const *font;
+        int glyph;
+        int scale_x, scale_y; ///< In 1/64 pixels per em.
+        int phase_x, phase_y;
+        cairo_antialias_t antialias;
+        cairo_fill_rule_t fill_rule;
+
+        bool operator==(Key const &other) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<void const> font_data; ///< Keeps the font alive, so its address is not reused.
+        std::shared_ptr<Mask const> mask;
+    };
+    using LRU = std::list<Entry>;
+
+    struct Shard
+    {
+        std::mutex mutex;
+        LRU lru; ///< Most recently used first.
+        std::unordered_map<Key, LRU::iterator, KeyHash> entries;
+        std::size_t bytes = 0;
+    };
+
+    static constexpr int SHARDS = 16;
+
+    static std::shared_ptr<Mask const> _render(Geom::PathVector const &path, Key const &key);
+
+    std::array<Shard, SHARDS> _shards;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_GLYPH_ATLAS_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::ImagePyramid - reduced copies of bitmap images, for drawing them zoomed out
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "image-pyramid.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include "cairo-utils.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Least recently used tiles are discarded above this size.
+constexpr std::size_t MAX_BYTES = 64 << 20;
+
+// Levels stop at the first one of 1x1 pixels, or at this one.
+constexpr int MAX_LEVEL = 24;
+
+std::uint32_t average(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d)
+{
+    std::uint32_t result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        auto const sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+/**
+ * Halve an area of premultiplied ARGB32 pixels in size, averaging blocks of 2x2 pixels. An odd
+ * last row or column is averaged with itself.
+ *
+ * @param src_stride In bytes.
+ * @param dst_stride In pixels.
+ */
+void downsample(unsigned char const *src, int src_stride, int src_width, int src_height,
+                std::uint32_t *dst, int dst_stride)
+{
+    for (int y = 0; y < (src_height + 1) / 2; y++) {
+        auto const row0 = reinterpret_cast<std::uint32_t const *>(src + 2 * y * src_stride);
+        auto const row1 = reinterpret_cast<std::uint32_t const *>(src + std::min(2 * y + 1, src_height - 1) * src_stride);
+        auto const out = dst + y * dst_stride;
+        for (int x = 0; x < (src_width + 1) / 2; x++) {
+            int const x0 = 2 * x;
+            int const x1 = std::min(2 * x + 1, src_width - 1);
+            out[x] = average(row0[x0], row0[x1], row1[x0], row1[x1]);
+        }
+    }
+}
+
+} // namespace
+
+ImagePyramid &ImagePyramid::get()
+{
+    static ImagePyramid pyramid;
+    return pyramid;
+}
+
+std::size_t ImagePyramid::KeyHash::operator()(Key const &key) const
+{
+    auto hash = std::hash<void const *>{}(key.pixbuf);
+    for (int x : {key.level, key.x, key.y}) {
+        hash = hash * 1128467 + x;
+    }
+    return hash;
+}
+
+Geom::IntPoint ImagePyramid::level_size(Pixbuf const &pixbuf, int level)
+{
+    int width = pixbuf.width();
+    int height = pixbuf.height();
+    for (int i = 0; i < level; i++) {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+    return {width, height};
+}
+
+int ImagePyramid::level_for(Pixbuf const &pixbuf, double scale)
+{
+    int level = 0;
+    auto size = Geom::IntPoint(pixbuf.width(), pixbuf.height());
+    while (level < MAX_LEVEL && (size.x() > 1 || size.y() > 1) && scale * (2 << level) <= 1.0) {
+        level++;
+        size = Geom::IntPoint((size.x() + 1) / 2, (size.y() + 1) / 2);
+    }
+    return level;
+}
+
+cairo_surface_t *ImagePyramid::get_area(std::shared_ptr<Pixbuf const> const &pixbuf, int level, Geom::IntRect const &area)
+{
+    auto const surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, area.width(), area.height());
+    cairo_surface_flush(surface);
+    auto const data = cairo_image_surface_get_data(surface);
+    auto const stride = cairo_image_surface_get_stride(surface);
+
+    for (int ty = area.top() / TILE_SIZE; ty <= (area.bottom() - 1) / TILE_SIZE; ty++) {
+        for (int tx = area.left() / TILE_SIZE; tx <= (area.right() - 1) / TILE_SIZE; tx++) {
+            auto const tile = _get_tile(pixbuf, {pixbuf.get(), level, tx, ty});
+            auto const tile_rect = Geom::IntRect::from_xywh(tx * TILE_SIZE, ty * TILE_SIZE, tile->width, tile->height);
+            auto const part = tile_rect & area;
+            if (!part) {
+                continue;
+            }
+            for (int y = part->top(); y < part->bottom(); y++) {
+                std::memcpy(data + (y - area.top()) * stride + (part->left() - area.left()) * 4,
+                            tile->data.data() + (y - tile_rect.top()) * tile->width + (part->left() - tile_rect.left()),
+                            part->width() * 4);
+            }
+        }
+    }
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+/// Look up a tile that is kept, marking it as the most recently used.
+std::shared_ptr<ImagePyramid::Tile const> ImagePyramid::_find_tile(Key const &key)
+{
+    std::scoped_lock lock(_mutex);
+    auto it = _entries.find(key);
+    if (it == _entries.end()) {
+        return {};
+    }
+    if (it->second->pixbuf.expired()) {
+        // Left over from an image that was freed, whose address was then reused.
+        _bytes -= sizeof(Entry) + it->second->tile->data.size() * 4;
+        _lru.erase(it->second);
+        _entries.erase(it);
+        return {};
+    }
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return it->second->tile;
+}
+
+std::shared_ptr<ImagePyramid::Tile const> ImagePyramid::_get_tile(std::shared_ptr<Pixbuf const> const &pixbuf,
+                                                                  Key const &key)
+{
+    if (auto tile = _find_tile(key)) {
+        return tile;
+    }
+
+    // Make the tile without holding the lock, so that other threads can use the cache meanwhile.
+    auto const size = level_size(*pixbuf, key.level);
+    auto tile = std::make_shared<Tile>();
+    tile->width = std::min(TILE_SIZE, size.x() - key.x * TILE_SIZE);
+    tile->height = std::min(TILE_SIZE, size.y() - key.y * TILE_SIZE);
+    tile->data.resize(tile->width * tile->height);
+    _reduce(*pixbuf, key, tile->data.data(), tile->width);
+
+    std::scoped_lock lock(_mutex);
+    if (auto it = _entries.find(key); it != _entries.end()) {
+        return it->second->tile;
+    }
+    _lru.push_front({key, pixbuf, tile});
+    _entries.emplace(key, _lru.begin());
+    _bytes += sizeof(Entry) + tile->data.size() * 4;
+    _evict();
+
+    return tile;
+}
+
+/**
+ * Make the pixels of a tile into @a dst, whose rows are @a dst_stride pixels apart. Each quarter
+ * of the tile is made from one tile of the level above: the image itself, a tile that is kept, or
+ * else one made here and dropped.
+ */
+void ImagePyramid::_reduce(Pixbuf const &pixbuf, Key const &key, std::uint32_t *dst, int dst_stride)
+{
+    auto const src_size = level_size(pixbuf, key.level - 1);
+
+    std::vector<std::uint32_t> scratch;
+    for (int j = 0; j < 2; j++) {
+        for (int i = 0; i < 2; i++) {
+            int const src_x = (2 * key.x + i) * TILE_SIZE;
+            int const src_y = (2 * key.y + j) * TILE_SIZE;
+            if (src_x >= src_size.x() || src_y >= src_size.y()) {
+                continue;
+            }
+            int const src_width = std::min(TILE_SIZE, src_size.x() - src_x);
+            int const src_height = std::min(TILE_SIZE, src_size.y() - src_y);
+            auto const quarter = dst + j * TILE_SIZE / 2 * dst_stride + i * TILE_SIZE / 2;
+
+            if (key.level == 1) {
+                downsample(pixbuf.pixels() + src_y * pixbuf.rowstride() + src_x * 4, pixbuf.rowstride(),
+                           src_width, src_height, quarter, dst_stride);
+                continue;
+            }
+
+            auto const src_key = Key{key.pixbuf, key.level - 1, 2 * key.x + i, 2 * key.y + j};
+            if (auto const src = _find_tile(src_key)) {
+                downsample(reinterpret_cast<unsigned char const *>(src->data.data()), src->width * 4,
+                           src_width, src_height, quarter, dst_stride);
+            } else {
+                scratch.resize(src_width * src_height);
+                _reduce(pixbuf, src_key, scratch.data(), src_width);
+                downsample(reinterpret_cast<unsigned char const *>(scratch.data()), src_width * 4,
+                           src_width, src_height, quarter, dst_stride);
+            }
+        }
+    }
+}
+
+void ImagePyramid::_evict()
+{
+    while (_bytes > MAX_BYTES && _lru.size() > 1) {
+        auto const &entry = _lru.back();
+        _bytes -= sizeof(Entry) + entry.tile->data.size() * 4;
+        _entries.erase(entry.key);
+        _lru.pop_back();
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
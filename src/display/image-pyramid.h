@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::ImagePyramid - reduced copies of bitmap images, for drawing them zoomed out
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_IMAGE_PYRAMID_H
+#define INKSCAPE_DISPLAY_IMAGE_PYRAMID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cairo.h>
+#include <2geom/int-rect.h>
+
+namespace Inkscape {
+
+class Pixbuf;
+
+/**
+ * A cache of reduced copies of bitmap images, shared by all drawings and render threads.
+ *
+ * Drawing an image at a small fraction of its size still makes Cairo filter all of its pixels.
+ * Instead, such images are drawn from a copy halved in size as many times as the zoom allows,
+ * which is made from the copy one level up by averaging 2x2 blocks of pixels.
+ *
+ * The copies are split into square tiles, which are only made when they are first needed, so
+ * that a view of a small part of a large image does not reduce the rest of it. The least
+ * recently used tiles of all images are discarded first.
+ *
+ * Only the tiles that are drawn are kept. The tiles of the levels in between that a tile is made
+ * from are used if they are kept already, and otherwise made in passing and dropped, so that
+ * drawing a large image zoomed out does not fill the cache with tiles of its larger copies.
+ */
+class ImagePyramid
+{
+public:
+    /// Size of the tiles, in pixels of their level.
+    static constexpr int TILE_SIZE = 256;
+
+    static ImagePyramid &get();
+
+    ImagePyramid(ImagePyramid const &) = delete;
+    ImagePyramid &operator=(ImagePyramid const &) = delete;
+
+    /**
+     * The most reduced level whose pixels are not larger than device pixels, or 0 if the image
+     * should be drawn at full size.
+     *
+     * @param scale Device pixels per image pixel.
+     */
+    static int level_for(Pixbuf const &pixbuf, double scale);
+
+    /// The size in pixels of a level of @a pixbuf, level 0 being the image itself.
+    static Geom::IntPoint level_size(Pixbuf const &pixbuf, int level);
+
+    /**
+     * Get a part of a reduced level of an image, making the tiles it covers if needed.
+     *
+     * @param pixbuf An image in Cairo's pixel format.
+     * @param level A level greater than 0.
+     * @param area The part to get, in pixels of @a level; must be within the level.
+     * @return A new image surface of the size of @a area, owned by the caller.
+     */
+    cairo_surface_t *get_area(std::shared_ptr<Pixbuf const> const &pixbuf, int level, Geom::IntRect const &area);
+
+private:
+    ImagePyramid() = default;
+
+    struct Key
+    {
+        Pixbuf const *pixbuf;
+        int level;
+        int x, y; ///< Position of the tile, in tiles.
+
+        bool operator==(Key const &other) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Tile
+    {
+        int width, height;
+        std::vector<std::uint32_t> data; ///< Rows of width premultiplied ARGB32 pixels.
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::weak_ptr<Pixbuf const> pixbuf; ///< Tells whether the address in key was reused.
+        std::shared_ptr<Tile const> tile;
+    };
+    using LRU = std::list<Entry>;
+
+    std::shared_ptr<Tile const> _find_tile(Key const &key);
+    std::shared_ptr<Tile const> _get_tile(std::shared_ptr<Pixbuf const> const &pixbuf, Key const &key);
+    void _reduce(Pixbuf const &pixbuf, Key const &key, std::uint32_t *dst, int dst_stride);
+    void _evict();
+
+    std::mutex _mutex;
+    LRU _lru; ///< Most recently used first.
+    std::unordered_map<Key, LRU::iterator, KeyHash> _entries;
+    std::size_t _bytes = 0;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_IMAGE_PYRAMID_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,449 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Rasterization of mesh gradient patches, in parallel
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "mesh-rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "dispatch-pool.h"
+#include "threading.h"
+
+namespace Inkscape {
+
+struct MeshRaster::Vertex
+{
+    float x, y;
+    std::array<float, 4> color;
+};
+
+namespace {
+
+using Vertex = MeshRaster::Vertex;
+
+/// A quadrilateral of a subdivision, with vertices v, v + 1, v + stride and v + stride + 1, offset
+/// by (dx, dy) pixels.
+struct Quad
+{
+    Vertex const *v;
+    int stride;
+    int dx, dy;
+};
+
+// Patches are subdivided into quadrilaterals whose sides are about this long, in pixels.
+constexpr double SEGMENT_LENGTH = 3.0;
+
+// Patches are not subdivided more than this along either direction.
+constexpr int MAX_STEPS = 256;
+
+// Rows of pixels drawn by one job.
+constexpr int BAND_HEIGHT = 16;
+
+// Below this many pixels, or vertices, the work is done on the calling thread.
+constexpr int POOL_THRESHOLD = 16384;
+
+// Least recently used subdivisions are discarded above this size.
+constexpr std::size_t MAX_CACHE_BYTES = 64 << 20;
+
+// Position of the control points of the sides and interior of a patch, as in Cairo.
+constexpr int side_i[12] = {0, 0, 0, 0, 1, 2, 3, 3, 3, 3, 2, 1};
+constexpr int side_j[12] = {0, 1, 2, 3, 3, 3, 3, 2, 1, 0, 0, 0};
+constexpr int control_i[4] = {1, 1, 2, 2};
+constexpr int control_j[4] = {1, 2, 2, 1};
+
+void bernstein(double t, double b[4])
+{
+    double const s = 1.0 - t;
+    b[0] = s * s * s;
+    b[1] = 3 * t * s * s;
+    b[2] = 3 * t * t * s;
+    b[3] = t * t * t;
+}
+
+/// Number of steps along the first index of the control points, or the second if @a transposed.
+int steps_for(MeshPatch const &patch, bool transposed)
+{
+    double length = 0.0;
+    for (int j = 0; j < 4; j++) {
+        double l = 0.0;
+        for (int i = 0; i < 3; i++) {
+            auto const &p0 = transposed ? patch.points[j][i] : patch.points[i][j];
+            auto const &p1 = transposed ? patch.points[j][i + 1] : patch.points[i + 1][j];
+            l += Geom::distance(p0, p1);
+        }
+        length = std::max(length, l);
+    }
+    return std::clamp((int)std::ceil(length / SEGMENT_LENGTH), 1, MAX_STEPS);
+}
+
+/// Evaluate a patch at (steps_i + 1) x (steps_j + 1) points, into rows of steps_j + 1 vertices.
+void subdivide(MeshPatch const &patch, int steps_i, int steps_j, Geom::Point const &origin, Vertex *out)
+{
+    std::vector<double> bj((steps_j + 1) * 4);
+    for (int b = 0; b <= steps_j; b++) {
+        bernstein((double)b / steps_j, &bj[b * 4]);
+    }
+
+    for (int a = 0; a <= steps_i; a++) {
+        double const s = (double)a / steps_i;
+        double bi[4];
+        bernstein(s, bi);
+
+        // Collapse the first index, leaving a cubic curve along the second.
+        Geom::Point curve[4];
+        for (int j = 0; j < 4; j++) {
+            curve[j] = bi[0] * patch.points[0][j] + bi[1] * patch.points[1][j]
+                     + bi[2] * patch.points[2][j] + bi[3] * patch.points[3][j];
+        }
+
+        for (int b = 0; b <= steps_j; b++) {
+            double const t = (double)b / steps_j;
+            auto const w = &bj[b * 4];
+            auto const p = w[0] * curve[0] + w[1] * curve[1] + w[2] * curve[2] + w[3] * curve[3] - origin;
+
+            auto &v = out[a * (steps_j + 1) + b];
+            v.x = p.x();
+            v.y = p.y();
+            for (int k = 0; k < 4; k++) {
+                v.color[k] = (1 - s) * (1 - t) * patch.colors[0][k] + (1 - s) * t * patch.colors[1][k]
+                           + s * t * patch.colors[2][k] + s * (1 - t) * patch.colors[3][k];
+            }
+        }
+    }
+}
+
+std::uint32_t premultiply(std::array<float, 4> const &color)
+{
+    float const alpha = std::clamp(color[3], 0.0f, 1.0f);
+    auto const channel = [&](float c) {
+        return (std::uint32_t)(std::clamp(c, 0.0f, 1.0f) * alpha * 255 + 0.5f);
+    };
+    return (std::uint32_t)(alpha * 255 + 0.5f) << 24 | channel(color[0]) << 16 | channel(color[1]) << 8 | channel(color[2]);
+}
+
+/**
+ * Draw a triangle with colours interpolated between its vertices, over the pixels whose centres
+ * it covers within rows [y0, y1). Pixels on its sides are included, so that no gaps are left
+ * between neighbouring triangles.
+ *
+ * @param stride In pixels.
+ */
+void fill_triangle(Vertex const &a, Vertex const &b, Vertex const &c, int y0, int y1,
+                   std::uint32_t *data, int width, int stride)
+{
+    double const area = ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+    if (std::abs(area) < 1e-12) {
+        return;
+    }
+    double const inv_area = 1.0 / area;
+    constexpr double epsilon = -1e-7;
+
+    int const top = std::max(y0, (int)std::ceil(std::min({a.y, b.y, c.y}) - 0.5));
+    int const bottom = std::min(y1 - 1, (int)std::floor(std::max({a.y, b.y, c.y}) - 0.5));
+    int const left = std::max(0, (int)std::ceil(std::min({a.x, b.x, c.x}) - 0.5));
+    int const right = std::min(width - 1, (int)std::floor(std::max({a.x, b.x, c.x}) - 0.5));
+
+    for (int y = top; y <= bottom; y++) {
+        double const py = y + 0.5;
+        auto const row = data + y * stride;
+        for (int x = left; x <= right; x++) {
+            double const px = x + 0.5;
+            double const wa = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inv_area;
+            double const wb = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inv_area;
+            double const wc = 1.0 - wa - wb;
+            if (wa < epsilon || wb < epsilon || wc < epsilon) {
+                continue;
+            }
+            std::array<float, 4> color;
+            for (int k = 0; k < 4; k++) {
+                color[k] = wa * a.color[k] + wb * b.color[k] + wc * c.color[k];
+            }
+            row[x] = premultiply(color);
+        }
+    }
+}
+
+} // namespace
+
+Geom::Point &MeshPatch::side_point(int n)
+{
+    return points[side_i[n]][side_j[n]];
+}
+
+Geom::Point &MeshPatch::control_point(int corner)
+{
+    return points[control_i[corner]][control_j[corner]];
+}
+
+void MeshPatch::set_default_control_point(int corner)
+{
+    // Coons patch control point, computed from the sides as in Cairo's _calc_control_point().
+    int const ci = control_i[corner];
+    int const cj = control_j[corner];
+    auto const p = [&](int i, int j) -> Geom::Point & { return points[ci ^ i][cj ^ j]; };
+
+    p(0, 0) = (-4 * p(1, 1)
+               + 6 * (p(1, 0) + p(0, 1))
+               - 2 * (p(1, 2) + p(2, 1))
+               + 3 * (p(2, 0) + p(0, 2))
+               - 1 * p(2, 2)) / 9;
+}
+
+MeshPatch &MeshPatch::operator*=(Geom::Affine const &affine)
+{
+    for (auto &row : points) {
+        for (auto &point : row) {
+            point *= affine;
+        }
+    }
+    return *this;
+}
+
+/// The subdivisions of the patches of all meshes, least recently used first out.
+struct MeshRaster::Cache
+{
+    struct Key
+    {
+        MeshRaster const *mesh;
+        std::size_t patch;
+
+        bool operator==(Key const &other) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const
+        {
+            return std::hash<void const *>{}(key.mesh) * 1128467 + key.patch;
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<Subdivision const> subdivision;
+    };
+    using LRU = std::list<Entry>;
+
+    static Cache &get()
+    {
+        static Cache cache;
+        return cache;
+    }
+
+    std::shared_ptr<Subdivision const> find(Key const &key)
+    {
+        std::scoped_lock lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            return {};
+        }
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->subdivision;
+    }
+
+    /// Keep a subdivision, unless another thread made it meanwhile; return the one kept.
+    std::shared_ptr<Subdivision const> insert(Key const &key, std::shared_ptr<Subdivision const> subdivision)
+    {
+        std::scoped_lock lock(mutex);
+        if (auto it = entries.find(key); it != entries.end()) {
+            return it->second->subdivision;
+        }
+        lru.push_front({key, subdivision});
+        entries.emplace(key, lru.begin());
+        bytes += size(*subdivision);
+        while (bytes > MAX_CACHE_BYTES && lru.size() > 1) {
+            auto const &entry = lru.back();
+            bytes -= size(*entry.subdivision);
+            entries.erase(entry.key);
+            lru.pop_back();
+        }
+        return subdivision;
+    }
+
+    void forget(MeshRaster const *mesh)
+    {
+        std::scoped_lock lock(mutex);
+        for (auto it = lru.begin(); it != lru.end();) {
+            if (it->key.mesh == mesh) {
+                bytes -= size(*it->subdivision);
+                entries.erase(it->key);
+                it = lru.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    static std::size_t size(Subdivision const &subdivision)
+    {
+        return sizeof(Entry) + subdivision.size() * sizeof(Vertex);
+    }
+
+    std::mutex mutex;
+    LRU lru; ///< Most recently used first.
+    std::unordered_map<Key, LRU::iterator, KeyHash> entries;
+    std::size_t bytes = 0;
+};
+
+MeshRaster::MeshRaster(std::vector<MeshPatch> patches, int columns)
+    : _patches(std::move(patches))
+{
+    if (_patches.empty() || columns <= 0) {
+        return;
+    }
+
+    std::vector<Geom::OptIntRect> patch_bounds;
+    Geom::OptIntRect mesh_bounds;
+    for (auto const &patch : _patches) {
+        Geom::OptRect bounds;
+        for (auto const &row : patch.points) {
+            for (auto const &point : row) {
+                if (!point.isFinite()) {
+                    return;
+                }
+                bounds.unionWith(Geom::Rect(point, point));
+            }
+        }
+        patch_bounds.push_back(bounds.roundOutwards());
+        mesh_bounds.unionWith(patch_bounds.back());
+    }
+    _patch_bounds = std::move(patch_bounds);
+    _bounds = mesh_bounds;
+
+    // Subdivide the patches alike along each row and column, so that the vertices along the sides
+    // they share are the same.
+    int const rows = _patches.size() / columns;
+    std::vector<int> row_steps(rows, 1);
+    std::vector<int> column_steps(columns, 1);
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < columns; j++) {
+            auto const &patch = _patches[i * columns + j];
+            row_steps[i] = std::max(row_steps[i], steps_for(patch, false));
+            column_steps[j] = std::max(column_steps[j], steps_for(patch, true));
+        }
+    }
+    for (std::size_t n = 0; n < _patches.size(); n++) {
+        _steps.emplace_back(row_steps[n / columns], column_steps[n % columns]);
+    }
+}
+
+MeshRaster::~MeshRaster()
+{
+    Cache::get().forget(this);
+}
+
+cairo_surface_t *MeshRaster::rasterize(Geom::IntRect const &area) const
+{
+    auto const surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, area.width(), area.height());
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS || !_bounds || !_bounds->intersects(area)) {
+        return surface;
+    }
+    cairo_surface_flush(surface);
+    auto const data = reinterpret_cast<std::uint32_t *>(cairo_image_surface_get_data(surface));
+    int const stride = cairo_image_surface_get_stride(surface) / 4;
+    auto const pool = get_global_dispatch_pool();
+    auto &cache = Cache::get();
+
+    // Find the subdivisions of the patches in the area, and make those not kept.
+    std::vector<std::size_t> visible;
+    for (std::size_t n = 0; n < _patches.size(); n++) {
+        if (_patch_bounds[n]->intersects(area)) {
+            visible.push_back(n);
+        }
+    }
+
+    std::vector<std::shared_ptr<Subdivision const>> subdivisions(visible.size());
+    std::vector<std::size_t> missing;
+    std::size_t missing_vertices = 0;
+    for (std::size_t k = 0; k < visible.size(); k++) {
+        subdivisions[k] = cache.find({this, visible[k]});
+        if (!subdivisions[k]) {
+            missing.push_back(k);
+            missing_vertices += (_steps[visible[k]].x() + 1) * (_steps[visible[k]].y() + 1);
+        }
+    }
+
+    pool->dispatch_threshold(missing.size(), missing_vertices > POOL_THRESHOLD, [&](int i, int) {
+        auto const k = missing[i];
+        auto const n = visible[k];
+        auto const steps = _steps[n];
+        auto subdivision = std::make_shared<Subdivision>((steps.x() + 1) * (steps.y() + 1));
+        subdivide(_patches[n], steps.x(), steps.y(), Geom::Point(_bounds->min()), subdivision->data());
+        subdivisions[k] = std::move(subdivision);
+    });
+
+    for (auto k : missing) {
+        subdivisions[k] = cache.insert({this, visible[k]}, std::move(subdivisions[k]));
+    }
+
+    // Sort the quadrilaterals into the bands they cross, keeping them in drawing order.
+    int const band_count = (area.height() + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    std::vector<std::vector<Quad>> bands(band_count);
+    auto const offset = _bounds->min() - area.min();
+    for (std::size_t k = 0; k < visible.size(); k++) {
+        auto const n = visible[k];
+        int const stride_j = _steps[n].y() + 1;
+        for (int a = 0; a < _steps[n].x(); a++) {
+            for (int b = 0; b < _steps[n].y(); b++) {
+                auto const v = subdivisions[k]->data() + a * stride_j + b;
+                auto const xs = {v[0].x, v[1].x, v[stride_j].x, v[stride_j + 1].x};
+                auto const ys = {v[0].y, v[1].y, v[stride_j].y, v[stride_j + 1].y};
+                if (std::max(xs) + offset.x() < 0 || std::min(xs) + offset.x() > area.width()) {
+                    continue;
+                }
+                int const top = std::max(0, (int)std::ceil(std::min(ys) + offset.y() - 0.5));
+                int const bottom = std::min(area.height() - 1, (int)std::floor(std::max(ys) + offset.y() - 0.5));
+                for (int band = top / BAND_HEIGHT; band <= bottom / BAND_HEIGHT; band++) {
+                    bands[band].push_back({v, stride_j, offset.x(), offset.y()});
+                }
+            }
+        }
+    }
+
+    // Draw the bands.
+    pool->dispatch_threshold(band_count, area.width() * area.height() > POOL_THRESHOLD, [&](int band, int) {
+        int const y0 = band * BAND_HEIGHT;
+        int const y1 = std::min(y0 + BAND_HEIGHT, area.height());
+        for (auto const &quad : bands[band]) {
+            auto const vertex = [&](int i) {
+                auto v = quad.v[i];
+                v.x += quad.dx;
+                v.y += quad.dy;
+                return v;
+            };
+            auto const v00 = vertex(0);
+            auto const v01 = vertex(1);
+            auto const v10 = vertex(quad.stride);
+            auto const v11 = vertex(quad.stride + 1);
+            fill_triangle(v00, v01, v11, y0, y1, data, area.width(), stride);
+            fill_triangle(v00, v11, v10, y0, y1, data, area.width(), stride);
+        }
+    });
+
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Rasterization of mesh gradient patches, in parallel
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+#define INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+
+#include <array>
+#include <vector>
+#include <cairo.h>
+#include <2geom/affine.h>
+#include <2geom/int-rect.h>
+#include <2geom/point.h>
+
+namespace Inkscape {
+
+/**
+ * A tensor-product patch of a mesh gradient, as in Cairo's mesh patterns.
+ *
+ * The control points are indexed so that corner 0 is points[0][0], corner 1 points[0][3],
+ * corner 2 points[3][3] and corner 3 points[3][0], as Cairo does.
+ */
+struct MeshPatch
+{
+    Geom::Point points[4][4];
+    std::array<float, 4> colors[4]; ///< Unpremultiplied RGBA of the corners.
+
+    /// A control point of the sides, numbered from 0 to 11 from corner 0 along sides 0 to 3.
+    Geom::Point &side_point(int n);
+
+    /// The control point of the interior next to a corner.
+    Geom::Point &control_point(int corner);
+
+    /// Set the control point of the interior next to a corner as for a Coons patch, from the sides.
+    void set_default_control_point(int corner);
+
+    MeshPatch &operator*=(Geom::Affine const &affine);
+};
+
+/**
+ * A mesh gradient in pixels of a raster, drawn a part at a time like Cairo does when painting a
+ * mesh pattern on an image surface, each patch over the previous ones.
+ *
+ * Cairo subdivides every patch again for each area it paints, on the thread painting it, which
+ * makes fine meshes slow to draw in tiles. Here a patch is subdivided into quadrilaterals of a few
+ * pixels, with colours interpolated along their sides, when a part it covers is first drawn. The
+ * subdivisions of all meshes are kept in one cache of a fixed size, and the quadrilaterals are
+ * drawn in horizontal bands on the shared dispatch pool.
+ *
+ * The patches are those of a mesh gradient, whose neighbours in a row share their sides 1 and 3,
+ * and in a column their sides 2 and 0. They are subdivided alike along those sides, so that no
+ * gaps open between them.
+ */
+class MeshRaster
+{
+public:
+    /**
+     * @param patches Patches in pixels of the raster, row after row.
+     * @param columns The number of patches in a row.
+     */
+    MeshRaster(std::vector<MeshPatch> patches, int columns);
+    ~MeshRaster();
+
+    MeshRaster(MeshRaster const &) = delete;
+    MeshRaster &operator=(MeshRaster const &) = delete;
+
+    /// The area covered by the control points of the patches, rounded out to pixels, or empty if
+    /// one of them is not finite.
+    Geom::OptIntRect const &bounds() const { return _bounds; }
+
+    /**
+     * Draw the part of the mesh in @a area.
+     *
+     * @return A new ARGB32 image surface of the size of @a area, owned by the caller.
+     */
+    cairo_surface_t *rasterize(Geom::IntRect const &area) const;
+
+    /// A point of a subdivision, with its colour.
+    struct Vertex;
+
+private:
+    struct Cache;
+    using Subdivision = std::vector<Vertex>;
+
+    std::vector<MeshPatch> _patches;
+    std::vector<Geom::IntPoint> _steps; ///< Steps along the first and second index, by patch.
+    std::vector<Geom::OptIntRect> _patch_bounds;
+    /// Subdivisions are relative to its top left, so that they are the same along shared sides.
+    Geom::OptIntRect _bounds;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_MESH_RASTERIZER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -16,6 +16,7 @@
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-colormatrix.h"
+#include "display/nr-filter-kernels.h"
 #include "display/nr-filter-slot.h"
 #include <2geom/math-utils.h>
 
@@ -120,17 +121,12 @@ struct ColorMatrixHueRotate
 
     guint32 operator()(guint32 in)
     {
-        EXTRACT_ARGB32(in, a, r, g, b)
-        gint32 maxpx = a*255;
-        gint32 ro = r*_v[0] + g*_v[1] + b*_v[2];
-        gint32 go = r*_v[3] + g*_v[4] + b*_v[5];
-        gint32 bo = r*_v[6] + g*_v[7] + b*_v[8];
-        ro = (pxclamp(ro, 0, maxpx) + 127) / 255;
-        go = (pxclamp(go, 0, maxpx) + 127) / 255;
-        bo = (pxclamp(bo, 0, maxpx) + 127) / 255;
+        return hue_rotate_pixel(_v, in);
+    }
 
-        ASSEMBLE_ARGB32(pxout, a, ro, go, bo)
-        return pxout;
+    void operator()(guint32 const *in, guint32 *out, int n)
+    {
+        hue_rotate_span(_v, in, out, n);
     }
 
 private:
@@ -15,6 +15,7 @@
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
 #include "display/nr-filter-component-transfer.h"
+#include "display/nr-filter-kernels.h"
 #include "display/nr-filter-slot.h"
 
 namespace Inkscape {
@@ -43,12 +44,12 @@ struct MultiplyAlpha
 {
     guint32 operator()(guint32 in)
     {
-        EXTRACT_ARGB32(in, a, r, g, b);
-        r = premul_alpha(r, a);
-        g = premul_alpha(g, a);
-        b = premul_alpha(b, a);
-        ASSEMBLE_ARGB32(out, a, r, g, b);
-        return out;
+        return premultiply_pixel(in);
+    }
+
+    void operator()(guint32 const *in, guint32 *out, int n)
+    {
+        premultiply_span(in, out, n);
     }
 };
 
@@ -522,6 +522,33 @@ gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
     };
 }
 
+Geom::Point FilterGaussian::_pixel_deviation(FilterUnits const &units, int device_scale) const
+{
+    // Handle bounding box case.
+    double dx = _deviation_x;
+    double dy = _deviation_y;
+    if( units.get_primitive_units() == SP_FILTER_UNITS_OBJECTBOUNDINGBOX ) {
+        Geom::OptRect const bbox = units.get_item_bbox();
+        if( bbox ) {
+            dx *= (*bbox).width();
+            dy *= (*bbox).height();
+        }
+    }
+
+    Geom::Affine trans = units.get_matrix_user2pb();
+
+    return Geom::Point(dx * trans.expansionX(), dy * trans.expansionY()) * device_scale;
+}
+
+bool FilterGaussian::can_render_tiled(FilterUnits const &units, int device_scale, int blurquality) const
+{
+    // The input is downsampled to fit the size of the area rendered, so sub-tiles would be blurred
+    // on grids that do not line up, and show seams.
+    auto const deviation = _pixel_deviation(units, device_scale);
+    auto const resamples = [&] (double d) { return d > 0 && _effect_subsample_step_log2(d, blurquality) > 0; };
+    return !resamples(deviation[Geom::X]) && !resamples(deviation[Geom::Y]);
+}
+
 void FilterGaussian::render_cairo(FilterSlot &slot) const
 {
     cairo_surface_t *in = slot.getcairo(_input);
@@ -542,26 +569,10 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
         return;
     }
 
-    // Handle bounding box case.
-    double dx = _deviation_x;
-    double dy = _deviation_y;
-    if( slot.get_units().get_primitive_units() == SP_FILTER_UNITS_OBJECTBOUNDINGBOX ) {
-        Geom::OptRect const bbox = slot.get_units().get_item_bbox();
-        if( bbox ) {
-            dx *= (*bbox).width();
-            dy *= (*bbox).height();
-        }
-    }
-
-    Geom::Affine trans = slot.get_units().get_matrix_user2pb();
-
-    double deviation_x_orig = dx * trans.expansionX();
-    double deviation_y_orig = dy * trans.expansionY();
-
     int device_scale = slot.get_device_scale();
-
-    deviation_x_orig *= device_scale;
-    deviation_y_orig *= device_scale;
+    auto const deviation = _pixel_deviation(slot.get_units(), device_scale);
+    double deviation_x_orig = deviation[Geom::X];
+    double deviation_y_orig = deviation[Geom::Y];
 
     cairo_format_t fmt = cairo_image_surface_get_format(in);
     int bytes_per_pixel = 0;
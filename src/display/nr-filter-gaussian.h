@@ -40,6 +40,7 @@ public:
     void area_enlarge(Geom::IntRect &area, Geom::Affine const &m) const override;
     bool can_handle_affine(Geom::Affine const &m) const override;
     double complexity(Geom::Affine const &ctm) const override;
+    bool can_render_tiled(FilterUnits const &units, int device_scale, int blurquality) const override;
 
     /**
      * Set the standard deviation value for gaussian blur. Deviation along
@@ -62,6 +63,9 @@ public:
     Glib::ustring name() const override { return Glib::ustring("Gaussian Blur"); }
 
 private:
+    /// The deviations in pixels of the surfaces the blur is rendered to.
+    Geom::Point _pixel_deviation(FilterUnits const &units, int device_scale) const;
+
     double _deviation_x;
     double _deviation_y;
 };
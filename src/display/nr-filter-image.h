@@ -34,6 +34,7 @@ public:
     void render_cairo(FilterSlot &slot) const override;
     bool can_handle_affine(Geom::Affine const &) const override;
     double complexity(Geom::Affine const &ctm) const override;
+    bool can_render_tiled(FilterUnits const &, int, int) const override { return false; }
 
     void set_document(SPDocument *document);
     void set_href(char const *href);
@@ -114,6 +114,21 @@ public:
      */
     virtual bool can_handle_affine(Geom::Affine const &) const { return false; }
 
+    /**
+     * Indicate whether the filter primitive can be rendered in independent sub-tiles.
+     *
+     * This requires that every output pixel only depends on input pixels within the area
+     * reported by area_enlarge(), and that render_cairo() may run concurrently on several
+     * slots. Primitives that read outside of that area (feTile) or that lazily set up shared
+     * state while rendering must return false, as must those that resample their input on a
+     * grid that depends on the size of the area rendered.
+     *
+     * @param units The units the filter is rendered with.
+     * @param device_scale The device scale of the surfaces rendered to.
+     * @param blurquality The blur quality the filter is rendered with.
+     */
+    virtual bool can_render_tiled(FilterUnits const &units, int device_scale, int blurquality) const { return true; }
+
     /**
      * Sets style for access to properties used by filter primitives.
      */
@@ -29,6 +29,7 @@ public:
     void render_cairo(FilterSlot &slot) const override;
     void area_enlarge(Geom::IntRect &area, Geom::Affine const &trans) const override;
     double complexity(Geom::Affine const &ctm) const override;
+    bool can_render_tiled(FilterUnits const &, int, int) const override { return false; }
 
     Glib::ustring name() const override { return Glib::ustring("Tile"); }
 };
@@ -50,6 +50,7 @@ public:
     void render_cairo(FilterSlot &slot) const override;
     double complexity(Geom::Affine const &ctm) const override;
     bool uses_background() const override { return false; }
+    bool can_render_tiled(FilterUnits const &, int, int) const override { return false; }
 
     void set_baseFrequency(int axis, double freq);
     void set_numOctaves(int num);
@@ -11,9 +11,13 @@
  */
 
 #include <glib.h>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <memory>
+#include <new>
 #include <string>
+#include <vector>
 #include <cairo.h>
 
 #include "display/nr-filter.h"
@@ -40,10 +44,12 @@
 #include "display/nr-filter-turbulence.h"
 
 #include "display/cairo-utils.h"
+#include "display/dispatch-pool.h"
 #include "display/drawing.h"
 #include "display/drawing-item.h"
 #include "display/drawing-context.h"
 #include "display/drawing-surface.h"
+#include "display/threading.h"
 #include <2geom/affine.h>
 #include <2geom/rect.h>
 #include "svg/svg-length.h"
@@ -55,6 +61,11 @@ namespace Filters {
 using Geom::X;
 using Geom::Y;
 
+// Filtered areas smaller than this many pixels are rendered in one piece.
+static constexpr int TILED_RENDER_THRESHOLD = 512 * 512;
+// Minimum edge length of a sub-tile; grows with the halo so that overlap stays affordable.
+static constexpr int TILED_RENDER_MIN_SIZE = 256;
+
 Filter::Filter()
 {
     _common_init();
@@ -149,6 +160,10 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
         }
     }
 
+    if (!(bgdc && uses_background()) && _render_tiled(item, graphic, units, rc, blurquality)) {
+        return 0;
+    }
+
     auto slot = FilterSlot(bgdc, graphic, units, rc, blurquality);
 
     for (auto &i : primitives) {
@@ -170,6 +185,115 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
     return 0;
 }
 
+/**
+ * Render a large filtered area as independent sub-tiles on the dispatch pool.
+ *
+ * Each sub-tile is computed from the source graphic of the sub-tile enlarged by area_enlarge(),
+ * which contains every pixel the filter reads to produce it, so the result is the same as when
+ * the whole area is filtered at once. Primitives for which that does not hold with the given
+ * units and quality, such as blurs that downsample their input, opt out in can_render_tiled().
+ * The sub-tiles are filtered concurrently and then written back into @a graphic.
+ *
+ * @return false if the filter or the area is not suitable, in which case nothing is rendered.
+ */
+bool Filter::_render_tiled(Inkscape::DrawingItem const *item, DrawingContext &graphic, FilterUnits const &units,
+                           RenderContext &rc, int blurquality) const
+{
+    // Sub-tiles are filtered in display space; a transformed intermediate surface would
+    // resample differently along sub-tile edges.
+    if (!units.get_matrix_display2pb().isTranslation()) {
+        return false;
+    }
+    int const device_scale = graphic.surface()->device_scale();
+    for (auto &i : primitives) {
+        if (!i->can_render_tiled(units, device_scale, blurquality) || i->uses_background()) {
+            return false;
+        }
+    }
+
+    auto const area = graphic.targetLogicalBounds().roundOutwards();
+    auto const pool = get_global_dispatch_pool();
+    if (pool->size() < 2 || area.area() < TILED_RENDER_THRESHOLD) {
+        return false;
+    }
+
+    // Measure the halo a sub-tile needs, to keep the overlap small relative to the sub-tile.
+    auto probe = Geom::IntRect::from_xywh(area.min(), {1, 1});
+    area_enlarge(probe, item);
+    int const halo = std::max({area.left() - probe.left(), area.top() - probe.top(),
+                               probe.right() - area.left() - 1, probe.bottom() - area.top() - 1, 0});
+    int const tile_size = std::max(TILED_RENDER_MIN_SIZE, 4 * halo);
+    if (area.width() <= tile_size && area.height() <= tile_size) {
+        return false;
+    }
+
+    struct SubTile
+    {
+        Geom::IntRect rect;                     ///< Area this sub-tile produces.
+        std::unique_ptr<DrawingSurface> source; ///< Source graphic over the enlarged area.
+        cairo_surface_t *result = nullptr;
+    };
+    std::vector<SubTile> tiles;
+
+    cairo_surface_t *source = graphic.rawTarget();
+    cairo_surface_flush(source);
+
+    // Copy the inputs on this thread; cairo surfaces must not be shared between threads.
+    for (int y = area.top(); y < area.bottom(); y += tile_size) {
+        for (int x = area.left(); x < area.right(); x += tile_size) {
+            auto rect = Geom::IntRect(x, y, std::min(x + tile_size, area.right()), std::min(y + tile_size, area.bottom()));
+            Geom::IntRect input = rect;
+            area_enlarge(input, item);
+            input = *(input & area);
+
+            auto surface = std::make_unique<DrawingSurface>(input, device_scale);
+            DrawingContext dc(*surface);
+            dc.setSource(source, area.left(), area.top());
+            dc.setOperator(CAIRO_OPERATOR_SOURCE);
+            dc.paint();
+
+            tiles.push_back({rect, std::move(surface)});
+        }
+    }
+
+    bool out_of_memory = false;
+    pool->dispatch(tiles.size(), [&] (int i, int) {
+        auto &tile = tiles[i];
+        try {
+            DrawingContext dc(*tile.source);
+            auto slot = FilterSlot(nullptr, dc, units, rc, blurquality);
+            for (auto &p : primitives) {
+                p->render_cairo(slot);
+            }
+            tile.result = slot.get_result(_output_slot);
+        } catch (std::bad_alloc const &) {
+            out_of_memory = true;
+        }
+    });
+
+    for (auto &tile : tiles) {
+        if (!tile.result) {
+            continue;
+        }
+        // Assume for the moment that we paint the filter in sRGB
+        set_cairo_surface_ci(tile.result, SP_CSS_COLOR_INTERPOLATION_SRGB);
+
+        auto const origin = tile.source->area().min();
+        graphic.rectangle(tile.rect);
+        graphic.setSource(tile.result, origin[Geom::X], origin[Geom::Y]);
+        graphic.setOperator(CAIRO_OPERATOR_SOURCE);
+        graphic.fill();
+        cairo_surface_destroy(tile.result);
+    }
+    graphic.setOperator(CAIRO_OPERATOR_OVER);
+
+    if (out_of_memory) {
+        throw std::bad_alloc();
+    }
+
+    return true;
+}
+
 void Filter::add_primitive(std::unique_ptr<FilterPrimitive> primitive)
 {
     primitives.emplace_back(std::move(primitive));
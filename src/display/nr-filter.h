@@ -27,6 +27,8 @@ class RenderContext;
 
 namespace Filters {
 
+class FilterUnits;
+
 class Filter final
 {
 public:
@@ -186,6 +188,8 @@ private:
     SPFilterUnits _primitive_units;
 
     void _common_init();
+    bool _render_tiled(Inkscape::DrawingItem const *item, DrawingContext &graphic, FilterUnits const &units,
+                       RenderContext &rc, int blurquality) const;
     static int _resolution_limit(FilterQuality quality);
     std::pair<double, double> _filter_resolution(Geom::Rect const &area,
                                                  Geom::Affine const &trans,
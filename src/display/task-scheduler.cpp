@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::task_scheduler - process-wide work-stealing thread pool
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "task-scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Inkscape {
+
+namespace {
+
+// Identifies the scheduler and worker index of the calling thread, if it is a worker.
+struct worker_identity
+{
+    task_scheduler const *scheduler = nullptr;
+    int index = -1;
+};
+
+thread_local worker_identity t_worker;
+
+} // namespace
+
+std::shared_ptr<task_scheduler> task_scheduler::create(int num_threads)
+{
+    return std::shared_ptr<task_scheduler>(new task_scheduler(num_threads), [](task_scheduler *scheduler) {
+        if (scheduler->current_worker() != -1) {
+            // Dropped by a task it runs, whose worker it would have to join; do that from elsewhere.
+            std::thread([scheduler] { delete scheduler; }).detach();
+        } else {
+            delete scheduler;
+        }
+    });
+}
+
+task_scheduler::task_scheduler(int num_threads)
+    : _size(std::max(num_threads, 1))
+{
+    _workers.reserve(_size + 1);
+    for (int i = 0; i < _size; i++) {
+        _workers.emplace_back(std::make_unique<worker>());
+    }
+
+    // A background task must not take the only worker, which the canvas would then wait for.
+    if (_size == 1) {
+        _workers.emplace_back(std::make_unique<worker>());
+        _workers.back()->background_only = true;
+    }
+
+    // Start the threads only once all deques exist, since workers steal from each other.
+    for (int i = 0; i < (int)_workers.size(); i++) {
+        _workers[i]->thread = std::thread([i, this] { worker_func(i); });
+    }
+}
+
+task_scheduler::~task_scheduler()
+{
+    assert(current_worker() == -1);
+
+    {
+        std::scoped_lock lk(_lock);
+        _shutdown = true;
+    }
+
+    _available_cv.notify_all();
+    _background_cv.notify_all();
+
+    for (auto &w : _workers) {
+        w->thread.join();
+    }
+}
+
+int task_scheduler::current_worker() const
+{
+    return t_worker.scheduler == this ? t_worker.index : -1;
+}
+
+void task_scheduler::post(task t, priority p)
+{
+    {
+        std::scoped_lock lk(_lock);
+        (p == priority::interactive ? _interactive : _background).emplace_back(std::move(t));
+    }
+    if (p == priority::background) {
+        _background_cv.notify_one();
+    }
+    _available_cv.notify_one();
+}
+
+void task_scheduler::post_job(task t)
+{
+    if (int const index = current_worker(); index != -1) {
+        auto &w = *_workers[index];
+        std::scoped_lock lk(w.lock);
+        w.jobs.emplace_back(std::move(t));
+    } else {
+        std::scoped_lock lk(_jobs_lock);
+        _jobs.emplace_back(std::move(t));
+    }
+    notify();
+}
+
+void task_scheduler::notify()
+{
+    _queued_jobs.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock orders the increment before a sleeping worker's check of _queued_jobs.
+    {
+        std::scoped_lock lk(_lock);
+    }
+    _available_cv.notify_one();
+}
+
+bool task_scheduler::pop_job(task &out)
+{
+    int const self = current_worker();
+    int const count = _workers.size();
+
+    // Own jobs are taken newest first, since their data is most likely still in cache.
+    if (self != -1) {
+        auto &w = *_workers[self];
+        std::scoped_lock lk(w.lock);
+        if (!w.jobs.empty()) {
+            out = std::move(w.jobs.back());
+            w.jobs.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::scoped_lock lk(_jobs_lock);
+        if (!_jobs.empty()) {
+            out = std::move(_jobs.front());
+            _jobs.pop_front();
+            return true;
+        }
+    }
+
+    // Steal the oldest job of another worker, which usually represents the largest piece of work.
+    for (int i = 1; i <= count; i++) {
+        int const victim = (std::max(self, 0) + i) % count;
+        if (victim == self) {
+            continue;
+        }
+        auto &w = *_workers[victim];
+        std::scoped_lock lk(w.lock);
+        if (!w.jobs.empty()) {
+            out = std::move(w.jobs.front());
+            w.jobs.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool task_scheduler::run_pending_job()
+{
+    task t;
+    if (!pop_job(t)) {
+        return false;
+    }
+
+    _queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    t();
+    return true;
+}
+
+// Must be called with _lock held.
+bool task_scheduler::can_run_task(worker const &w) const
+{
+    if (!w.background_only && !_interactive.empty()) {
+        return true;
+    }
+    bool const runs_background = w.background_only || size() > 1;
+    return runs_background && !_background.empty() && _background_running < std::max(size() - 1, 1);
+}
+
+// Whether a worker may stop, as the scheduler is shutting down and none of the work it would take
+// is left. Must be called with _lock held.
+bool task_scheduler::is_done(worker const &w) const
+{
+    if (!_shutdown) {
+        return false;
+    }
+    if (w.background_only) {
+        return _background.empty();
+    }
+    // Queued work is finished before shutting down, since its submitter may be waiting for it.
+    return _interactive.empty() && (size() == 1 || _background.empty())
+        && _queued_jobs.load(std::memory_order_acquire) == 0;
+}
+
+void task_scheduler::worker_func(int index)
+{
+    t_worker = {this, index};
+    auto const &w = *_workers[index];
+
+    while (true) {
+        // Interactive tasks first, then jobs, which other threads may be waiting for, then the rest.
+        task t;
+        bool background = false;
+        if (!w.background_only) {
+            std::scoped_lock lk(_lock);
+            if (!_interactive.empty()) {
+                t = std::move(_interactive.front());
+                _interactive.pop_front();
+            }
+        }
+
+        if (!t) {
+            if (!w.background_only && run_pending_job()) {
+                continue;
+            }
+
+            std::unique_lock lk(_lock);
+            if (!can_run_task(w)) {
+                if (w.background_only) {
+                    _background_cv.wait(lk, [&] { return can_run_task(w) || is_done(w); });
+                } else {
+                    _available_cv.wait(lk, [&] {
+                        return can_run_task(w) || _queued_jobs.load(std::memory_order_acquire) > 0 || is_done(w);
+                    });
+                }
+                if (is_done(w)) {
+                    return;
+                }
+                continue;
+            }
+
+            if (!w.background_only && !_interactive.empty()) {
+                t = std::move(_interactive.front());
+                _interactive.pop_front();
+            } else {
+                t = std::move(_background.front());
+                _background.pop_front();
+                _background_running++;
+                background = true;
+            }
+        }
+
+        t();
+
+        if (background) {
+            {
+                std::scoped_lock lk(_lock);
+                _background_running--;
+            }
+            // Another background task may have been held back by the limit.
+            _background_cv.notify_one();
+            _available_cv.notify_one();
+        }
+    }
+}
+
+task_group::task_group(std::shared_ptr<task_scheduler> scheduler, task_scheduler::priority priority)
+    : _scheduler(std::move(scheduler))
+    , _priority(priority)
+    , _state(std::make_shared<state>())
+{
+}
+
+task_group::~task_group()
+{
+    try {
+        wait();
+    } catch (...) {
+        // Exceptions are only reported by an explicit wait().
+    }
+}
+
+void task_group::run(task_scheduler::task t)
+{
+    {
+        std::scoped_lock lk(_state->lock);
+        _state->queued.emplace_back(std::move(t));
+        _state->outstanding++;
+        _state->done_cv.notify_all(); // Wakes wait(), to run it.
+    }
+
+    // Whichever of the worker and wait() comes first runs a task; the other finds none left.
+    _scheduler->post([s = _state] { run_queued(*s); }, _priority);
+}
+
+bool task_group::run_queued(state &s)
+{
+    task_scheduler::task t;
+    {
+        std::scoped_lock lk(s.lock);
+        if (s.queued.empty()) {
+            return false;
+        }
+        t = std::move(s.queued.front());
+        s.queued.pop_front();
+    }
+
+    try {
+        t();
+    } catch (...) {
+        std::scoped_lock lk(s.lock);
+        if (!s.error) {
+            s.error = std::current_exception();
+        }
+    }
+
+    std::scoped_lock lk(s.lock);
+    if (--s.outstanding == 0) {
+        s.done_cv.notify_all();
+    }
+    return true;
+}
+
+void task_group::wait()
+{
+    while (true) {
+        {
+            std::scoped_lock lk(_state->lock);
+            if (_state->outstanding == 0) {
+                break;
+            }
+        }
+
+        if (!run_queued(*_state) && !_scheduler->run_pending_job()) {
+            // Nothing to help with; sleep until done, or until a task of the group is queued.
+            std::unique_lock lk(_state->lock);
+            _state->done_cv.wait(lk, [&] { return _state->outstanding == 0 || !_state->queued.empty(); });
+        }
+    }
+
+    std::exception_ptr error;
+    {
+        std::scoped_lock lk(_state->lock);
+        std::swap(error, _state->error);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
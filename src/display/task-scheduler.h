@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::task_scheduler - process-wide work-stealing thread pool
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_TASK_SCHEDULER_H
+#define INKSCAPE_DISPLAY_TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Inkscape {
+
+/**
+ * Work-stealing thread pool shared by everything in Inkscape that renders in parallel.
+ *
+ * Two kinds of work can be submitted:
+ *
+ * - Jobs are short pieces of computation, such as a range of rows of a filter primitive. They
+ *   are queued on the submitting worker's own deque and stolen by idle workers. A thread
+ *   waiting for jobs to complete executes other queued jobs in the meantime, which makes
+ *   parallel loops nestable and lets several of them run concurrently. For the same reason,
+ *   a job must not block on anything other than jobs it submitted itself.
+ *
+ * - Tasks are coarser units of work, such as rendering canvas tiles or exporting a page. They
+ *   are queued in submission order and picked up by workers, and may block (for example, waiting
+ *   for the main thread). Interactive tasks are run before anything else, and background tasks
+ *   only once no jobs are queued. At most size() - 1 workers run background tasks at once, so
+ *   that long exports or traces leave a worker for the canvas. With a single worker, background
+ *   tasks are run by a thread of their own instead, which takes no other work.
+ *
+ * Most code does not use the scheduler directly, but either dispatch_pool for parallel loops,
+ * or a task_group for a set of tasks that must be waited for.
+ *
+ * Queued work is always executed before the scheduler is destroyed. Schedulers are made by
+ * create(), and if the last reference to one is dropped by one of its own workers, it is
+ * destroyed on another thread, which the worker's thread cannot be joined from.
+ */
+class task_scheduler
+{
+public:
+    using task = std::function<void()>;
+
+    enum class priority
+    {
+        interactive, ///< Work the user is waiting for, such as redrawing the canvas.
+        background,  ///< Long work, such as exporting or tracing.
+    };
+
+    static std::shared_ptr<task_scheduler> create(int num_threads);
+
+    task_scheduler(task_scheduler const &) = delete;
+    task_scheduler &operator=(task_scheduler const &) = delete;
+
+    /// Number of worker threads, not counting the one for background tasks of a single worker.
+    int size() const { return _size; }
+
+    /// Queue a task, to be run by a worker after the tasks of the same priority queued before.
+    void post(task t, priority p = priority::background);
+
+    /// Queue a job, to be run as soon as possible by any worker.
+    void post_job(task t);
+
+    /// Run one queued job on the calling thread. Return false if there was none.
+    bool run_pending_job();
+
+    /// Index of the calling thread among the workers, or -1 if it is not one of them.
+    int current_worker() const;
+
+private:
+    explicit task_scheduler(int num_threads);
+    ~task_scheduler();
+
+    struct worker
+    {
+        std::mutex lock;
+        std::deque<task> jobs;
+        std::thread thread;
+        bool background_only = false; ///< Runs background tasks and nothing else.
+    };
+
+    void worker_func(int index);
+    bool pop_job(task &out);
+    bool can_run_task(worker const &w) const;
+    bool is_done(worker const &w) const;
+    void notify();
+
+    int _size;
+    std::vector<std::unique_ptr<worker>> _workers;
+
+    std::mutex _jobs_lock;
+    std::deque<task> _jobs;  ///< Jobs posted from threads outside the pool.
+    std::atomic<int> _queued_jobs{};
+
+    // Guards the task queues, and is waited on by idle workers.
+    std::mutex _lock;
+    std::condition_variable _available_cv;
+    std::condition_variable _background_cv; ///< Waited on by the background-only worker.
+    std::deque<task> _interactive;
+    std::deque<task> _background;
+    int _background_running = 0;
+    bool _shutdown{};
+};
+
+/**
+ * A set of tasks that can be waited for as a whole.
+ *
+ * Tasks may add further tasks to the group they belong to, so a group can describe a tree of
+ * dependent work; wait() returns once all of it has been done. While waiting, the calling thread
+ * runs the group's own queued tasks and queued jobs rather than blocking, so it is safe to wait
+ * from within a task. It never runs tasks of other groups, which could be long or wait for the
+ * waiting thread in turn.
+ *
+ * If a task throws, the first exception is rethrown from wait(). The remaining tasks still run.
+ */
+class task_group
+{
+public:
+    explicit task_group(std::shared_ptr<task_scheduler> scheduler,
+                        task_scheduler::priority priority = task_scheduler::priority::background);
+    ~task_group();
+
+    task_group(task_group const &) = delete;
+    task_group &operator=(task_group const &) = delete;
+
+    /// Add a task to the group.
+    void run(task_scheduler::task t);
+    void wait();
+
+private:
+    struct state
+    {
+        std::mutex lock;
+        std::condition_variable done_cv;
+        std::deque<task_scheduler::task> queued; ///< Tasks not taken by a worker or wait() yet.
+        int outstanding = 0;
+        std::exception_ptr error;
+    };
+
+    static bool run_queued(state &s);
+
+    std::shared_ptr<task_scheduler> _scheduler;
+    task_scheduler::priority _priority;
+    std::shared_ptr<state> _state;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_TASK_SCHEDULER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
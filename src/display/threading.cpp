@@ -11,6 +11,7 @@
 #include <mutex>
 
 #include "dispatch-pool.h"
+#include "task-scheduler.h"
 
 namespace Inkscape {
 
@@ -18,9 +19,23 @@ namespace {
 
 std::mutex g_dispatch_lock;
 
+std::shared_ptr<task_scheduler> g_task_scheduler;
 std::shared_ptr<dispatch_pool> g_dispatch_pool;
 std::atomic<int> g_num_dispatch_threads = 4;
 
+// Must be called with g_dispatch_lock held.
+void update_global_task_scheduler()
+{
+    int const num_threads = g_num_dispatch_threads.load(std::memory_order_relaxed);
+
+    if (g_task_scheduler && num_threads == g_task_scheduler->size()) {
+        return;
+    }
+
+    g_task_scheduler = task_scheduler::create(num_threads);
+    g_dispatch_pool = std::make_shared<dispatch_pool>(g_task_scheduler);
+}
+
 } // namespace
 
 void set_num_dispatch_threads(int num_dispatch_threads)
@@ -28,17 +43,17 @@ void set_num_dispatch_threads(int num_dispatch_threads)
     g_num_dispatch_threads.store(num_dispatch_threads, std::memory_order_relaxed);
 }
 
-std::shared_ptr<dispatch_pool> get_global_dispatch_pool()
+std::shared_ptr<task_scheduler> get_global_task_scheduler()
 {
-    int const num_threads = g_num_dispatch_threads.load(std::memory_order_relaxed);
-
     std::scoped_lock lk(g_dispatch_lock);
+    update_global_task_scheduler();
+    return g_task_scheduler;
+}
 
-    if (g_dispatch_pool && num_threads == g_dispatch_pool->size()) {
-        return g_dispatch_pool;
-    }
-
-    g_dispatch_pool = std::make_shared<dispatch_pool>(num_threads);
+std::shared_ptr<dispatch_pool> get_global_dispatch_pool()
+{
+    std::scoped_lock lk(g_dispatch_lock);
+    update_global_task_scheduler();
     return g_dispatch_pool;
 }
 
@@ -13,10 +13,13 @@
 namespace Inkscape {
 
 class dispatch_pool;
+class task_scheduler;
 
-// Atomic accessor to global variable governing number of dispatch_pool threads.
+// Atomic accessor to global variable governing number of worker threads, shared by all
+// parallel work in the process.
 void set_num_dispatch_threads(int num_dispatch_threads);
 
+std::shared_ptr<task_scheduler> get_global_task_scheduler();
 std::shared_ptr<dispatch_pool> get_global_dispatch_pool();
 
 } // namespace Inkscape
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::ItemSpatialIndex - R-tree of the document visual bounding
+ *                              boxes of the items in a document
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "document-spatial-index.h"
+
+#include <iterator>
+
+#include "object/sp-item.h"
+
+namespace Inkscape {
+
+void ItemSpatialIndex::invalidate(SPItem *item)
+{
+    _stale.insert(item);
+}
+
+void ItemSpatialIndex::remove(SPItem *item)
+{
+    _stale.erase(item);
+
+    if (auto it = _entries.find(item); it != _entries.end()) {
+        _tree.remove(Entry{it->second, item});
+        _entries.erase(it);
+    }
+}
+
+void ItemSpatialIndex::clear()
+{
+    _tree.clear();
+    _entries.clear();
+    _stale.clear();
+}
+
+/**
+ * Re-measure stale items and update the tree. When most of the index is stale (typically right
+ * after the document was loaded) the tree is bulk-loaded from scratch, which is both faster than
+ * individual insertions and yields a better packed tree.
+ */
+void ItemSpatialIndex::_refresh() const
+{
+    if (_stale.empty()) {
+        return;
+    }
+
+    bool const rebuild = _stale.size() * 2 > _entries.size();
+
+    for (auto item : _stale) {
+        auto it = _entries.find(item);
+        if (it != _entries.end() && !rebuild) {
+            _tree.remove(Entry{it->second, item});
+        }
+
+        if (auto bbox = item->visualBounds(item->i2doc_affine(), true, false, false)) {
+            auto box = Box{{bbox->left(), bbox->top()}, {bbox->right(), bbox->bottom()}};
+            if (it != _entries.end()) {
+                it->second = box;
+            } else {
+                it = _entries.emplace(item, box).first;
+            }
+            if (!rebuild) {
+                _tree.insert(Entry{box, item});
+            }
+        } else if (it != _entries.end()) {
+            _entries.erase(it);
+        }
+    }
+    _stale.clear();
+
+    if (rebuild) {
+        std::vector<Entry> entries;
+        entries.reserve(_entries.size());
+        for (auto const &[item, box] : _entries) {
+            entries.emplace_back(box, item);
+        }
+        _tree = Tree(entries.begin(), entries.end());
+    }
+}
+
+std::vector<SPItem *> ItemSpatialIndex::intersecting(Geom::Rect const &area) const
+{
+    _refresh();
+
+    std::vector<Entry> found;
+    auto const query = Box{{area.left(), area.top()}, {area.right(), area.bottom()}};
+    _tree.query(boost::geometry::index::intersects(query), std::back_inserter(found));
+
+    std::vector<SPItem *> result;
+    result.reserve(found.size());
+    for (auto const &entry : found) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+std::size_t ItemSpatialIndex::size() const
+{
+    _refresh();
+    return _entries.size();
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
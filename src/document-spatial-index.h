@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::ItemSpatialIndex - R-tree of the unclipped document visual
+ *                              bounding boxes of the items in a document
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_DOCUMENT_SPATIAL_INDEX_H
+#define SEEN_INKSCAPE_DOCUMENT_SPATIAL_INDEX_H
+
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry.hpp>
+#include <boost/geometry/index/rtree.hpp>
+
+#include <2geom/rect.h>
+
+class SPItem;
+
+namespace Inkscape {
+
+/**
+ * Spatial index of item bounds, used by SPDocument to answer area and point queries
+ * without visiting every item of the document.
+ *
+ * Items are registered when they are built and marked stale whenever they are updated,
+ * which is the same point at which SPItem drops its cached document bounding box. Stale
+ * entries are only re-measured on the next query, so a burst of modifications costs a
+ * single re-insertion per item. Bounds are in document coordinates.
+ *
+ * Clips and masks are left out of the bounds: outline mode draws and picks items without them,
+ * and snapping finds geometry outside of them, so the index must not miss those parts. Callers
+ * that want the clipped bounds check them on the candidates.
+ */
+class ItemSpatialIndex
+{
+public:
+    ItemSpatialIndex() = default;
+    ItemSpatialIndex(ItemSpatialIndex const &) = delete;
+    ItemSpatialIndex &operator=(ItemSpatialIndex const &) = delete;
+
+    void invalidate(SPItem *item);
+    void remove(SPItem *item);
+    void clear();
+
+    /// Return the items whose bounds intersect @a area, in no particular order.
+    std::vector<SPItem *> intersecting(Geom::Rect const &area) const;
+
+    /// Number of items with known bounds, after refreshing stale entries.
+    std::size_t size() const;
+
+private:
+    using Point = boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian>;
+    using Box = boost::geometry::model::box<Point>;
+    using Entry = std::pair<Box, SPItem *>;
+    using Tree = boost::geometry::index::rtree<Entry, boost::geometry::index::rstar<16>>;
+
+    void _refresh() const;
+
+    // Refreshed lazily by the queries.
+    mutable Tree _tree;
+    mutable std::unordered_map<SPItem *, Box> _entries; ///< Bounds currently stored in _tree, by item.
+    mutable std::unordered_set<SPItem *> _stale;        ///< Items whose bounds must be re-measured.
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_DOCUMENT_SPATIAL_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -62,6 +62,7 @@
 #include "object/sp-lpe-item.h"             // for sp_lpe_item_update_pathef...
 #include "object/sp-root.h"                 // for SPRoot
 #include "preferences.h"
+#include "xml/event.h"                      // for Event
 #include "xml/event-fns.h"                  // for sp_repr_begin_transaction
 
 namespace Inkscape::XML {
@@ -160,6 +161,8 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
 
     bool limit_undo = Inkscape::Preferences::get()->getBool("/options/undo/limit");
     auto undo_size = Inkscape::Preferences::get()->getInt("/options/undo/size", 200);
+    // In MiB, and applied whether or not the number of steps is limited.
+    std::size_t undo_memory = Inkscape::Preferences::get()->getIntLimited("/options/undo/memory", 256, 1, 65536);
 
     // Undo size zero will cause crashes when changing the preference during an active document
     assert(undo_size > 0);
@@ -182,10 +185,18 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
     }
 
     if (key && !doc->actionkey.empty() && (doc->actionkey == key) && !doc->undo.empty()) {
-        (doc->undo.back())->event = sp_repr_coalesce_log ((doc->undo.back())->event, log);
+        coalesce_last(*doc, log);
     } else {
+        // Nothing more will be added to the previous step.
+        if (!doc->undo.empty()) {
+            auto const previous = doc->undo.back();
+            doc->undo_bytes -= previous->bytes;
+            previous->compact();
+            doc->undo_bytes += previous->bytes;
+        }
         Inkscape::Event *event = new Inkscape::Event(log, event_description, icon_name);
         doc->undo.push_back(event);
+        doc->undo_bytes += event->bytes;
         doc->undoStackObservers.notifyUndoCommitEvent(event);
     }
 
@@ -198,20 +209,23 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
     doc->virgin = FALSE;
     doc->setModifiedSinceSave();
     sp_repr_begin_transaction (doc->rdoc);
-    doc->commit_signal.emit();
 
     // Keeping the undo stack to a reasonable size is done when we're not maybeDone.
     // Note: Redo does not need the same controls since in theory it should never be
     // able to get larger than the undo size as it's only populated with undo items.
     if (!key) {
-        // We remove undo items from the front of the stack
-        while (limit_undo && (int)doc->undo.size() > undo_size) {
+        // We remove undo items from the front of the stack, but always keep the last one.
+        while (doc->undo.size() > 1 &&
+               ((limit_undo && (int)doc->undo.size() > undo_size) || doc->undo_bytes > (undo_memory << 20))) {
             Inkscape::Event *e = doc->undo.front();
+            doc->undo_bytes -= e->bytes;
             doc->undoStackObservers.notifyUndoExpired(e);
             doc->undo.pop_front();
             delete e;
         }
     }
+
+    doc->commit_signal.emit();
 }
 
 void Inkscape::DocumentUndo::cancel(SPDocument *doc)
@@ -233,8 +247,7 @@ void Inkscape::DocumentUndo::finish_incomplete_transaction(SPDocument &doc) {
         g_warning ("Incomplete undo transaction (added to next undo):");
         doc.partial = sp_repr_coalesce_log(doc.partial, log);
         if (!doc.undo.empty()) {
-            Inkscape::Event* undo_stack_top = doc.undo.back();
-            undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, doc.partial);
+            coalesce_last(doc, doc.partial);
         } else {
             sp_repr_free_log(doc.partial);
         }
@@ -242,6 +255,21 @@ void Inkscape::DocumentUndo::finish_incomplete_transaction(SPDocument &doc) {
 	}
 }
 
+// Member function for friend access to SPDocument privates.
+void Inkscape::DocumentUndo::coalesce_last(SPDocument &doc, Inkscape::XML::Event *log) {
+    Inkscape::Event *undo_stack_top = doc.undo.back();
+
+    // Only the events of log, and the last one of the step they may be merged with, are counted
+    // again, rather than the whole step.
+    auto const unchanged = undo_stack_top->event ? undo_stack_top->event->next : nullptr;
+    auto const removed = sp_repr_log_bytes(undo_stack_top->event, unchanged);
+    undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, log);
+    auto const added = sp_repr_log_bytes(undo_stack_top->event, unchanged);
+
+    undo_stack_top->bytes += added - removed;
+    doc.undo_bytes += added - removed;
+}
+
 // Member function for friend access to SPDocument privates.
 void Inkscape::DocumentUndo::perform_document_update(SPDocument &doc) {
     sp_repr_begin_transaction(doc.rdoc);
@@ -256,8 +284,7 @@ void Inkscape::DocumentUndo::perform_document_update(SPDocument &doc) {
 
         //Coalesce the update changes with the last action performed by user
         if (!doc.undo.empty()) {
-            Inkscape::Event* undo_stack_top = doc.undo.back();
-            undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, update_log);
+            coalesce_last(doc, update_log);
         } else {
             sp_repr_free_log(update_log);
         }
@@ -284,6 +311,7 @@ gboolean Inkscape::DocumentUndo::undo(SPDocument *doc)
     if (! doc->undo.empty()) {
         Inkscape::Event *log = doc->undo.back();
         doc->undo.pop_back();
+        doc->undo_bytes -= log->bytes;
         sp_repr_undo_log (log->event);
         perform_document_update(*doc);
         doc->redo.push_back(log);
@@ -323,6 +351,7 @@ gboolean Inkscape::DocumentUndo::redo(SPDocument *doc)
 		doc->redo.pop_back();
 		sp_repr_replay_log (log->event);
         doc->undo.push_back(log);
+        doc->undo_bytes += log->bytes;
         perform_document_update(*doc);
 
         doc->setModifiedSinceSave();
@@ -343,6 +372,20 @@ gboolean Inkscape::DocumentUndo::redo(SPDocument *doc)
 	return ret;
 }
 
+Inkscape::DocumentUndo::Stats Inkscape::DocumentUndo::getStats(SPDocument const *doc)
+{
+    g_assert(doc != nullptr);
+
+    Stats stats;
+    stats.undo_steps = doc->undo.size();
+    stats.redo_steps = doc->redo.size();
+    stats.undo_bytes = doc->undo_bytes;
+    for (auto e : doc->redo) {
+        stats.redo_bytes += e->bytes;
+    }
+    return stats;
+}
+
 void Inkscape::DocumentUndo::clearUndo(SPDocument *doc)
 {
     if (! doc->undo.empty())
@@ -352,6 +395,7 @@ void Inkscape::DocumentUndo::clearUndo(SPDocument *doc)
         doc->undo.pop_back();
         delete e;
     }
+    doc->undo_bytes = 0;
 }
 
 void Inkscape::DocumentUndo::clearRedo(SPDocument *doc)
@@ -10,6 +10,7 @@
 #ifndef SEEN_SP_DOCUMENT_UNDO_H
 #define SEEN_SP_DOCUMENT_UNDO_H
 
+#include <cstddef>
 #include <glib.h>   // gboolean, gchar
 
 namespace Glib {
@@ -20,6 +21,10 @@ class SPDocument;
 
 namespace Inkscape {
 
+namespace XML {
+class Event;
+} // namespace XML
+
 class DocumentUndo
 {
 public:
@@ -42,8 +47,20 @@ public:
 
     static void maybeDone(SPDocument *document, const gchar *keyconst, Glib::ustring const &event_description, Glib::ustring const &undo_icon);
 
+    struct Stats
+    {
+        std::size_t undo_steps = 0;
+        std::size_t redo_steps = 0;
+        std::size_t undo_bytes = 0; ///< Approximate memory used by the undo steps.
+        std::size_t redo_bytes = 0;
+    };
+
+    /// Size of the undo and redo history of a document.
+    static Stats getStats(SPDocument const *document);
+
 private:
     static void finish_incomplete_transaction(SPDocument &document);
+    static void coalesce_last(SPDocument &document, Inkscape::XML::Event *log);
 
     static void perform_document_update(SPDocument &document);
 
@@ -35,6 +35,7 @@
 
 #include "document.h"
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -46,6 +47,7 @@
 #include <2geom/transforms.h>
 
 #include "desktop.h"
+#include "document-spatial-index.h"
 #include "document-undo.h"
 #include "event-log.h"
 #include "file.h"
@@ -57,6 +59,7 @@
 #include "colors/document-cms.h"
 #include "rdf.h"
 #include "selection.h"
+#include "style-sheet-index.h"
 
 #include "3rdparty/adaptagrams/libavoid/router.h"
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
@@ -70,6 +73,7 @@
 #include "display/drawing.h"
 #include "io/dir-util.h"
 #include "live_effects/lpeobject.h"
+#include "object/build-cache.h"
 #include "object/persp3d.h"
 #include "object/sp-defs.h"
 #include "object/sp-factory.h"
@@ -124,6 +128,7 @@ SPDocument::SPDocument() :
 
     _event_log = std::make_unique<Inkscape::EventLog>(this);
     _selection = std::make_unique<Inkscape::Selection>(this);
+    _spatial_index = std::make_unique<Inkscape::ItemSpatialIndex>();
 
     _desktop_activated_connection = INKSCAPE.signal_activate_desktop.connect(
                 sigc::hide(sigc::bind(
@@ -189,6 +194,7 @@ SPDocument::~SPDocument() {
     resources.clear();
 
     // This also destroys all attached stylesheets
+    _style_sheet_index.reset();
     cr_cascade_unref(style_cascade);
     style_cascade = nullptr;
 
@@ -226,6 +232,14 @@ int SPDocument::get_new_doc_number()
     return ++doc_count;
 }
 
+Inkscape::StyleSheetIndex const *SPDocument::getStyleSheetIndex()
+{
+    if (!_style_sheet_index) {
+        _style_sheet_index = std::make_unique<Inkscape::StyleSheetIndex>(style_cascade);
+    }
+    return _style_sheet_index->usable() ? _style_sheet_index.get() : nullptr;
+}
+
 Inkscape::XML::Node *SPDocument::getReprNamedView()
 {
     return sp_repr_lookup_name (rroot, "sodipodi:namedview");
@@ -402,8 +416,10 @@ std::unique_ptr<SPDocument> SPDocument::createDoc(
     	throw;
     }
 
-    // Recursively build object tree
+    // Recursively build object tree, with the expensive attributes parsed in advance
+    document->_build_cache = std::make_unique<Inkscape::BuildCache>(rroot);
     document->root->invoke_build(document.get(), rroot, false);
+    document->_build_cache.reset();
 
     /* Eliminate obsolete sodipodi:docbase, for privacy reasons */
     rroot->removeAttribute("sodipodi:docbase");
@@ -1140,13 +1156,15 @@ void SPDocument::bindObjectToId(char const *id, SPObject *object)
     GQuark idq = g_quark_from_string(id);
 
     if (object) {
-        if(object->getId()) {
-            iddef.erase(object->getId());
+        if (object->getId()) {
+            if (auto it = iddef.find(std::string_view(object->getId())); it != iddef.end()) {
+                iddef.erase(it);
+            }
         }
         auto ret = iddef.emplace(id, object);
         g_assert(ret.second);
     } else {
-        auto it = iddef.find(id);
+        auto it = iddef.find(std::string_view(id));
         g_assert(it != iddef.end());
         iddef.erase(it);
     }
@@ -1180,7 +1198,7 @@ SPObject *SPDocument::getObjectById(char const *id) const
 {
     if (!id || iddef.empty()) return nullptr;
 
-    if (auto rv = iddef.find(id); rv != iddef.end()) {
+    if (auto rv = iddef.find(std::string_view(id)); rv != iddef.end()) {
         return rv->second;
     } else if (_parent_document) {
         return _parent_document->getObjectById(id);
@@ -1193,9 +1211,8 @@ SPObject *SPDocument::getObjectById(char const *id) const
 
 SPObject *SPDocument::getObjectByHref(std::string const &href) const
 {
-    if (iddef.empty()) return nullptr;
-    auto id = href.substr(1);
-    return getObjectById(id);
+    if (href.empty() || iddef.empty()) return nullptr;
+    return getObjectById(href.c_str() + 1);
 }
 
 SPObject *SPDocument::getObjectByHref(char const *href) const
@@ -1532,8 +1549,12 @@ static bool overlaps(Geom::Rect const &area, Geom::Rect const &box)
 /**
  * Return a vector list of items in a given area.
  *
- * @param s The returned list
- * @param group The starting group
+ * Candidates are taken from the document's spatial index, and each one is then checked against
+ * the rules of a depth-first traversal from the root, so that the result is the same as if every
+ * item had been visited.
+ *
+ * @param index The spatial index of the document
+ * @param root The starting group
  * @param dkey The display control group to traverse
  * @param area Area in document coordinates
  * @param test A function called for each item's bbox
@@ -1543,43 +1564,68 @@ static bool overlaps(Geom::Rect const &area, Geom::Rect const &box)
  * @param enter_groups (false) traverse into regular groups
  * @param enter_layers (true) traverse into layer groups
  */
-static std::vector<SPItem*> &find_items_in_area(std::vector<SPItem*> &s,
-                                                SPGroup *group, unsigned int dkey,
-                                                Geom::Rect const &area,
-                                                bool (*test)(Geom::Rect const &, Geom::Rect const &),
-                                                bool take_hidden = false,
-                                                bool take_insensitive = false,
-                                                bool take_groups = true,
-                                                bool enter_groups = false,
-                                                bool enter_layers = true)
-{
-    g_return_val_if_fail(group, s);
-
-    for (auto& o: group->children) {
-        if (auto item = cast<SPItem>(&o)) {
-            if (!take_insensitive && item->isLocked()) {
-                continue;
+static std::vector<SPItem*> find_items_in_area(Inkscape::ItemSpatialIndex const &index,
+                                               SPGroup *root, unsigned int dkey,
+                                               Geom::Rect const &area,
+                                               bool (*test)(Geom::Rect const &, Geom::Rect const &),
+                                               bool take_hidden = false,
+                                               bool take_insensitive = false,
+                                               bool take_groups = true,
+                                               bool enter_groups = false,
+                                               bool enter_layers = true)
+{
+    std::vector<SPItem*> s;
+    g_return_val_if_fail(root, s);
+
+    auto const is_eligible = [=] (SPItem const *item) {
+        return (take_insensitive || !item->isLocked()) && (take_hidden || !item->isHidden());
+    };
+
+    // Whether the traversal would descend from the root down to the parent of item.
+    auto const is_reachable = [=] (SPItem const *item) {
+        for (auto parent = item->parent; parent; parent = parent->parent) {
+            if (parent == root) {
+                return true;
             }
-
-            if (!take_hidden && item->isHidden()) {
-                continue;
+            auto group = cast<SPGroup>(parent);
+            if (!group || !is_eligible(group)) {
+                return false;
             }
-
-            if (auto childgroup = cast<SPGroup>(item)) {
-                bool is_layer = childgroup->effectiveLayerMode(dkey) == SPGroup::LAYER;
-                if ((enter_layers && is_layer) || (enter_groups)) {
-                    s = find_items_in_area(s, childgroup, dkey, area, test, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
-                }
-                if (!take_groups || (enter_layers && is_layer)) {
-                    continue;
-                }
+            bool is_layer = group->effectiveLayerMode(dkey) == SPGroup::LAYER;
+            if (!(enter_layers && is_layer) && !enter_groups) {
+                return false;
             }
-            Geom::OptRect box = item->documentVisualBounds();
-            if (box && test(area, *box)) {
-                s.push_back(item);
+        }
+        return false;
+    };
+
+    for (auto item : index.intersecting(area)) {
+        if (!is_eligible(item)) {
+            continue;
+        }
+        if (auto group = cast<SPGroup>(item)) {
+            bool is_layer = group->effectiveLayerMode(dkey) == SPGroup::LAYER;
+            if (!take_groups || (enter_layers && is_layer)) {
+                continue;
             }
         }
+        Geom::OptRect box = item->documentVisualBounds();
+        if (box && test(area, *box) && is_reachable(item)) {
+            s.push_back(item);
+        }
     }
+
+    // Restore traversal order: document order, with groups following their own descendants.
+    std::sort(s.begin(), s.end(), [] (SPItem const *a, SPItem const *b) {
+        if (a->isAncestorOf(b)) {
+            return false;
+        }
+        if (b->isAncestorOf(a)) {
+            return true;
+        }
+        return sp_object_compare_position_bool(a, b);
+    });
+
     return s;
 }
 
@@ -1650,20 +1696,44 @@ std::deque<SPItem*> const &SPDocument::get_flat_item_list(unsigned int dkey, boo
     auto const [it, inserted] = _node_cache.try_emplace(key);
     if (inserted) {
         _build_flat_item_list(it->second, root, dkey, into_groups, active_only);
+
+        auto &ranks = _node_rank_cache[key];
+        ranks.clear();
+        ranks.reserve(it->second.size());
+        for (std::size_t i = 0; i < it->second.size(); i++) {
+            ranks.emplace(it->second[i], i);
+        }
     }
     return it->second;
 }
 
+/**
+Position of each item in the list returned by get_flat_item_list, used to put
+items found through the spatial index back into z-order.
+*/
+std::unordered_map<SPItem const *, std::size_t> const &SPDocument::get_flat_item_ranks(unsigned int dkey, bool into_groups, bool active_only) const
+{
+    using key_t = decltype(_node_cache)::key_type;
+    auto const key = (key_t{dkey} << 2) | (into_groups << 1) | active_only;
+
+    get_flat_item_list(dkey, into_groups, active_only);
+    return _node_rank_cache[key];
+}
+
 /**
 Returns the items from the descendants of group (recursively) which are at the
 point p, or NULL if none. Honors into_groups on whether to recurse into non-layer
 groups or not. Honors take_insensitive on whether to return insensitive items.
 If upto != NULL, then if item upto is encountered (at any level), stops searching
 upwards in z-order and returns what it has found so far (i.e. the found items are
-guaranteed to be lower than upto). Requires a list of nodes built by build_flat_item_list.
+guaranteed to be lower than upto). Requires a list of nodes built by build_flat_item_list,
+and the rank of each of them in that list.
+Only the items the spatial index places near p are picked.
 If items_count > 0, it'll return the topmost (in z-order) items_count items.
  */
-static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes, unsigned dkey,
+static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes,
+                                                std::unordered_map<SPItem const *, std::size_t> const &ranks,
+                                                Inkscape::ItemSpatialIndex const &index, SPItem const *root, unsigned dkey,
                                                 Geom::Point const &p, int items_count = 0, SPItem *upto = nullptr)
 {
     double const delta = Inkscape::Preferences::get()->getDouble("/options/cursortolerance/value", 1.0);
@@ -1671,14 +1741,33 @@ static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes
 
     std::vector<SPItem*> result;
 
-    bool seen_upto = !upto;
-    for (auto node : nodes) {
-        if (!seen_upto) {
-            if (node == upto) {
-                seen_upto = true;
+    std::size_t first = 0;
+    if (upto) {
+        auto const it = ranks.find(upto);
+        if (it == ranks.end()) {
+            return result;
+        }
+        first = it->second + 1;
+    }
+
+    std::vector<SPItem*> candidates;
+    if (auto root_item = root->get_arenaitem(dkey)) {
+        // p and delta are in drawing coordinates; allow an extra pixel for antialiasing.
+        auto const area = Geom::Rect(p, p).expandedBy(delta + 1.0) * root_item->ctm().inverse();
+        for (auto item : index.intersecting(area)) {
+            auto const it = ranks.find(item);
+            if (it != ranks.end() && it->second >= first) {
+                candidates.push_back(item);
             }
-            continue;
         }
+        std::sort(candidates.begin(), candidates.end(), [&] (SPItem const *a, SPItem const *b) {
+            return ranks.at(a) < ranks.at(b);
+        });
+    } else {
+        candidates.assign(nodes.begin() + first, nodes.end());
+    }
+
+    for (auto node : candidates) {
         if (auto di = node->get_arenaitem(dkey)) {
             if (!outline) {
                 if (auto cid = di->drawing().getCanvasItemDrawing()) {
@@ -1698,9 +1787,12 @@ static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes
     return result;
 }
 
-static SPItem *find_item_at_point(std::deque<SPItem*> const &nodes, unsigned dkey, Geom::Point const &p, SPItem *upto = nullptr)
+static SPItem *find_item_at_point(std::deque<SPItem*> const &nodes,
+                                  std::unordered_map<SPItem const *, std::size_t> const &ranks,
+                                  Inkscape::ItemSpatialIndex const &index, SPItem const *root, unsigned dkey,
+                                  Geom::Point const &p, SPItem *upto = nullptr)
 {
-    auto items = find_items_at_point(nodes, dkey, p, 1, upto);
+    auto items = find_items_at_point(nodes, ranks, index, root, dkey, p, 1, upto);
     if (items.empty()) {
         return nullptr;
     }
@@ -1747,8 +1839,7 @@ static SPItem *find_group_at_point(unsigned dkey, SPGroup *group, Geom::Point co
 
 std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups, bool enter_layers) const
 {
-    std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, is_within, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
+    return find_items_in_area(*_spatial_index, this->root, dkey, box, is_within, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
 }
 
 /**
@@ -1764,8 +1855,7 @@ std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect con
 
 std::vector<SPItem*> SPDocument::getItemsPartiallyInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups, bool enter_layers) const
 {
-    std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, overlaps, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
+    return find_items_in_area(*_spatial_index, this->root, dkey, box, overlaps, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
 }
 
 std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vector<Geom::Point> points, bool all_layers, bool topmost_only, size_t limit, bool active_only) const
@@ -1780,6 +1870,7 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     prefs->setDouble("/options/cursortolerance/value", 0.25);
 
     auto &node_cache = get_flat_item_list(key, true, active_only);
+    auto &node_ranks = get_flat_item_ranks(key, true, active_only);
 
     SPObject *current_layer = nullptr;
     SPDesktop *desktop = SP_ACTIVE_DESKTOP;
@@ -1788,7 +1879,7 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     }
     size_t item_counter = 0;
     for(auto point : points) {
-        std::vector<SPItem*> items = find_items_at_point(node_cache, key, point, topmost_only);
+        std::vector<SPItem*> items = find_items_at_point(node_cache, node_ranks, *_spatial_index, root, key, point, topmost_only);
         for (SPItem *item : items) {
             if (item && result.end()==find(result.begin(), result.end(), item))
                 if(all_layers || (desktop && desktop->layerManager().layerForObject(item) == current_layer)){
@@ -1812,7 +1903,8 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
 SPItem *SPDocument::getItemAtPoint( unsigned const key, Geom::Point const &p,
                                     bool const into_groups, SPItem *upto) const
 {
-    return find_item_at_point(get_flat_item_list(key, into_groups, true), key, p, upto);
+    return find_item_at_point(get_flat_item_list(key, into_groups, true), get_flat_item_ranks(key, into_groups, true),
+                              *_spatial_index, root, key, p, upto);
 }
 
 SPItem *SPDocument::getGroupAtPoint(unsigned int key, Geom::Point const &p) const
@@ -1831,9 +1923,9 @@ bool SPDocument::addResource(gchar const *key, SPObject *object)
     bool result = false;
 
     if ( !object->cloned ) {
-        std::vector<SPObject *> rlist = resources[key];
+        auto &rlist = resources[key];
         g_return_val_if_fail(std::find(rlist.begin(),rlist.end(),object) == rlist.end(), false);
-        resources[key].insert(resources[key].begin(),object);
+        rlist.push_back(object);
 
         GQuark q = g_quark_from_string(key);
 
@@ -1864,11 +1956,12 @@ bool SPDocument::removeResource(gchar const *key, SPObject *object)
     bool result = false;
 
     if ( !object->cloned ) {
-        std::vector<SPObject *> rlist = resources[key];
+        auto &rlist = resources[key];
         g_return_val_if_fail(!rlist.empty(), false);
-        std::vector<SPObject*>::iterator it = std::find(resources[key].begin(),resources[key].end(),object);
-        g_return_val_if_fail(it != rlist.end(), false);
-        resources[key].erase(it);
+        // Objects are mostly removed in the reverse order of being added
+        auto it = std::find(rlist.rbegin(), rlist.rend(), object);
+        g_return_val_if_fail(it != rlist.rend(), false);
+        rlist.erase(std::next(it).base());
 
         GQuark q = g_quark_from_string(key);
         resources_changed_signals[q].emit();
@@ -1885,7 +1978,12 @@ std::vector<SPObject *> const SPDocument::getResourceList(gchar const *key)
     g_return_val_if_fail(key != nullptr, emptyset);
     g_return_val_if_fail(*key != '\0', emptyset);
 
-    return resources[key];
+    // Most recently added first
+    auto it = resources.find(key);
+    if (it == resources.end()) {
+        return emptyset;
+    }
+    return {it->second.rbegin(), it->second.rend()};
 }
 
 void SPDocument::process_pending_resource_changes()
@@ -2048,6 +2146,9 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
 
     std::string DuplicateDefString = "RESERVED_FOR_INKSCAPE_DUPLICATE_DEF";
 
+    // References to duplicates are redirected after each pass, finding all references only once.
+    std::vector<std::pair<std::string, SPObject *>> replacements;
+
     /* First pass: remove duplicates in clipboard of definitions in document */
     for (Inkscape::XML::Node *def = defs->firstChild() ; def ; def = def->next()) {
         if(def->type() != Inkscape::XML::NodeType::ELEMENT_NODE)continue;
@@ -2058,6 +2159,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
         if( defid.find( DuplicateDefString ) != Glib::ustring::npos )break;
 
         SPObject *src = source->getObjectByRepr(def);
+        bool replaced = false; // Only the first duplicate found takes over the references
 
         // Prevent duplicates of solid swatches by checking if equivalent swatch already exists
         auto s_gr = cast<SPGradient>(src);
@@ -2069,9 +2171,10 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (s_gr->isEquivalent(t_gr)) {
                         // Change object references to the existing equivalent gradient
                         Glib::ustring newid = trg.getId();
-                        if (newid != defid) { // id could be the same if it is a second paste into the same document
-                            change_def_references(src, &trg);
+                        if (newid != defid && !replaced) { // id could be the same if it is a second paste into the same document
+                            replacements.emplace_back(defid, &trg);
                         }
+                        replaced = true;
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         def->setAttribute("id", longid);
                         g_free(longid);
@@ -2083,9 +2186,10 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (t_lpeobj->is_similar(s_lpeobj)) {
                         // Change object references to the existing equivalent gradient
                         Glib::ustring newid = trg.getId();
-                        if (newid != defid) { // id could be the same if it is a second paste into the same document
-                            change_def_references(src, &trg);
+                        if (newid != defid && !replaced) { // id could be the same if it is a second paste into the same document
+                            replacements.emplace_back(defid, &trg);
                         }
+                        replaced = true;
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         def->setAttribute("id", longid);
                         g_free(longid);
@@ -2096,6 +2200,9 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
         }
     }
 
+    change_def_references(source, replacements);
+    replacements.clear();
+
     /* Second pass: remove duplicates in clipboard of earlier definitions in clipboard */
     for (Inkscape::XML::Node *def = defs->firstChild() ; def ; def = def->next()) {
         if(def->type() != Inkscape::XML::NodeType::ELEMENT_NODE)continue;
@@ -2115,7 +2222,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (t_gr && s_gr->isEquivalent(t_gr)) {
                         // Change object references to the existing equivalent gradient
                         // two id's in the clipboard should never be the same, so always change references
-                        change_def_references(trg, src);
+                        replacements.emplace_back(newid, src);
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         laterDef->setAttribute("id", longid);
                         g_free(longid);
@@ -2130,7 +2237,7 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
                     if (t_lpeobj->is_similar(s_lpeobj)) {
                         // Change object references to the existing equivalent gradient
                         // two id's in the clipboard should never be the same, so always change references
-                        change_def_references(trg, src);
+                        replacements.emplace_back(newid, src);
                         gchar *longid = g_strdup_printf("%s_%9.9d", DuplicateDefString.c_str(), stagger++);
                         laterDef->setAttribute("id", longid);
                         g_free(longid);
@@ -2141,6 +2248,8 @@ void SPDocument::_importDefsNode(SPDocument *source, Inkscape::XML::Node *defs,
         }
     }
 
+    change_def_references(source, replacements);
+
     /* Final pass: copy over those parts which are not duplicates  */
     for (Inkscape::XML::Node *def = defs->firstChild() ; def ; def = def->next()) {
         if(def->type() != Inkscape::XML::NodeType::ELEMENT_NODE)continue;
@@ -25,6 +25,8 @@
 #include <queue>                               // for queue
 #include <span>
 #include <string>                              // for string
+#include <string_view>                         // for string_view
+#include <unordered_map>                       // for unordered_map
 #include <vector>                              // for vector
 
 #include <boost/ptr_container/ptr_list.hpp>    // for ptr_list
@@ -77,14 +79,17 @@ class SPObject;
 class SPRoot;
 
 namespace Inkscape {
+    class BuildCache;
     class DocumentUndo;
     class Event;
     class EventLog;
+    class ItemSpatialIndex;
     class PageManager;
     namespace Colors {
         class DocumentCMS;
     }
     class Selection;
+    class StyleSheetIndex;
     class UndoStackObserver;
     namespace XML {
         struct Document;
@@ -177,11 +182,12 @@ private:
 
     // Find items by geometry --------------------
     std::deque<SPItem*> const &get_flat_item_list(unsigned int dkey, bool into_groups, bool active_only) const;
+    std::unordered_map<SPItem const *, std::size_t> const &get_flat_item_ranks(unsigned int dkey, bool into_groups, bool active_only) const;
 
     SPDocument *_searchForChild(std::string const &filename, SPDocument const *avoid = nullptr);
 
 public:
-    void clearNodeCache() { _node_cache.clear(); }
+    void clearNodeCache() { _node_cache.clear(); _node_rank_cache.clear(); }
     void importDefs(SPDocument *source);
 
     unsigned int vacuumDocument();
@@ -214,8 +220,19 @@ public:
 
     Inkscape::Selection *getSelection() { return _selection.get(); }
 
+    /** Spatial index of item bounds, kept up to date by SPItem. */
+    Inkscape::ItemSpatialIndex &getSpatialIndex() { return *_spatial_index; }
+    Inkscape::ItemSpatialIndex const &getSpatialIndex() const { return *_spatial_index; }
+
+    /** Attribute values parsed ahead of time, while the object tree is being built; otherwise null. */
+    Inkscape::BuildCache *getBuildCache() { return _build_cache.get(); }
+
     // Styling
     CRCascade    *getStyleCascade() { return style_cascade; }
+    /** Index of the style sheet rules, or null if the style sheets can only be matched by libcroco. */
+    Inkscape::StyleSheetIndex const *getStyleSheetIndex();
+    /** To be called whenever a style sheet of the cascade changes. */
+    void invalidateStyleSheetIndex() { _style_sheet_index.reset(); }
 
     // File information --------------------
 
@@ -392,6 +409,7 @@ private:
 
     // Styling
     CRCascade *style_cascade;
+    std::unique_ptr<Inkscape::StyleSheetIndex> _style_sheet_index; // Built on demand.
 
     // Desktop geometry
     mutable Geom::Affine _doc2dt;
@@ -402,11 +420,20 @@ private:
     char *document_name;  ///< basename or other human-readable label for the document.
 
     // Find items ----------------------------
-    std::map<std::string, SPObject *> iddef;
-    std::map<Inkscape::XML::Node *, SPObject *> reprdef;
+    /// Hashes ids given as any kind of string, so that lookups need not copy them into a std::string.
+    struct IdHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view id) const { return std::hash<std::string_view>{}(id); }
+    };
+    std::unordered_map<std::string, SPObject *, IdHash, std::equal_to<>> iddef;
+    std::unordered_map<Inkscape::XML::Node *, SPObject *> reprdef;
 
     // Find items by geometry --------------------
     mutable std::map<unsigned long, std::deque<SPItem*>> _node_cache; // Used to speed up search.
+    mutable std::map<unsigned long, std::unordered_map<SPItem const *, std::size_t>> _node_rank_cache; // Position in _node_cache.
+    std::unique_ptr<Inkscape::ItemSpatialIndex> _spatial_index; // Document bounds of all items.
+    std::unique_ptr<Inkscape::BuildCache> _build_cache;
 
     // Box tool ----------------------------
     Persp3D *current_persp3d; /**< Currently 'active' perspective (to which, e.g., newly created boxes are attached) */
@@ -421,6 +448,7 @@ private:
     Inkscape::XML::Event * partial; /* partial undo log when interrupted */
     std::deque<Inkscape::Event *> undo; /* Undo stack of reprs */
     std::deque<Inkscape::Event *> redo; /* Redo stack of reprs */
+    std::size_t undo_bytes = 0; /* Approximate memory used by the undo stack */
     /* Undo listener */
     Inkscape::CompositeUndoStackObserver undoStackObservers;
 
@@ -488,7 +516,7 @@ public:
     sigc::connection connectReconstructionFinish(ReconstructionFinish::slot_type slot);
 
     /* Resources */
-    std::map<std::string, std::vector<SPObject *> > resources;
+    std::unordered_map<std::string, std::vector<SPObject *>> resources; ///< In the order they were added.
     ResourcesChangedSignalMap resources_changed_signals; // Used by Extension::Internal::Filter
 
     void _emitModified();  // Used by SPItem
@@ -17,6 +17,7 @@
 
 #include <glibmm/ustring.h>
 
+#include <cstddef>
 #include <utility>
 
 #include "xml/event-fns.h"
@@ -34,14 +35,22 @@ class Event {
 public:
 
     Event(XML::Event *_event, Glib::ustring _description="", Glib::ustring _icon_name="")
-        : event (_event), description (std::move(_description)), icon_name (std::move(_icon_name))  { }
+        : event (_event), description (std::move(_description)), icon_name (std::move(_icon_name))
+        , bytes (sp_repr_log_bytes(_event)) { }
 
     virtual ~Event() { sp_repr_free_log (event); }
 
+    /// Store the event in less memory, once no more changes will be added to it.
+    void compact() {
+        sp_repr_compact_log(event);
+        bytes = sp_repr_log_bytes(event);
+    }
+
     XML::Event *event;
     unsigned int type = 0;
     Glib::ustring description; // The description to use in the Undo dialog.
     Glib::ustring icon_name;   // The icon to use in the Undo dialog.
+    std::size_t bytes;         // Approximate memory used by the event.
 };
 
 } // namespace Inkscape
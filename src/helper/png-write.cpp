@@ -15,10 +15,17 @@
  */
 
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
 
 #include <png.h>
+#include <zlib.h>
 
 #include "document.h"
 #include "png-write.h"
@@ -27,6 +34,8 @@
 #include "display/cairo-utils.h"
 #include "display/drawing-context.h"
 #include "display/drawing.h"
+#include "display/task-scheduler.h"
+#include "display/threading.h"
 
 #include "io/sys.h"
 
@@ -55,6 +64,7 @@ struct SPEBP {
     guchar *px;
     unsigned (*status)(float, void *);
     void *data;
+    bool aborted;
 };
 
 /* write a png file */
@@ -120,8 +130,259 @@ void PngTextList::add(gchar const* key, gchar const* text)
     }
 }
 
+/**
+ * Collect the document metadata that is stored as PNG text chunks.
+ */
+static void
+sp_png_text_list(SPDocument *doc, PngTextList &textList)
+{
+    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
+    {
+        const gchar* pngToDc[] = {"Title", "title",
+                               "Author", "creator",
+                               "Description", "description",
+                               //"Copyright", "",
+                               "Creation Time", "date",
+                               //"Disclaimer", "",
+                               //"Warning", "",
+                               "Source", "source"
+                               //"Comment", ""
+        };
+        for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
+            struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
+            if (entity) {
+                gchar const* data = rdf_get_work_entity(doc, entity);
+                if (data && *data) {
+                    textList.add(pngToDc[i], data);
+                }
+            } else {
+                g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
+            }
+        }
+
+
+        struct rdf_license_t *license =  rdf_get_license(doc, true);
+        if (license) {
+            if (license->name && license->uri) {
+                gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
+                textList.add("Copyright", tmp);
+                g_free(tmp);
+            } else if (license->name) {
+                textList.add("Copyright", license->name);
+            } else if (license->uri) {
+                textList.add("Copyright", license->uri);
+            }
+        }
+    }
+}
+
+static guchar const *sp_export_render_rows(SPEBP const &ebp, guchar const **rows, int row, int num_rows,
+                                           int color_type, int bit_depth);
+
+/**
+ * Write a PNG chunk. Used for the image data written by sp_png_write_image_parallel().
+ */
+static bool sp_png_write_chunk(FILE *fp, char const *type, guchar const *data, size_t length)
+{
+    png_byte header[8];
+    png_save_uint_32(header, length);
+    std::memcpy(header + 4, type, 4);
+
+    png_byte trailer[4];
+    uLong crc = crc32(0, header + 4, 4);
+    if (length > 0) {
+        crc = crc32(crc, data, length);
+    }
+    png_save_uint_32(trailer, crc);
+
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header) &&
+           (length == 0 || fwrite(data, 1, length, fp) == length) &&
+           fwrite(trailer, 1, sizeof(trailer), fp) == sizeof(trailer);
+}
+
+/**
+ * Filter the rows of a block the way libpng does, choosing for each row the filter with the
+ * smallest sum of absolute differences. The first row of a block has no prior row to refer to,
+ * so it only tries the filters that do not need one.
+ *
+ * @param out Receives each row preceded by its filter type byte.
+ */
+static void sp_png_filter_rows(guchar *out, guchar const *in, int num_rows, size_t rowbytes, int bpp, bool filter)
+{
+    std::vector<guchar> scratch(filter ? 5 * rowbytes : 0);
+
+    for (int r = 0; r < num_rows; r++) {
+        auto const cur = in + r * rowbytes;
+        auto const prev = r > 0 ? cur - rowbytes : nullptr;
+        auto const dest = out + r * (rowbytes + 1);
+
+        int best = PNG_FILTER_VALUE_NONE;
+
+        if (filter) {
+            int const count = prev ? 5 : 2;
+            unsigned long best_sum = ~0UL;
+            for (int type = 0; type < count; type++) {
+                auto const row = scratch.data() + type * rowbytes;
+                for (size_t i = 0; i < rowbytes; i++) {
+                    int const a = i >= static_cast<size_t>(bpp) ? cur[i - bpp] : 0;
+                    int const b = prev ? prev[i] : 0;
+                    int const c = prev && i >= static_cast<size_t>(bpp) ? prev[i - bpp] : 0;
+                    int predictor = 0;
+                    switch (type) {
+                        case PNG_FILTER_VALUE_SUB:
+                            predictor = a;
+                            break;
+                        case PNG_FILTER_VALUE_UP:
+                            predictor = b;
+                            break;
+                        case PNG_FILTER_VALUE_AVG:
+                            predictor = (a + b) / 2;
+                            break;
+                        case PNG_FILTER_VALUE_PAETH: {
+                            int const pa = std::abs(b - c);
+                            int const pb = std::abs(a - c);
+                            int const pc = std::abs(a + b - 2 * c);
+                            predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+                            break;
+                        }
+                        default:
+                            break;
+                    }
+                    row[i] = cur[i] - predictor;
+                }
+
+                unsigned long sum = 0;
+                for (size_t i = 0; i < rowbytes; i++) {
+                    sum += row[i] < 128 ? row[i] : 256 - row[i];
+                }
+                if (sum < best_sum) {
+                    best_sum = sum;
+                    best = type;
+                }
+            }
+        }
+
+        dest[0] = best;
+        std::memcpy(dest + 1, best == PNG_FILTER_VALUE_NONE ? cur : scratch.data() + best * rowbytes, rowbytes);
+    }
+}
+
+/**
+ * Write the image data of a non-interlaced PNG, after the header has been written by libpng.
+ *
+ * The image is divided into blocks of rows, each of which is rendered, filtered and deflated by a
+ * background task of its own, so that a large export does not hold up redrawing the canvas. Blocks are compressed independently and end with a sync flush, so that their
+ * output can simply be concatenated into a single zlib stream (as pigz does). The calling thread
+ * writes the blocks out in order while the following ones are being prepared, and only a few
+ * blocks are in flight at any time, which bounds memory use.
+ */
+static bool sp_png_write_image_parallel(FILE *fp, SPEBP &ebp, size_t rowbytes, int color_type, int bit_depth,
+                                        int zlib)
+{
+    struct Block
+    {
+        explicit Block(std::shared_ptr<Inkscape::task_scheduler> scheduler)
+            : group(std::move(scheduler))
+        {}
+
+        std::vector<guchar> out;
+        uLong adler = 0;
+        size_t length = 0;
+        // Declared last, so that it waits for the task before the output is destroyed.
+        Inkscape::task_group group;
+    };
+
+    auto const scheduler = Inkscape::get_global_task_scheduler();
+    size_t const max_in_flight = std::max(scheduler->size() + 1, 2);
+
+    int const height = ebp.height;
+    int const block_rows = std::clamp<size_t>((1 << 20) / rowbytes, 64, 4096);
+    int const bpp = std::max((1 + (color_type & 2) + (color_type & 4) / 4) * bit_depth / 8, 1);
+    // Like libpng, only filter images with whole bytes per sample.
+    bool const filter = bit_depth >= 8;
+    int const level = zlib >= 0 ? std::min(zlib, 9) : Z_DEFAULT_COMPRESSION;
+
+    auto const compress = [&](Block &block, int row, int num_rows) {
+        std::vector<guchar> filtered(num_rows * (rowbytes + 1));
+        {
+            std::vector<guchar const *> rows(num_rows);
+            auto const px = sp_export_render_rows(ebp, rows.data(), row, num_rows, color_type, bit_depth);
+            sp_png_filter_rows(filtered.data(), px, num_rows, rowbytes, bpp, filter);
+            free((void *)px);
+        }
+
+        block.adler = adler32(adler32(0, nullptr, 0), filtered.data(), filtered.size());
+        block.length = filtered.size();
+
+        z_stream zs{};
+        if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, filter ? Z_FILTERED : Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("deflateInit2 failed");
+        }
+        zs.next_in = filtered.data();
+        zs.avail_in = filtered.size();
+
+        // The last block terminates the deflate stream, the others end on a byte boundary.
+        int const flush = row + num_rows == height ? Z_FINISH : Z_SYNC_FLUSH;
+        block.out.resize(deflateBound(&zs, filtered.size()) + 16);
+        while (true) {
+            zs.next_out = block.out.data() + zs.total_out;
+            zs.avail_out = block.out.size() - zs.total_out;
+            if (deflate(&zs, flush) == Z_STREAM_ERROR) {
+                deflateEnd(&zs);
+                throw std::runtime_error("deflate failed");
+            }
+            if (zs.avail_out != 0) {
+                break;
+            }
+            block.out.resize(block.out.size() * 2);
+        }
+        block.out.resize(zs.total_out);
+        deflateEnd(&zs);
+    };
+
+    // The zlib stream header: deflate with a 32K window, and the compression level as a hint.
+    static guchar const levels[] = {0x01, 0x01, 0x5e, 0x5e, 0x5e, 0x5e, 0x9c, 0xda, 0xda, 0xda};
+    guchar const zlib_header[] = {0x78, level < 0 ? guchar{0x9c} : levels[level]};
+    if (!sp_png_write_chunk(fp, "IDAT", zlib_header, sizeof(zlib_header))) {
+        return false;
+    }
+
+    std::deque<Block> blocks;
+    uLong adler = adler32(0, nullptr, 0);
+    int submitted = 0;
+    int written = 0;
+
+    while (written < height) {
+        while (submitted < height && blocks.size() < max_in_flight) {
+            int const row = submitted;
+            int const num_rows = std::min(block_rows, height - row);
+            auto &block = blocks.emplace_back(scheduler);
+            block.group.run([&compress, &block, row, num_rows] { compress(block, row, num_rows); });
+            submitted += num_rows;
+        }
+
+        if (ebp.status && !ebp.status(static_cast<float>(written) / height, ebp.data)) {
+            ebp.aborted = true;
+            return false;
+        }
+
+        auto &block = blocks.front();
+        block.group.wait();
+        if (!sp_png_write_chunk(fp, "IDAT", block.out.data(), block.out.size())) {
+            return false;
+        }
+        adler = adler32_combine(adler, block.adler, block.length);
+        written = std::min(written + block_rows, height);
+        blocks.pop_front();
+    }
+
+    png_byte trailer[4];
+    png_save_uint_32(trailer, adler);
+    return sp_png_write_chunk(fp, "IDAT", trailer, sizeof(trailer)) && sp_png_write_chunk(fp, "IEND", nullptr, 0);
+}
+
 static bool
-sp_png_write_rgba_striped(SPDocument *doc,
+sp_png_write_rgba_striped(PngTextList &textList,
                           gchar const *filename, unsigned long int width, unsigned long int height, double xdpi, double ydpi,
                           int (* get_rows)(guchar const **rows, void **to_free, int row, int num_rows, void *data, int color_type, int bit_depth),
                           void *data, bool interlace, int color_type, int bit_depth, int zlib)
@@ -207,46 +468,6 @@ sp_png_write_rgba_striped(SPDocument *doc,
         png_set_sBIT(png_ptr, info_ptr, &sig_bit);
     }
 
-    PngTextList textList;
-
-    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
-    {
-        const gchar* pngToDc[] = {"Title", "title",
-                               "Author", "creator",
-                               "Description", "description",
-                               //"Copyright", "",
-                               "Creation Time", "date",
-                               //"Disclaimer", "",
-                               //"Warning", "",
-                               "Source", "source"
-                               //"Comment", ""
-        };
-        for (size_t i = 0; i < G_N_ELEMENTS(pngToDc); i += 2) {
-            struct rdf_work_entity_t * entity = rdf_find_entity ( pngToDc[i + 1] );
-            if (entity) {
-                gchar const* data = rdf_get_work_entity(doc, entity);
-                if (data && *data) {
-                    textList.add(pngToDc[i], data);
-                }
-            } else {
-                g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
-            }
-        }
-
-
-        struct rdf_license_t *license =  rdf_get_license(doc, true);
-        if (license) {
-            if (license->name && license->uri) {
-                gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
-                textList.add("Copyright", tmp);
-                g_free(tmp);
-            } else if (license->name) {
-                textList.add("Copyright", license->name);
-            } else if (license->uri) {
-                textList.add("Copyright", license->uri);
-            }
-        }
-    }
     if (textList.getCount() > 0) {
         png_set_text(png_ptr, info_ptr, textList.getPtext(), textList.getCount());
     }
@@ -274,6 +495,21 @@ sp_png_write_rgba_striped(SPDocument *doc,
 
     /* --- CUT --- */
 
+    // Non-interlaced images are rendered and compressed in parallel, with libpng only writing the header.
+    if (!interlace) {
+        auto const rowbytes = png_get_rowbytes(png_ptr, info_ptr);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+
+        bool success = false;
+        try {
+            success = sp_png_write_image_parallel(fp, *ebp, rowbytes, color_type, bit_depth, zlib);
+        } catch (std::exception const &e) {
+            g_warning("PNG export failed: %s", e.what());
+        }
+
+        return fclose(fp) == 0 && success;
+    }
+
     /* The easiest way to write the image (you may have a different memory
      * layout, however, so choose what fits your needs best).  You need to
      * use the first method if you aren't handling interlacing yourself.
@@ -325,47 +561,63 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
     struct SPEBP *ebp = (struct SPEBP *) data;
 
     if (ebp->status) {
-        if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
+        if (!ebp->status((float) row / ebp->height, ebp->data)) {
+            ebp->aborted = true;
+            return 0;
+        }
     }
 
     num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
     num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
 
+    *to_free = (void *)sp_export_render_rows(*ebp, rows, row, num_rows, color_type, bit_depth);
+
+    return num_rows;
+}
+
+/**
+ * Render rows of the export, converted to the PNG sample format.
+ *
+ * May be called from several threads at once, since the drawing is snapshotted.
+ *
+ * @return The buffer holding the rows, to be released with free().
+ */
+static guchar const *
+sp_export_render_rows(SPEBP const &ebp, guchar const **rows, int row, int num_rows, int color_type, int bit_depth)
+{
     /* Set area of interest */
     // bbox is now set to the entire image to prevent discontinuities
     // in the image when blur is used (the borders may still be a bit
     // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
+    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp.width, num_rows);
 
-    /* Update to renderable state */
-    ebp->drawing->update(bbox);
+    // The drawing was already brought up to date by PngExportJob, for the whole image.
 
-    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp.width);
     unsigned char *px = g_new(guchar, num_rows * stride);
 
     cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
+        px, CAIRO_FORMAT_ARGB32, ebp.width, num_rows, stride);
     Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
+    dc.setSource(ebp.background);
     dc.setOperator(CAIRO_OPERATOR_SOURCE);
     dc.paint();
     dc.setOperator(CAIRO_OPERATOR_OVER);
 
     /* Render */
-    ebp->drawing->render(dc, bbox, 0);
+    ebp.drawing->render(dc, bbox, 0);
     cairo_surface_destroy(s);
 
     // PNG stores data as unpremultiplied big-endian RGBA, which means
     // it's identical to the GdkPixbuf format.
-    convert_pixels_argb32_to_pixbuf(px, ebp->width, num_rows, stride,
-                                    /* RGBA to ARGB with A=0 */ ebp->background >> 8);
+    convert_pixels_argb32_to_pixbuf(px, ebp.width, num_rows, stride,
+                                    /* RGBA to ARGB with A=0 */ ebp.background >> 8);
     
     // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
-    const guchar* new_data = pixbuf_to_png(rows, px, num_rows, ebp->width, stride, color_type, bit_depth);
-    *to_free = (void*) new_data;
-    free(px);
+    const guchar* new_data = pixbuf_to_png(rows, px, num_rows, ebp.width, stride, color_type, bit_depth);
+    g_free(px);
 
-    return num_rows;
+    return new_data;
 }
 
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
@@ -404,6 +656,29 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
 	return EXPORT_ABORTED;
     }
 
+    PngExportJob job(doc, filename, area, width, height, xdpi, ydpi, bgcolor, items_only, interlace, color_type,
+                     bit_depth, zlib, antialiasing);
+    return job.run(status, data);
+}
+
+PngExportJob::PngExportJob(SPDocument *doc, std::string filename, Geom::Rect const &area,
+                           unsigned long width, unsigned long height, double xdpi, double ydpi,
+                           unsigned long bgcolor, std::vector<SPItem const *> const &items_only,
+                           bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
+    : _doc(doc)
+    , _filename(std::move(filename))
+    , _width(width)
+    , _height(height)
+    , _xdpi(xdpi)
+    , _ydpi(ydpi)
+    , _bgcolor(bgcolor)
+    , _interlace(interlace)
+    , _color_type(color_type)
+    , _bit_depth(bit_depth)
+    , _zlib(zlib)
+    , _drawing(std::make_unique<Inkscape::Drawing>())
+    , _text(std::make_unique<PngTextList>())
+{
     doc->ensureUpToDate();
 
     /* Calculate translation by transforming to document coordinates (flipping Y)*/
@@ -429,43 +704,59 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                             * Geom::Scale(width / area.width(),
                                         height / area.height()));
 
-    struct SPEBP ebp;
-    ebp.width  = width;
-    ebp.height = height;
-    ebp.background = bgcolor;
-
     /* Create new drawing */
-    Inkscape::Drawing drawing;
-    unsigned const dkey = SPItem::display_key_new(1);
-    drawing.setRoot(doc->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
-    drawing.root()->setTransform(affine);
-    drawing.setExact(); // export with maximum blur rendering quality
-    drawing.setAntialiasingOverride(static_cast<Inkscape::Antialiasing>(antialiasing));
-
-    ebp.drawing = &drawing;
+    _dkey = SPItem::display_key_new(1);
+    _drawing->setRoot(doc->getRoot()->invoke_show(*_drawing, _dkey, SP_ITEM_SHOW_DISPLAY));
+    _drawing->root()->setTransform(affine);
+    _drawing->setExact(); // export with maximum blur rendering quality
+    _drawing->setAntialiasingOverride(static_cast<Inkscape::Antialiasing>(antialiasing));
 
     // We show all and then hide all items we don't want, instead of showing only requested items,
     // because that would not work if the shown item references something in defs
     if (!items_only.empty()) {
-        doc->getRoot()->invoke_hide_except(dkey, items_only);
+        doc->getRoot()->invoke_hide_except(_dkey, items_only);
     }
 
+    // Update to renderable state, and detach from further document changes until we are done.
+    _drawing->update(Geom::IntRect::from_xywh(0, 0, width, height));
+    _drawing->snapshot();
+
+    sp_png_text_list(doc, *_text);
+}
+
+PngExportJob::~PngExportJob()
+{
+    _drawing->unsnapshot();
+
+    // Hide items, this releases arenaitem
+    _doc->getRoot()->invoke_hide(_dkey);
+}
+
+ExportResult PngExportJob::run(unsigned (*status)(float, void *), void *data)
+{
+    struct SPEBP ebp;
+    ebp.width  = _width;
+    ebp.height = _height;
+    ebp.background = _bgcolor;
+    ebp.drawing = _drawing.get();
     ebp.status = status;
     ebp.data   = data;
+    ebp.aborted = false;
 
     bool write_status = false;;
 
     ebp.sheight = 64;
-    ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
+    ebp.px = g_try_new(guchar, 4 * ebp.sheight * _width);
 
     if (ebp.px) {
-        write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib);
+        write_status = sp_png_write_rgba_striped(*_text, _filename.c_str(), _width, _height, _xdpi, _ydpi,
+                                                 sp_export_get_rows, &ebp, _interlace, _color_type, _bit_depth, _zlib);
         g_free(ebp.px);
     }
 
-    // Hide items, this releases arenaitem
-    doc->getRoot()->invoke_hide(dkey);
-
+    if (ebp.aborted) {
+        return EXPORT_ABORTED;
+    }
     return write_status ? EXPORT_OK : EXPORT_ERROR;
 }
 
@@ -16,13 +16,20 @@
  */
 
 #include <glib.h> // Only for gchar.
+#include <memory>
+#include <string>
 #include <vector>
 
 #include <2geom/forward.h>
 
+class PngTextList;
 class SPDocument;
 class SPItem;
 
+namespace Inkscape {
+class Drawing;
+} // namespace Inkscape
+
 enum ExportResult {
     EXPORT_ERROR = 0,
     EXPORT_OK,
@@ -70,4 +77,47 @@ ExportResult sp_export_png_file(SPDocument *doc,
                                 int zlib = 6,
                                 int antialiasing = 2);
 
+/**
+ * A PNG export split into the steps that must run on the main thread and the rendering, which
+ * may run on any thread.
+ *
+ * The constructor shows the document in a private drawing and brings it up to date; the
+ * destructor hides it again. Both must be called on the main thread. In between, run() only
+ * touches that drawing and the output file, so several jobs for the same document can be run
+ * concurrently, sharing its fonts and decoded images.
+ */
+class PngExportJob
+{
+public:
+    PngExportJob(SPDocument *doc, std::string filename, Geom::Rect const &area,
+                 unsigned long width, unsigned long height, double xdpi, double ydpi,
+                 unsigned long bgcolor, std::vector<SPItem const *> const &items_only = {},
+                 bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6,
+                 int antialiasing = 2);
+    ~PngExportJob();
+
+    PngExportJob(PngExportJob const &) = delete;
+    PngExportJob &operator=(PngExportJob const &) = delete;
+
+    ExportResult run(unsigned (*status)(float, void *) = nullptr, void *data = nullptr);
+
+    std::string const &filename() const { return _filename; }
+
+private:
+    SPDocument *_doc;
+    std::string _filename;
+    unsigned long _width;
+    unsigned long _height;
+    double _xdpi;
+    double _ydpi;
+    unsigned long _bgcolor;
+    bool _interlace;
+    int _color_type;
+    int _bit_depth;
+    int _zlib;
+    unsigned _dkey;
+    std::unique_ptr<Inkscape::Drawing> _drawing;
+    std::unique_ptr<PngTextList> _text;
+};
+
 #endif // SEEN_SP_PNG_WRITE_H
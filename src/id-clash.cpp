@@ -16,10 +16,11 @@
 
 #include <cstdlib>
 #include <cstring>
-#include <list>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <glibmm/regex.h>
 
@@ -46,10 +47,14 @@ struct IdReference {
     const char *attr;  // property or href-like attribute
 };
 
-typedef std::map<Glib::ustring, std::list<IdReference> > refmap_type;
+typedef std::unordered_map<std::string, std::vector<IdReference> > refmap_type;
 
-typedef std::pair<SPObject*, Glib::ustring> id_changeitem_type;
-typedef std::list<id_changeitem_type> id_changelist_type;
+typedef std::pair<SPObject*, std::string> id_changeitem_type;
+typedef std::vector<id_changeitem_type> id_changelist_type;
+
+// An object and the id it is to be given.
+typedef std::pair<SPObject*, std::string> id_renameitem_type;
+typedef std::vector<id_renameitem_type> id_renamelist_type;
 
 const char *href_like_attributes[] = {"inkscape:connection-end",
                                       "inkscape:connection-end-point",
@@ -374,11 +379,13 @@ static void find_references(SPObject *elem, refmap_type &refmap, bool from_clipb
 }
 
 /**
- *  Change any IDs that clash with IDs in the current document, and make
- *  a list of those changes that will require fixing up references.
+ *  Choose new IDs for those that clash with IDs in the current document.
+ *  Nothing is changed yet; the new IDs are collected in renames, and also
+ *  kept in taken so that no two objects are given the same one.
  */
 static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_doc, SPObject *elem,
-                                refmap_type const &refmap, id_changelist_type *id_changes, bool from_clipboard)
+                                id_renamelist_type *renames, std::unordered_set<std::string> *taken,
+                                bool from_clipboard)
 {
     const gchar *id = elem->getId();
     bool fix_clashing_ids = true;
@@ -410,21 +417,16 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
         }
 
         if (fix_clashing_ids) {
-            std::string old_id(id);
-            std::string new_id(old_id + '-');
+            std::string new_id(std::string(id) + '-');
             for (;;) {
                 new_id += "0123456789"[std::rand() % 10];
                 const char *str = new_id.c_str();
                 if (current_doc->getObjectById(str) == nullptr &&
-                    imported_doc->getObjectById(str) == nullptr) break;
-            }
-            // Change to the new ID
-
-            elem->setAttribute("id", new_id);
-            // Make a note of this change, if we need to fix up refs to it
-            if (refmap.find(old_id) != refmap.end()) {
-                id_changes->emplace_back(elem, old_id);
+                    imported_doc->getObjectById(str) == nullptr &&
+                    taken->find(new_id) == taken->end()) break;
             }
+            taken->insert(new_id);
+            renames->emplace_back(elem, std::move(new_id));
         }
     }
 
@@ -432,7 +434,7 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
     // recurse
     for (auto& child: elem->children)
     {
-        change_clashing_ids(imported_doc, current_doc, &child, refmap, id_changes, from_clipboard);
+        change_clashing_ids(imported_doc, current_doc, &child, renames, taken, from_clipboard);
     }
 }
 
@@ -442,17 +444,35 @@ static void change_clashing_ids(SPDocument *imported_doc, SPDocument *current_do
 static void
 fix_up_refs(refmap_type const &refmap, const id_changelist_type &id_changes)
 {
-    id_changelist_type::const_iterator pp;
-    const id_changelist_type::const_iterator pp_end = id_changes.end();
-    for (pp = id_changes.begin(); pp != pp_end; ++pp) {
-        SPObject *obj = pp->first;
-        refmap_type::const_iterator pos = refmap.find(pp->second);
-        std::list<IdReference>::const_iterator it;
-        const std::list<IdReference>::const_iterator it_end = pos->second.end();
-        for (it = pos->second.begin(); it != it_end; ++it) {
-            fix_ref(*it, obj, pp->second.c_str());
+    for (auto const &[obj, old_id] : id_changes) {
+        auto pos = refmap.find(old_id);
+        if (pos == refmap.end()) {
+            continue;
+        }
+        for (auto const &idref : pos->second) {
+            fix_ref(idref, obj, old_id.c_str());
+        }
+    }
+}
+
+/**
+ *  Give each object its new ID, then fix up the references to its old ID.
+ *  The references must have been collected in refmap before any ID changed.
+ */
+static void rename_ids(refmap_type const &refmap, id_renamelist_type const &renames)
+{
+    id_changelist_type id_changes;
+    for (auto const &[elem, new_id] : renames) {
+        std::string old_id(elem->getId() ? elem->getId() : "");
+        // Change to the new ID
+        elem->setAttribute("id", new_id);
+        // Make a note of this change, if we need to fix up refs to it
+        if (refmap.find(old_id) != refmap.end()) {
+            id_changes.emplace_back(elem, std::move(old_id));
         }
     }
+
+    fix_up_refs(refmap, id_changes);
 }
 
 /**
@@ -464,12 +484,13 @@ fix_up_refs(refmap_type const &refmap, const id_changelist_type &id_changes)
 void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool from_clipboard)
 {
     refmap_type refmap;
-    id_changelist_type id_changes;
+    id_renamelist_type renames;
+    std::unordered_set<std::string> taken;
     SPObject *imported_root = imported_doc->getRoot();
 
     find_references(imported_root, refmap, from_clipboard);
-    change_clashing_ids(imported_doc, current_doc, imported_root, refmap, &id_changes, from_clipboard);
-    fix_up_refs(refmap, id_changes);
+    change_clashing_ids(imported_doc, current_doc, imported_root, &renames, &taken, from_clipboard);
+    rename_ids(refmap, renames);
 }
 
 /*
@@ -478,20 +499,28 @@ void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool
 void
 change_def_references(SPObject *from_obj, SPObject *to_obj)
 {
-    refmap_type refmap;
-    SPDocument *current_doc = from_obj->document;
-    std::string old_id(from_obj->getId());
+    change_def_references(from_obj->document, {{from_obj->getId(), to_obj}});
+}
 
-    find_references(current_doc->getRoot(), refmap, false);
+/*
+ * Change the references to each of the given ids in document into references to the paired object.
+ * The references are looked up once for all of them.
+ */
+void change_def_references(SPDocument *document, std::vector<std::pair<std::string, SPObject *>> const &replacements)
+{
+    if (replacements.empty()) {
+        return;
+    }
 
-    refmap_type::const_iterator pos = refmap.find(old_id);
-    if (pos != refmap.end()) {
-        std::list<IdReference>::const_iterator it;
-        const std::list<IdReference>::const_iterator it_end = pos->second.end();
-        for (it = pos->second.begin(); it != it_end; ++it) {
-            fix_ref(*it, to_obj, from_obj->getId());
-        }
+    refmap_type refmap;
+    find_references(document->getRoot(), refmap, false);
+
+    id_changelist_type id_changes;
+    id_changes.reserve(replacements.size());
+    for (auto const &[old_id, to_obj] : replacements) {
+        id_changes.emplace_back(to_obj, old_id);
     }
+    fix_up_refs(refmap, id_changes);
 }
 
 // This is a subset of the valid XML 1.0 ID characters.
@@ -570,46 +599,54 @@ Glib::ustring generate_similar_unique_id(SPDocument* document, const Glib::ustri
  */
 void rename_id(SPObject *elem, Glib::ustring const &new_name)
 {
-    if (new_name.empty()){
-        g_message("Invalid Id, will not change.");
-        return;
-    }
-    gchar *id = g_strdup(new_name.c_str()); //id is not empty here as new_name is check to be not empty
-    g_strcanon (id, valid_id_chars, '_');
-    Glib::ustring new_name2 = id; //will not fail as id can not be NULL, see length check on new_name
-    if (!isalnum (new_name2[0])) {
-        g_message("Invalid Id, will not change.");
-        g_free (id);
-        return;
-    }
+    rename_ids(elem->document, {{elem, new_name}});
+}
 
-    SPDocument *current_doc = elem->document;
-    refmap_type refmap;
-    find_references(current_doc->getRoot(), refmap, false);
+/*
+ * Change the ids of several SPObjects of document at once, as rename_id() does for each of them.
+ * The new ids are all chosen first; the references to the old ones are looked up and fixed once.
+ */
+void rename_ids(SPDocument *document, std::vector<std::pair<SPObject *, Glib::ustring>> const &renames)
+{
+    id_renamelist_type valid_renames;
+    std::unordered_set<std::string> taken;
+    for (auto const &[elem, new_name] : renames) {
+        if (new_name.empty()){
+            g_message("Invalid Id, will not change.");
+            continue;
+        }
+        gchar *id = g_strdup(new_name.c_str()); //id is not empty here as new_name is check to be not empty
+        g_strcanon (id, valid_id_chars, '_');
+        std::string new_name2 = id; //will not fail as id can not be NULL, see length check on new_name
+        g_free (id);
+        if (!isalnum (new_name2[0])) {
+            g_message("Invalid Id, will not change.");
+            continue;
+        }
 
-    std::string old_id(elem->getId());
-    if (current_doc->getObjectById(id)) {
-        // Choose a new ID.
-        // To try to preserve any meaningfulness that the original ID
-        // may have had, the new ID is the old ID followed by a hyphen
-        // and one or more digits.
-        new_name2 += '-';
-        for (;;) {
-            new_name2 += "0123456789"[std::rand() % 10];
-            if (current_doc->getObjectById(new_name2) == nullptr)
-                break;
+        if (document->getObjectById(new_name2) || taken.find(new_name2) != taken.end()) {
+            // Choose a new ID.
+            // To try to preserve any meaningfulness that the original ID
+            // may have had, the new ID is the old ID followed by a hyphen
+            // and one or more digits.
+            new_name2 += '-';
+            for (;;) {
+                new_name2 += "0123456789"[std::rand() % 10];
+                if (document->getObjectById(new_name2) == nullptr && taken.find(new_name2) == taken.end())
+                    break;
+            }
         }
+        taken.insert(new_name2);
+        valid_renames.emplace_back(elem, std::move(new_name2));
     }
-    g_free (id);
-    // Change to the new ID
-    elem->setAttribute("id", new_name2);
-    // Make a note of this change, if we need to fix up refs to it
-    id_changelist_type id_changes;
-    if (refmap.find(old_id) != refmap.end()) {
-        id_changes.emplace_back(elem, old_id);
+
+    if (valid_renames.empty()) {
+        return;
     }
 
-    fix_up_refs(refmap, id_changes);
+    refmap_type refmap;
+    find_references(document->getRoot(), refmap, false);
+    rename_ids(refmap, valid_renames);
 }
 
 /*
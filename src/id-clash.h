@@ -10,6 +10,9 @@
 #ifndef SEEN_ID_CLASH_H
 #define SEEN_ID_CLASH_H
 
+#include <string>
+#include <utility>
+#include <vector>
 #include <glibmm/ustring.h>  // for ustring
 
 class SPDocument;
@@ -17,7 +20,9 @@ class SPObject;
 
 void prevent_id_clashes(SPDocument *imported_doc, SPDocument *current_doc, bool from_clipboard = false);
 void rename_id(SPObject *elem, Glib::ustring const &newname);
+void rename_ids(SPDocument *document, std::vector<std::pair<SPObject *, Glib::ustring>> const &renames);
 void change_def_references(SPObject *replace_obj, SPObject *with_obj);
+void change_def_references(SPDocument *document, std::vector<std::pair<std::string, SPObject *>> const &replacements);
 Glib::ustring generate_similar_unique_id(SPDocument *document, Glib::ustring const &base_name);
 Glib::ustring sanitize_id(const Glib::ustring& id);
 
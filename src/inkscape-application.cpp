@@ -94,7 +94,9 @@
 #include "inkgc/gc-core.h"          // Garbage Collecting init
 #include "io/file.h"                // File open (command line).
 #include "io/fix-broken-links.h"    // Fix up references.
+#include "io/render-server.h"       // Server mode.
 #include "io/resource.h"            // TEMPLATE
+#include "object/image-cache.h"     // Images kept between documents in server mode.
 #include "object/sp-root.h"         // Inkscape version.
 #include "ui/desktop/document-check.h"    // Check for data loss on closing document window.
 #include "ui/dialog-run.h"
@@ -698,6 +700,8 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OptionType::STRING,   "export-png-compression", '\0', N_("Compression level for PNG export (0 to 9); default is 6"), N_("LEVEL"));
     // FIXME: Antialias should really be an INT, but an upstream bug means 0 is detected as NULL
     gapp->add_main_option_entry(T::OptionType::STRING,   "export-png-antialias",   '\0', N_("Antialias level for PNG export (0 to 3); default is 2"),   N_("LEVEL"));
+    gapp->add_main_option_entry(T::OptionType::BOOL,     "export-timings",        '\0', N_("Report the time taken to export each bitmap"),                              ""); // Bxx
+    gapp->add_main_option_entry(T::OptionType::FILENAME, "export-cache",          '\0', N_("Reuse bitmaps exported earlier with identical content, cached in DIRECTORY"), N_("DIRECTORY")); // Bxx
 
     // Query - Geometry
     _start_main_option_section(_("Query object/document geometry"));
@@ -725,6 +729,7 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OptionType::BOOL,     "batch-process",         '\0', N_("Close GUI after executing all actions"),                                    "");
     _start_main_option_section();
     gapp->add_main_option_entry(T::OptionType::BOOL,     "shell",                 '\0', N_("Start Inkscape in interactive shell mode"),                                 "");
+    gapp->add_main_option_entry(T::OptionType::FILENAME, "server",                '\0', N_("Run actions sent by clients of a UNIX socket, one line per request, until one sends 'quit'"), N_("PATH"));
     gapp->add_main_option_entry(T::OptionType::BOOL,     "active-window",          'q', N_("Use active window from commandline"),                                       "");
     // clang-format on
 
@@ -935,6 +940,10 @@ InkscapeApplication::process_document(SPDocument* document, std::string output_p
     if (_use_shell) {
         shell();
     }
+    if (!_server_socket.empty()) {
+        serve();
+        return; // Clients may have closed the document.
+    }
     if (_with_gui && _active_window) {
         document_fix(_active_window);
     }
@@ -1316,6 +1325,59 @@ InkscapeApplication::shell(bool active_window)
     }
 }
 
+/**
+ * Run actions for clients of a UNIX socket until one of them asks to quit, keeping fonts,
+ * extensions and recently decoded images loaded between them. See Inkscape::IO::RenderServer.
+ */
+void InkscapeApplication::serve()
+{
+    // Up to this many bytes of decoded images are kept for documents opened later.
+    constexpr std::size_t RETAINED_IMAGE_BYTES = 256 << 20;
+    Inkscape::ImageCache::get().set_retained_bytes(RETAINED_IMAGE_BYTES);
+
+    auto const handler = [this](std::string const &request, SPDocument *&document, std::vector<SPDocument *> &opened) {
+        // Each client has its own active document, which another one may have closed meanwhile.
+        auto const documents = get_documents();
+        if (std::find(documents.begin(), documents.end(), document) == documents.end()) {
+            document = nullptr;
+        }
+        _active_document = document;
+        _active_selection = document ? document->getSelection() : nullptr;
+        _active_desktop = nullptr;
+        _active_window = nullptr;
+
+        action_vector_t action_vector;
+        parse_actions(request, action_vector);
+        activate_any_actions(action_vector, _gio_application, _active_window, _active_document);
+
+        document = _active_document;
+
+        // Keep track of the documents the client left open, to close them when it goes away.
+        auto const now_open = get_documents();
+        std::erase_if(opened, [&](SPDocument *doc) {
+            return std::find(now_open.begin(), now_open.end(), doc) == now_open.end();
+        });
+        for (auto doc : now_open) {
+            if (std::find(documents.begin(), documents.end(), doc) == documents.end()) {
+                opened.push_back(doc);
+            }
+        }
+    };
+
+    auto const closer = [this](SPDocument *document) {
+        auto const documents = get_documents();
+        if (std::find(documents.begin(), documents.end(), document) != documents.end()) {
+            document_close(document);
+        }
+    };
+
+    Inkscape::IO::RenderServer server(handler, closer, _active_document);
+    server.run(_server_socket);
+
+    Inkscape::ImageCache::get().set_retained_bytes(0);
+    _server_socket.clear(); // Serve once, not again for each further file.
+}
+
 // Todo: Code can be improved by using proper IPC rather than temporary file polling.
 void InkscapeApplication::redirect_output()
 {
@@ -1476,6 +1538,8 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("export-png-use-dithering") ||
         options->contains("export-png-compression") ||
         options->contains("export-png-antialias") ||
+        options->contains("export-timings")       ||
+        options->contains("export-cache")         ||
 
         options->contains("query-id")              ||
         options->contains("query-x")               ||
@@ -1490,7 +1554,8 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("action-list")           ||
         options->contains("actions")               ||
         options->contains("actions-file")          ||
-        options->contains("shell")
+        options->contains("shell")                 ||
+        options->contains("server")
         ) {
         _with_gui = false;
     }
@@ -1506,6 +1571,9 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
     if (options->contains("batch-process"))  _batch_process = true;
     if (options->contains("shell"))          _use_shell = true;
     if (options->contains("pipe"))           _use_pipe  = true;
+    if (options->contains("server")) {
+        options->lookup_value("server", _server_socket);
+    }
 
     // Enable auto-export
     if (options->contains("export-filename")  ||
@@ -1700,6 +1768,11 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
 
     if (options->contains("export-latex"))        _file_export.export_latex       = true;
     if (options->contains("export-use-hints"))    _file_export.export_use_hints   = true;
+    if (options->contains("export-timings"))      _file_export.export_timings     = true;
+
+    if (options->contains("export-cache")) {
+        options->lookup_value("export-cache", _file_export.export_cache);
+    }
 
     if (options->contains("export-background")) {
         options->lookup_value("export-background",_file_export.export_background);
@@ -130,6 +130,7 @@ protected:
     bool _batch_process = false; // Temp
     bool _use_shell   = false;
     bool _use_pipe    = false;
+    std::string _server_socket; // Serve actions on this UNIX socket (--server).
     bool _auto_export = false;
     int _pdf_poppler  = false;
     FontStrategy _pdf_font_strategy = FontStrategy::RENDER_MISSING;
@@ -178,6 +179,7 @@ protected:
     void on_about();
     void redirect_output();
     void shell(bool active_window = false);
+    void serve();
 
     void _start_main_option_section(const Glib::ustring& section_name = "");
     
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::IO::ExportCache - content-addressed cache of exported bitmaps
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "export-cache.h"
+
+#include <deque>
+#include <set>
+#include <string_view>
+#include <glib/gstdio.h>
+#include <giomm/file.h>
+#include <glibmm/checksum.h>
+#include <glibmm/convert.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+
+#include "document.h"
+#include "inkscape-version.h"
+#include "object/sp-item.h"
+#include "object/sp-root.h"
+#include "xml/node.h"
+
+namespace Inkscape::IO {
+
+namespace {
+
+/**
+ * Feeds XML into a checksum, and collects the ids of the objects it references.
+ */
+class KeyBuilder
+{
+public:
+    explicit KeyBuilder(SPDocument *doc)
+        : _doc(doc)
+        , _checksum(Glib::Checksum::Type::SHA256)
+    {}
+
+    void add(std::string_view data)
+    {
+        _checksum.update(reinterpret_cast<guchar const *>(data.data()), data.size());
+        _checksum.update(reinterpret_cast<guchar const *>(""), 1); // Separator
+    }
+
+    /// Add a node with its attributes, and its descendants if @a recursive is set.
+    void add_node(XML::Node const *node, bool recursive)
+    {
+        switch (node->type()) {
+            case XML::NodeType::ELEMENT_NODE:
+                add("<");
+                add(node->name());
+                for (auto const &attr : node->attributeList()) {
+                    auto const name = g_quark_to_string(attr.key);
+                    auto const value = attr.value ? attr.value.pointer() : "";
+                    add(name);
+                    add(value);
+                    _scan_references(name, value);
+                }
+                if (recursive) {
+                    for (auto child = node->firstChild(); child; child = child->next()) {
+                        add_node(child, true);
+                    }
+                }
+                add(">");
+                break;
+            case XML::NodeType::TEXT_NODE:
+                add(node->content() ? node->content() : "");
+                _scan_references("", node->content() ? node->content() : "");
+                break;
+            default:
+                // Comments and processing instructions do not affect rendering.
+                break;
+        }
+    }
+
+    /// Add the subtrees of all objects referenced so far, and of those they reference in turn.
+    void add_references()
+    {
+        while (!_pending.empty()) {
+            auto const id = std::move(_pending.front());
+            _pending.pop_front();
+            add("#");
+            add(id);
+            if (auto obj = _doc->getObjectById(id); obj && obj->getRepr()) {
+                add_node(obj->getRepr(), true);
+            }
+        }
+    }
+
+    std::string finish() { return _checksum.get_string(); }
+
+private:
+    void _reference(std::string id)
+    {
+        if (!id.empty() && _seen.insert(id).second) {
+            _pending.push_back(std::move(id));
+        }
+    }
+
+    void _scan_references(std::string_view name, std::string_view value)
+    {
+        // Fragment references, as in href="#id".
+        if ((name == "xlink:href" || name == "href") && !value.empty()) {
+            if (value.front() == '#') {
+                _reference(std::string(value.substr(1)));
+            } else if (!value.starts_with("data:")) {
+                _add_linked_file(value);
+            }
+        }
+
+        // Paint server, filter, clip and mask references, as in fill="url(#id)".
+        for (auto pos = value.find("url("); pos != value.npos; pos = value.find("url(", pos + 4)) {
+            auto const start = value.find('#', pos);
+            auto const end = value.find(')', pos);
+            if (start == value.npos || end == value.npos || start > end) {
+                continue;
+            }
+            auto id = std::string(value.substr(start + 1, end - start - 1));
+            while (!id.empty() && (id.back() == '"' || id.back() == '\'' || g_ascii_isspace(id.back()))) {
+                id.pop_back();
+            }
+            _reference(std::move(id));
+        }
+    }
+
+    void _add_linked_file(std::string_view href)
+    {
+        auto filename = std::string(href);
+        if (filename.starts_with("file:")) {
+            try {
+                filename = Glib::filename_from_uri(filename);
+            } catch (Glib::Error const &) {
+                return;
+            }
+        }
+        if (!Glib::path_is_absolute(filename) && _doc->getDocumentBase()) {
+            filename = Glib::build_filename(_doc->getDocumentBase(), filename);
+        }
+
+        GStatBuf st;
+        if (g_stat(filename.c_str(), &st) == 0) {
+            add(std::to_string(st.st_size));
+            add(std::to_string(st.st_mtime));
+        }
+    }
+
+    SPDocument *_doc;
+    Glib::Checksum _checksum;
+    std::set<std::string> _seen;
+    std::deque<std::string> _pending;
+};
+
+} // namespace
+
+ExportCache::ExportCache(std::string directory)
+    : _directory(std::move(directory))
+{
+    g_mkdir_with_parents(_directory.c_str(), 0755);
+}
+
+std::string ExportCache::key(SPDocument *doc, std::vector<SPItem const *> const &items, std::string const &params) const
+{
+    KeyBuilder builder(doc);
+    builder.add(Inkscape::version_string);
+    builder.add(params);
+
+    auto const root = doc->getRoot();
+
+    if (items.empty()) {
+        builder.add_node(root->getRepr(), true);
+    } else {
+        // The root element sets up the document coordinate system.
+        builder.add_node(root->getRepr(), false);
+
+        // Stylesheets may apply to any element; metadata is written to the file.
+        for (auto const name : {"style", "metadata"}) {
+            for (auto const obj : doc->getObjectsByElement(name)) {
+                builder.add_node(obj->getRepr(), true);
+            }
+        }
+
+        for (auto const item : items) {
+            // Ancestors contribute transforms, inherited style, clips, masks and filters.
+            std::vector<SPObject const *> ancestors;
+            for (auto parent = item->parent; parent && parent != root; parent = parent->parent) {
+                ancestors.push_back(parent);
+            }
+            for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+                builder.add_node((*it)->getRepr(), false);
+            }
+            builder.add_node(item->getRepr(), true);
+        }
+    }
+
+    builder.add_references();
+
+    return builder.finish();
+}
+
+std::string ExportCache::_path(std::string const &key) const
+{
+    return Glib::build_filename(_directory, key.substr(0, 2), key);
+}
+
+bool ExportCache::fetch(std::string const &key, std::string const &filename) const
+{
+    auto const path = _path(key);
+    if (!Glib::file_test(path, Glib::FileTest::IS_REGULAR)) {
+        return false;
+    }
+
+    try {
+        auto const source = Gio::File::create_for_path(path);
+        source->copy(Gio::File::create_for_path(filename), Gio::File::CopyFlags::OVERWRITE);
+    } catch (Glib::Error const &) {
+        return false;
+    }
+    return true;
+}
+
+void ExportCache::store(std::string const &key, std::string const &filename) const
+{
+    auto const path = _path(key);
+    g_mkdir_with_parents(Glib::path_get_dirname(path).c_str(), 0755);
+
+    // Copy under a temporary name first, so that concurrent runs never see partial entries.
+    auto const temp = path + "." + std::to_string(g_get_real_time()) + ".tmp";
+    try {
+        auto const source = Gio::File::create_for_path(filename);
+        source->copy(Gio::File::create_for_path(temp), Gio::File::CopyFlags::OVERWRITE);
+    } catch (Glib::Error const &) {
+        g_unlink(temp.c_str());
+        return;
+    }
+    if (g_rename(temp.c_str(), path.c_str()) != 0) {
+        g_unlink(temp.c_str());
+    }
+}
+
+} // namespace Inkscape::IO
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::IO::ExportCache - content-addressed cache of exported bitmaps
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_IO_EXPORT_CACHE_H
+#define SEEN_INKSCAPE_IO_EXPORT_CACHE_H
+
+#include <string>
+#include <vector>
+
+class SPDocument;
+class SPItem;
+
+namespace Inkscape::IO {
+
+/**
+ * On-disk cache of exported bitmap files, shared between runs of the command-line exporter.
+ *
+ * Entries are addressed by a hash of everything that determines the rendered result: the
+ * serialized XML that is rendered, the render parameters, and the Inkscape version. When only
+ * some items are rendered (--export-id-only), the key covers just their subtrees, the attributes
+ * of their ancestors, the objects they reference (transitively), the stylesheets, the metadata
+ * and the root element, so unrelated edits elsewhere in the document do not invalidate them.
+ * Otherwise the whole document is hashed.
+ *
+ * Linked files are tracked by size and modification time. Installed fonts are not tracked; clear
+ * the cache after changing them.
+ */
+class ExportCache
+{
+public:
+    explicit ExportCache(std::string directory);
+
+    /**
+     * Compute the key of an export.
+     *
+     * @param items The only items that are rendered, or empty if the whole document may be.
+     * @param params Serialized render parameters (area, size, background, ...).
+     */
+    std::string key(SPDocument *doc, std::vector<SPItem const *> const &items, std::string const &params) const;
+
+    /// Copy the entry for @a key to @a filename. Return false if there is no such entry.
+    bool fetch(std::string const &key, std::string const &filename) const;
+
+    /// Store @a filename as the entry for @a key.
+    void store(std::string const &key, std::string const &filename) const;
+
+private:
+    std::string _path(std::string const &key) const;
+
+    std::string _directory;
+};
+
+} // namespace Inkscape::IO
+
+#endif // SEEN_INKSCAPE_IO_EXPORT_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
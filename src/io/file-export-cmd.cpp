@@ -14,7 +14,12 @@
 
 #include "file-export-cmd.h"
 
+#include <deque>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <boost/algorithm/string.hpp>
 #include <giomm/file.h>
@@ -26,6 +31,8 @@
 
 #include "colors/color.h"
 #include "colors/manager.h"
+#include "display/task-scheduler.h"
+#include "display/threading.h"
 #include "document.h"
 #include "extension/db.h"
 #include "extension/extension.h"
@@ -43,6 +50,7 @@
 #include "selection-chemistry.h" // fit_canvas_to_drawing
 #include "util/units.h"
 #include "util/parse-int-range.h"
+#include "io/export-cache.h"
 #include "io/sys.h"
 
 // Temporary dependency : once all compilers we want to support have support for
@@ -74,9 +82,104 @@ InkFileExportCmd::InkFileExportCmd()
     , export_plain_svg(false)
     ,export_png_compression(6)
     ,export_png_antialias(2)
+    , export_timings(false)
 {
 }
 
+/**
+ * Renders PNG exports on the shared worker threads while the main thread prepares the next ones.
+ *
+ * Preparing an export (showing the document in a new drawing) must happen on the main thread,
+ * but rendering and writing the file do not, so exports of many objects or pages overlap. The
+ * number of exports in flight is bounded to limit the memory used by their drawings.
+ */
+struct InkFileExportCmd::PngExportQueue
+{
+    PngExportQueue(bool report_timings, std::string const &cache_directory)
+        : _scheduler(Inkscape::get_global_task_scheduler())
+        , _max_pending(_scheduler->size() + 1)
+        , _report_timings(report_timings)
+    {
+        if (!cache_directory.empty()) {
+            _cache.emplace(cache_directory);
+        }
+    }
+
+    ~PngExportQueue() { finish(); }
+
+    /// The render cache, if enabled.
+    Inkscape::IO::ExportCache const *cache() const { return _cache ? &*_cache : nullptr; }
+
+    /// Queue an export, to be stored in the cache under @a cache_key (if not empty) once written.
+    void push(std::unique_ptr<PngExportJob> job, gint64 prepare_time, std::string cache_key)
+    {
+        while (_pending.size() >= _max_pending) {
+            _retire_oldest();
+        }
+
+        auto render = std::make_shared<std::packaged_task<Result()>>([job = job.get()] {
+            auto const start = g_get_monotonic_time();
+            auto const status = job->run();
+            return Result{status, g_get_monotonic_time() - start};
+        });
+        auto result = render->get_future();
+        _scheduler->post([render] { (*render)(); });
+
+        _pending.push_back({std::move(job), std::move(result), prepare_time, std::move(cache_key)});
+    }
+
+    /// Wait for all exports to be written.
+    void finish()
+    {
+        while (!_pending.empty()) {
+            _retire_oldest();
+        }
+    }
+
+private:
+    struct Result
+    {
+        ExportResult status;
+        gint64 render_time;
+    };
+
+    struct Pending
+    {
+        std::unique_ptr<PngExportJob> job;
+        std::future<Result> result;
+        gint64 prepare_time;
+        std::string cache_key;
+    };
+
+    void _retire_oldest()
+    {
+        auto pending = std::move(_pending.front());
+        _pending.pop_front();
+
+        auto const result = pending.result.get();
+        if (result.status != EXPORT_OK) {
+            std::cerr << "InkFileExport::do_export_png: Failed to export to " << pending.job->filename() << std::endl;
+        } else if (_report_timings) {
+            std::cerr << "Exported " << pending.job->filename() << " in "
+                      << (pending.prepare_time + result.render_time) / 1000 << " ms (prepare "
+                      << pending.prepare_time / 1000 << " ms, render " << result.render_time / 1000 << " ms)"
+                      << std::endl;
+        }
+
+        if (result.status == EXPORT_OK && !pending.cache_key.empty()) {
+            _cache->store(pending.cache_key, pending.job->filename());
+        }
+
+        // Destroying the job hides its drawing, which must happen on the main thread.
+    }
+
+    std::shared_ptr<Inkscape::task_scheduler> _scheduler;
+    std::deque<Pending> _pending;
+    std::size_t _max_pending;
+    bool _report_timings;
+    std::optional<Inkscape::IO::ExportCache> _cache;
+};
+
 void
 InkFileExportCmd::do_export(SPDocument* doc, std::string filename_in)
 {
@@ -492,6 +595,9 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
     // Export each object in list (or root if empty).  Use ';' so in future it could be possible to selected multiple objects to export together.
     std::vector<Glib::ustring> objects = Glib::Regex::split_simple("\\s*;\\s*", export_id);
 
+    // Exports are rendered in parallel, and written once the queue is finished or destroyed.
+    PngExportQueue queue(export_timings, export_cache);
+
     std::vector<SPItem const *> items;
     std::vector<Glib::ustring> objects_found;
     for (auto const &object_id : objects) {
@@ -531,9 +637,11 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
             // And if only one page is selected then we assume the user knows the filename they intended.
             std::string filename_out = base + (pages.size() > 1 ? "_p" + std::to_string(page_num) : "") + ".png";
             if (auto page = pm.getPage(page_num - 1)) {
-                do_export_png_now(doc, filename_out, page->getDesktopRect(), dpi, items);
+                do_export_png_now(doc, filename_out, page->getDesktopRect(), dpi, items, queue);
             }
         }
+        queue.finish();
+        prefs->setBool("/options/dithering/value", old_dither);
         return 0;
     }
 
@@ -664,15 +772,17 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
             area = area.roundOutwards();
         }
         // End finding area.
-        do_export_png_now(doc, filename_out, area, dpi, items);
+        do_export_png_now(doc, filename_out, area, dpi, items, queue);
 
     } // End loop over objects.
+    queue.finish();
     prefs->setBool("/options/dithering/value", old_dither);
     return 0;
 }
 
 void
-InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items)
+InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items,
+                                    PngExportQueue &queue)
 {
     // -------------------------- DPI -------------------------------
 
@@ -795,12 +905,37 @@ InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename
             return;
         }
 
-        if( sp_export_png_file(doc, filename_out.c_str(), area, width, height, xdpi, ydpi,
-                               bgcolor, nullptr, nullptr, true, export_id_only ? items : std::vector<SPItem const *>(),
-                               false, color_type, bit_depth, export_png_compression, export_png_antialias) == 1 ) {
-        } else {
+        if (area.hasZeroArea()) {
             std::cerr << "InkFileExport::do_export_png: Failed to export to " << filename_out << std::endl;
+            return;
+        }
+
+        auto const start = g_get_monotonic_time();
+
+        // Reuse the file written by an earlier run for identical content and parameters.
+        std::string cache_key;
+        if (auto const cache = queue.cache()) {
+            std::ostringstream params;
+            params.precision(17);
+            params << "png " << area.left() << ' ' << area.top() << ' ' << area.right() << ' ' << area.bottom()
+                   << ' ' << width << ' ' << height << ' ' << xdpi << ' ' << ydpi << ' ' << bgcolor
+                   << ' ' << color_type << ' ' << bit_depth << ' ' << export_png_compression
+                   << ' ' << export_png_antialias << ' ' << export_png_use_dithering;
+            cache_key = cache->key(doc, export_id_only ? items : std::vector<SPItem const *>(), params.str());
+
+            if (cache->fetch(cache_key, filename_out)) {
+                if (export_timings) {
+                    std::cerr << "Exported " << filename_out << " from cache in "
+                              << (g_get_monotonic_time() - start) / 1000 << " ms" << std::endl;
+                }
+                return;
+            }
         }
+
+        auto job = std::make_unique<PngExportJob>(doc, filename_out, area, width, height, xdpi, ydpi,
+                                                  bgcolor, export_id_only ? items : std::vector<SPItem const *>(),
+                                                  false, color_type, bit_depth, export_png_compression, export_png_antialias);
+        queue.push(std::move(job), g_get_monotonic_time() - start, std::move(cache_key));
 }
 
 
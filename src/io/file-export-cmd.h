@@ -52,7 +52,9 @@ private:
                          Inkscape::Extension::Output &extension);
     int do_export_extension(SPDocument *doc, std::string const &filename_in, Inkscape::Extension::Output *extension);
     Glib::ustring export_type_current;
-    void do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items);
+    struct PngExportQueue;
+    void do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items,
+                           PngExportQueue &queue);
 
 public:
     // Should be private, but this is just temporary code (I hope!).
@@ -87,6 +89,8 @@ public:
     bool          export_png_use_dithering;
     int           export_png_compression;
     int           export_png_antialias;
+    bool          export_timings;
+    std::string   export_cache;
     void set_export_area(const Glib::ustring &area);
     void set_export_area_type(ExportAreaType type);
 };
@@ -0,0 +1,427 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::IO::RenderServer - actions run for clients of a local socket, by one long-lived process
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "render-server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <glib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "util/scope_exit.h"
+
+namespace Inkscape::IO {
+
+struct RenderServer::Connection
+{
+    int fd = -1;
+    SPDocument *document = nullptr;
+    std::vector<SPDocument *> opened; ///< Documents the client opened.
+    std::string input;                ///< Received data not split into requests yet.
+    std::string output;               ///< Replies not sent yet.
+    std::size_t queued = 0;           ///< Number of requests of the client in the queue.
+    sigc::connection read_watch;
+    sigc::connection write_watch;
+    bool eof = false; ///< Whether the client sent all its requests.
+    bool closed = false;
+};
+
+RenderServer::RenderServer(Handler handler, Closer closer, SPDocument *document)
+    : _handler(std::move(handler))
+    , _closer(std::move(closer))
+    , _document(document)
+{
+}
+
+RenderServer::~RenderServer() = default;
+
+#ifdef _WIN32
+
+bool RenderServer::run(std::string const &)
+{
+    std::cerr << "RenderServer: UNIX sockets are not supported on this platform." << std::endl;
+    return false;
+}
+
+#else
+
+namespace {
+
+// Clients that leave before reading their reply must not take the server down.
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0; // SO_NOSIGPIPE is set on the socket instead.
+#endif
+
+void append_lines(std::string &reply, char const *prefix, std::string const &output)
+{
+    std::istringstream lines(output);
+    for (std::string line; std::getline(lines, line);) {
+        reply += prefix;
+        reply += line;
+        reply += '\n';
+    }
+}
+
+std::string milliseconds(std::chrono::steady_clock::duration duration)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << std::chrono::duration<double, std::milli>(duration).count();
+    return out.str();
+}
+
+/**
+ * Remove a socket left at @a address by a server that did not stop cleanly. Nothing else is
+ * removed: not a socket a server still listens on, not a socket of another user, and no other
+ * kind of file.
+ *
+ * The file is looked up and removed through its directory, opened once, so that a directory on
+ * the path being replaced in between cannot redirect the removal elsewhere.
+ */
+bool remove_stale_socket(sockaddr_un const &address)
+{
+    char const *path = address.sun_path;
+
+    int const probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        return false;
+    }
+    bool const live = connect(probe, reinterpret_cast<sockaddr const *>(&address), sizeof(address)) == 0;
+    close(probe);
+    if (live) {
+        std::cerr << "RenderServer: cannot listen on " << path << ": a server is listening on it" << std::endl;
+        return false;
+    }
+
+    auto const dirname = g_path_get_dirname(path);
+    auto const basename = g_path_get_basename(path);
+    auto free_names = scope_exit([&] {
+        g_free(dirname);
+        g_free(basename);
+    });
+
+    int const dir = open(dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir < 0) {
+        return false;
+    }
+    auto close_dir = scope_exit([&] { close(dir); });
+
+    struct stat st;
+    if (fstatat(dir, basename, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+        return errno == ENOENT; // Removed meanwhile.
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        std::cerr << "RenderServer: cannot listen on " << path << ": not a socket" << std::endl;
+        return false;
+    }
+    if (st.st_uid != geteuid()) {
+        std::cerr << "RenderServer: cannot listen on " << path << ": the socket belongs to another user" << std::endl;
+        return false;
+    }
+    return unlinkat(dir, basename, 0) == 0 || errno == ENOENT;
+}
+
+} // namespace
+
+bool RenderServer::run(std::string const &path)
+{
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "RenderServer: socket path too long: " << path << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    _listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listen_fd < 0) {
+        std::cerr << "RenderServer: cannot create socket: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    fcntl(_listen_fd, F_SETFD, FD_CLOEXEC); // Not for scripts run by extensions.
+
+    // Requests run with the rights of the server, so only its user may connect. The mode of the
+    // socket is set as it is created, so that there is no moment another user could connect.
+    auto const bind_socket = [&] {
+        auto const old_mask = umask(0177); // Mode 0600.
+        int const result = bind(_listen_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+        int const error = errno;
+        umask(old_mask);
+        errno = error;
+        return result == 0;
+    };
+
+    // bind() never replaces a file. A socket left by a server that did not stop cleanly is
+    // removed, and binding tried again.
+    bool bound = bind_socket();
+    if (!bound && errno == EADDRINUSE) {
+        if (!remove_stale_socket(address)) {
+            close(_listen_fd);
+            _listen_fd = -1;
+            return false;
+        }
+        bound = bind_socket();
+    }
+
+    if (!bound || listen(_listen_fd, SOMAXCONN)) {
+        std::cerr << "RenderServer: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        close(_listen_fd);
+        _listen_fd = -1;
+        if (bound) {
+            unlink(path.c_str());
+        }
+        return false;
+    }
+
+    _loop = Glib::MainLoop::create();
+    auto accept_watch = Glib::signal_io().connect(sigc::mem_fun(*this, &RenderServer::_accept), _listen_fd,
+                                                  Glib::IOCondition::IO_IN);
+
+    std::cout << "Inkscape render server listening on " << path << std::endl;
+    _loop->run();
+
+    accept_watch.disconnect();
+    for (auto const &connection : std::vector(_connections)) {
+        _flush(connection); // The reply to "quit", as far as it can be sent without waiting.
+        _close(connection);
+    }
+    _queue.clear();
+    close(_listen_fd);
+    _listen_fd = -1;
+    unlink(path.c_str());
+
+    return true;
+}
+
+bool RenderServer::_accept(Glib::IOCondition)
+{
+    int const fd = accept(_listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+        return true; // The client left already.
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    // Replies are buffered rather than waiting for a client that does not read them.
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int const on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    auto connection = std::make_shared<Connection>();
+    connection->fd = fd;
+    connection->document = _document;
+    connection->read_watch = Glib::signal_io().connect(
+        [this, weak = std::weak_ptr(connection)](Glib::IOCondition) {
+            auto const connection = weak.lock();
+            return connection && _read(connection);
+        },
+        fd, Glib::IOCondition::IO_IN | Glib::IOCondition::IO_HUP | Glib::IOCondition::IO_ERR);
+    _connections.push_back(std::move(connection));
+
+    return true;
+}
+
+bool RenderServer::_read(std::shared_ptr<Connection> const &connection)
+{
+    char buffer[4096];
+    auto const size = recv(connection->fd, buffer, sizeof(buffer), 0);
+    if (size < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    if (size < 0) {
+        // Gone; requests of the client still queued are dropped when their turn comes. Returning
+        // false removes the watch.
+        _close(connection);
+        return false;
+    }
+
+    if (size == 0) {
+        // The client sent all its requests, and may still be waiting for the replies.
+        connection->eof = true;
+        if (!connection->input.empty()) {
+            connection->input += '\n'; // The last request may lack its end of line.
+        }
+    } else {
+        connection->input.append(buffer, size);
+    }
+
+    auto const now = std::chrono::steady_clock::now();
+    std::size_t start = 0;
+    for (std::size_t end; (end = connection->input.find('\n', start)) != std::string::npos; start = end + 1) {
+        auto line = connection->input.substr(start, end - start);
+        line.erase(line.find_last_not_of(" \r\t") + 1); // Remove trailing space, as the shell does.
+        if (!line.empty()) {
+            _queue.push_back({connection, std::move(line), now});
+            connection->queued++;
+        }
+    }
+    connection->input.erase(0, start);
+
+    if (!_queue.empty() && !_serving) {
+        // Serve when idle, so that reading from other clients goes on between requests.
+        Glib::signal_idle().connect(sigc::mem_fun(*this, &RenderServer::_serve_next));
+        _serving = true;
+    }
+
+    if (connection->eof) {
+        if (connection->queued == 0 && connection->output.empty()) {
+            _close(connection);
+        }
+        return false; // Closed once its requests are answered.
+    }
+    return true;
+}
+
+bool RenderServer::_serve_next()
+{
+    if (_queue.empty()) {
+        _serving = false;
+        return false;
+    }
+
+    auto const request = std::move(_queue.front());
+    _queue.pop_front();
+    auto const &connection = request.connection;
+    connection->queued--;
+    if (connection->closed) {
+        return true;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+
+    if (request.line == "quit" || request.line == "q") {
+        _send(connection, "done wait=" + milliseconds(start - request.received) + " run=0.000\n");
+        _loop->quit();
+        _serving = false;
+        return false;
+    }
+
+    std::ostringstream out;
+    std::ostringstream err;
+    {
+        // Actions report on the standard streams; send what they report to the client instead.
+        auto const cout_buf = std::cout.rdbuf(out.rdbuf());
+        auto const cerr_buf = std::cerr.rdbuf(err.rdbuf());
+        auto restore = scope_exit([&] {
+            std::cout.rdbuf(cout_buf);
+            std::cerr.rdbuf(cerr_buf);
+        });
+
+        try {
+            _handler(request.line, connection->document, connection->opened);
+        } catch (std::exception const &e) {
+            std::cerr << "RenderServer: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "RenderServer: request failed" << std::endl;
+        }
+    }
+
+    auto const end = std::chrono::steady_clock::now();
+
+    std::string reply;
+    append_lines(reply, "out: ", out.str());
+    append_lines(reply, "err: ", err.str());
+    reply += "done wait=" + milliseconds(start - request.received) + " run=" + milliseconds(end - start) + "\n";
+    _send(connection, reply);
+
+    return true;
+}
+
+void RenderServer::_send(std::shared_ptr<Connection> const &connection, std::string const &reply)
+{
+    if (connection->closed) {
+        return;
+    }
+    connection->output += reply;
+    if (!connection->write_watch.connected()) {
+        _flush(connection);
+    }
+}
+
+/**
+ * Send as much of the pending replies of a client as it takes without waiting. The rest is sent
+ * once the client reads, while other clients are served.
+ *
+ * @return Whether there is more to send, as a watch on the socket.
+ */
+bool RenderServer::_flush(std::shared_ptr<Connection> const &connection)
+{
+    while (!connection->closed && !connection->output.empty()) {
+        auto const size = send(connection->fd, connection->output.data(), connection->output.size(), SEND_FLAGS);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!connection->write_watch.connected()) {
+                connection->write_watch = Glib::signal_io().connect(
+                    [this, weak = std::weak_ptr(connection)](Glib::IOCondition) {
+                        auto const connection = weak.lock();
+                        return connection && _flush(connection);
+                    },
+                    connection->fd, Glib::IOCondition::IO_OUT);
+            }
+            return true;
+        }
+        if (size <= 0) {
+            _close(connection);
+            return false;
+        }
+        connection->output.erase(0, size);
+    }
+
+    connection->write_watch.disconnect();
+    if (connection->eof && connection->queued == 0) {
+        _close(connection);
+    }
+    return false;
+}
+
+void RenderServer::_close(std::shared_ptr<Connection> const &connection)
+{
+    if (connection->closed) {
+        return;
+    }
+    connection->closed = true;
+    connection->read_watch.disconnect();
+    connection->write_watch.disconnect();
+    close(connection->fd);
+
+    for (auto document : connection->opened) {
+        _closer(document);
+    }
+    connection->opened.clear();
+
+    std::erase(_connections, connection);
+}
+
+#endif // _WIN32
+
+} // namespace Inkscape::IO
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
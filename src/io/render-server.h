@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::IO::RenderServer - actions run for clients of a local socket, by one long-lived process
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_IO_RENDER_SERVER_H
+#define SEEN_INKSCAPE_IO_RENDER_SERVER_H
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glibmm/main.h>
+
+class SPDocument;
+
+namespace Inkscape::IO {
+
+/**
+ * Runs actions sent by clients connected to a UNIX socket, for as long as the process lives.
+ *
+ * Starting Inkscape loads preferences, extensions and fonts, which takes longer than exporting
+ * most documents. Build systems exporting many documents can instead start one server with
+ * --server=PATH, and send it lines of actions in the syntax of --actions and of the shell, like
+ * "file-open:a.svg; export-filename:a.png; export-do; file-close".
+ *
+ * Any number of clients may be connected at once. Their requests are run one at a time on the
+ * main thread, in the order they were received, and each client has its own active document.
+ *
+ * The reply to a request is its output, one line each prefixed with "out: " or "err: ", followed
+ * by a line "done wait=<ms> run=<ms>" giving the time it waited behind other requests and the
+ * time it took to run. The request "quit" stops the server.
+ *
+ * A client may shut down its side of the connection once it has sent its requests; they are
+ * still answered. Documents a client opened and did not close are closed when it goes away.
+ *
+ * Requests run with the rights of the server, so the socket can only be used by its user.
+ */
+class RenderServer
+{
+public:
+    /**
+     * Run a request of a client, whose active document is @a document, which the request may
+     * change. Documents the request opened are appended to @a opened.
+     */
+    using Handler = std::function<void(std::string const &request, SPDocument *&document,
+                                       std::vector<SPDocument *> &opened)>;
+
+    /// Close a document opened by a client that went away, unless it was closed already.
+    using Closer = std::function<void(SPDocument *document)>;
+
+    /// @param document The active document of new clients.
+    RenderServer(Handler handler, Closer closer, SPDocument *document);
+    ~RenderServer();
+
+    RenderServer(RenderServer const &) = delete;
+    RenderServer &operator=(RenderServer const &) = delete;
+
+    /**
+     * Listen on a UNIX socket at @a path, replacing a socket of the same user left there by a
+     * server that did not stop cleanly, and serve requests until a client asks to quit.
+     *
+     * @return False if the socket could not be created, or if @a path is another kind of file,
+     * a socket of another user, or a socket a server is listening on.
+     */
+    bool run(std::string const &path);
+
+private:
+    struct Connection;
+
+    struct Request
+    {
+        std::shared_ptr<Connection> connection;
+        std::string line;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    bool _accept(Glib::IOCondition condition);
+    bool _read(std::shared_ptr<Connection> const &connection);
+    bool _serve_next();
+    void _send(std::shared_ptr<Connection> const &connection, std::string const &reply);
+    bool _flush(std::shared_ptr<Connection> const &connection);
+    void _close(std::shared_ptr<Connection> const &connection);
+
+    Handler _handler;
+    Closer _closer;
+    SPDocument *_document;
+    int _listen_fd = -1;
+    Glib::RefPtr<Glib::MainLoop> _loop;
+    std::vector<std::shared_ptr<Connection>> _connections;
+    std::deque<Request> _queue;
+    bool _serving = false; ///< Whether requests are being served when idle.
+};
+
+} // namespace Inkscape::IO
+
+#endif // SEEN_INKSCAPE_IO_RENDER_SERVER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
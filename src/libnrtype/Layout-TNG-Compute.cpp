@@ -20,6 +20,7 @@
 #include "object/sp-object.h"
 #include "object/sp-flowdiv.h"
 #include "Layout-TNG-Scanline-Maker.h"
+#include "shaping-cache.h"
 #include <limits>
 #include "livarot/Shape.h"
 
@@ -1610,13 +1611,14 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                     auto gnew = std::string_view(para->text.data()         + para_text_index,           new_span.text_bytes);
                     assert (gold == gnew);
 
-                    // Convert characters to glyphs
-                    pango_shape_full(para->text.data() + para_text_index,
-                                     new_span.text_bytes,
-                                     para->text.data(),
-                                     -1,
-                                     &para->pango_items[pango_item_index].item->analysis,
-                                     new_span.glyph_string);
+                    // Convert characters to glyphs; spans that did not change since the last layout
+                    // of any text are not shaped again.
+                    ShapingCache::get().shape(para->text.data() + para_text_index,
+                                              new_span.text_bytes,
+                                              para->text.data(),
+                                              para->text.bytes(),
+                                              &para->pango_items[pango_item_index].item->analysis,
+                                              new_span.glyph_string);
 
                     if (para->pango_items[pango_item_index].item->analysis.level & 1) {
                         // Right to left text (Arabic, Hebrew, etc.)
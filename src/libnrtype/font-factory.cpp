@@ -41,7 +41,9 @@
 
 #include "libnrtype/font-factory.h"
 #include "libnrtype/font-instance.h"
+#include "libnrtype/glyph-path-cache.h"
 #include "libnrtype/OpenTypeUtil.h"
+#include "libnrtype/shaping-cache.h"
 
 #include "util/statics.h"
 
@@ -221,6 +223,8 @@ FontFactory::FontFactory()
 
 FontFactory::~FontFactory()
 {
+    Inkscape::Text::ShapingCache::get().clear();
+    Inkscape::Text::GlyphPathCache::get().clear();
     loaded.clear();
     g_object_unref(fontContext);
     fontServer = 0; // freed by _font_map
@@ -229,6 +233,8 @@ FontFactory::~FontFactory()
 void FontFactory::refreshConfig()
 {
     pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
+    Inkscape::Text::ShapingCache::get().clear();
+    Inkscape::Text::GlyphPathCache::get().clear();
 }
 
 Glib::ustring FontFactory::ConstructFontSpecification(PangoFontDescription *font)
@@ -10,16 +10,13 @@
 #ifndef LIBNRTYPE_FONT_GLYPH_H
 #define LIBNRTYPE_FONT_GLYPH_H
 
-#include <memory>
-#include <2geom/pathvector.h>
-
 // The info for a glyph in a font. It's totally resolution- and fontsize-independent.
 struct FontGlyph
 {
     double h_advance, h_width; // width != advance because of kerning adjustements
     double v_advance, v_width;
     double bbox[4];            // bbox of the path (and the artbpath), not the bbox of the glyph as the fonts sometimes contain outline as a livarot Path
-    Geom::PathVector pathvector; // outline as 2geom pathvector, for text->curve stuff (should be unified with livarot)
+    // The outline is kept by Inkscape::Text::GlyphPathCache; see FontInstance::PathVector().
 };
 
 #endif // LIBNRTYPE_FONT_GLYPH_H
@@ -36,6 +36,7 @@
 #include <2geom/path-sink.h>
 #include "libnrtype/font-glyph.h"
 #include "libnrtype/font-instance.h"
+#include "libnrtype/glyph-path-cache.h"
 
 #include "display/cairo-utils.h"  // Inkscape::Pixbuf
 
@@ -101,6 +102,37 @@ static int ft2_cubic_to(FT_Vector const *control1, FT_Vector const *control2, FT
     return 0;
 }
 
+// Build the outline of the glyph last loaded into the face, scaled to the em square.
+static Geom::PathVector load_outline(FT_Face face)
+{
+    Geom::PathBuilder path_builder;
+
+    if (face->glyph->format == ft_glyph_format_outline) {
+        FT_Outline_Funcs ft2_outline_funcs = {
+            ft2_move_to,
+            ft2_line_to,
+            ft2_conic_to,
+            ft2_cubic_to,
+            0, 0
+        };
+        FT2GeomData user(path_builder, 1.0 / face->units_per_EM);
+        FT_Outline_Decompose(&face->glyph->outline, &ft2_outline_funcs, &user);
+    }
+
+    path_builder.flush();
+
+    Geom::PathVector pv = path_builder.peek();
+
+    // close all paths
+    for (auto &i : pv) {
+        i.close();
+    }
+
+    return pv;
+}
+
+static constexpr FT_Int32 GLYPH_LOAD_FLAGS = FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP;
+
 /*
  *
  */
@@ -403,8 +435,6 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
         return it->second.get(); // already loaded
     }
 
-    Geom::PathBuilder path_builder;
-
     auto n_g = std::make_unique<FontGlyph>();
     n_g->bbox[0] = n_g->bbox[1] = n_g->bbox[2] = n_g->bbox[3] = 0.0;
     n_g->h_advance = 0.0;
@@ -412,7 +442,7 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
     n_g->h_width = 0.0;
     n_g->v_width = 0.0;
 
-    if (FT_Load_Glyph(face, glyph_id, FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP)) {
+    if (FT_Load_Glyph(face, glyph_id, GLYPH_LOAD_FLAGS)) {
         return nullptr; // error
     }
 
@@ -435,30 +465,10 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
         n_g->v_width = n_g->v_advance = 1.0;
     }
 
-    if (face->glyph->format == ft_glyph_format_outline) {
-        FT_Outline_Funcs ft2_outline_funcs = {
-            ft2_move_to,
-            ft2_line_to,
-            ft2_conic_to,
-            ft2_cubic_to,
-            0, 0
-        };
-        FT2GeomData user(path_builder, 1.0 / face->units_per_EM);
-        FT_Outline_Decompose(&face->glyph->outline, &ft2_outline_funcs, &user);
-    }
-
-    path_builder.flush();
-
-    Geom::PathVector pv = path_builder.peek();
-
-    // close all paths
-    for (auto &i : pv) {
-        i.close();
-    }
+    auto pv = load_outline(face);
 
     if (!pv.empty()) {
-        n_g->pathvector = std::move(pv);
-        Geom::OptRect bounds = bounds_exact(n_g->pathvector);
+        Geom::OptRect bounds = bounds_exact(pv);
         if (bounds) {
             n_g->bbox[0] = bounds->left();
             n_g->bbox[1] = bounds->top();
@@ -467,6 +477,9 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
         }
     }
 
+    // Glyphs are usually loaded to be drawn, so keep the outline rather than build it again.
+    Inkscape::Text::GlyphPathCache::get().insert(data, glyph_id, std::move(pv));
+
     auto ret = data->glyphs.emplace(glyph_id, std::move(n_g));
 
     return ret.first->second.get();
@@ -525,14 +538,18 @@ Geom::OptRect FontInstance::BBox(int glyph_id)
     return Geom::Rect(rmin, rmax);
 }
 
-Geom::PathVector const *FontInstance::PathVector(int glyph_id)
+std::shared_ptr<Geom::PathVector const> FontInstance::PathVector(int glyph_id)
 {
-    auto g = LoadGlyph(glyph_id);
-    if (!g) {
-        return nullptr;
+    auto &cache = Inkscape::Text::GlyphPathCache::get();
+    if (auto pathvector = cache.lookup(data, glyph_id)) {
+        return pathvector;
     }
 
-    return &g->pathvector;
+    // Not loaded yet, or evicted since.
+    if (!FT_IS_SCALABLE(face) || FT_Load_Glyph(face, glyph_id, GLYPH_LOAD_FLAGS)) {
+        return nullptr;
+    }
+    return cache.insert(data, glyph_id, load_outline(face));
 }
 
 Inkscape::Pixbuf const *FontInstance::PixBuf(int glyph_id)
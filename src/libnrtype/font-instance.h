@@ -11,6 +11,7 @@
 #define LIBNRTYPE_FONT_INSTANCE_H
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <optional>
 #include <unordered_map>
@@ -62,8 +63,8 @@ public:
     // nota: all coordinates returned by these functions are on a [0..1] scale; you need to multiply
     // by the fontsize to get the real sizes
 
-    // Return 2geom pathvector for glyph. Deallocated when font instance dies.
-    Geom::PathVector const *PathVector(int glyph_id);
+    // Return 2geom pathvector for glyph. Shared with the glyph path cache, which may evict it.
+    std::shared_ptr<Geom::PathVector const> PathVector(int glyph_id);
 
     // Return font has SVG OpenType enties.
     bool                  FontHasSVG() const { return data->openTypeSVGGlyphs.size() > 0; };
@@ -79,7 +80,7 @@ public:
     // Horizontal advance if 'vertical' is false, vertical advance if true.
     double Advance(int glyph_id, bool vertical);
 
-    // Return a shared pointer that will keep alive the pathvector and pixbuf data, but nothing else.
+    // Return a shared pointer that will keep alive the pixbuf data, but nothing else.
     std::shared_ptr<void const> share_data() const { return data; }
 
     double        GetTypoAscent()  const { return _ascent; }
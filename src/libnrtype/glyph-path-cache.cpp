@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::Text::GlyphPathCache - glyph outlines, shared between fonts and their users
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "glyph-path-cache.h"
+
+#include <functional>
+#include <iterator>
+#include <2geom/bezier-curve.h>
+
+namespace Inkscape {
+namespace Text {
+
+namespace {
+
+// Least recently used outlines are discarded above this size.
+constexpr std::size_t MAX_BYTES = 8 << 20;
+
+// Roughly what a segment of an outline takes, counting the coefficients it holds on the heap.
+constexpr std::size_t SEGMENT_BYTES = sizeof(Geom::CubicBezier) + 2 * 4 * sizeof(Geom::Coord);
+
+} // namespace
+
+GlyphPathCache &GlyphPathCache::get()
+{
+    // Never destroyed, like the shaping cache.
+    static auto const cache = [] {
+        auto const c = new GlyphPathCache;
+        Debug::register_extra_heap(*c);
+        return c;
+    }();
+    return *cache;
+}
+
+std::size_t GlyphPathCache::KeyHash::operator()(Key const &key) const
+{
+    return std::hash<void const *>{}(key.first) * 1128467 + key.second;
+}
+
+std::size_t GlyphPathCache::_size(Geom::PathVector const &pathvector)
+{
+    auto size = sizeof(Entry) + sizeof(Geom::PathVector);
+    for (auto const &path : pathvector) {
+        size += sizeof(Geom::Path) + path.size_closed() * SEGMENT_BYTES;
+    }
+    return size;
+}
+
+GlyphPathCache::Outline GlyphPathCache::lookup(std::shared_ptr<void const> const &font_data, int glyph)
+{
+    std::scoped_lock lock(_mutex);
+    if (auto it = _entries.find({font_data.get(), glyph}); it != _entries.end()) {
+        // A font that was freed may have left its outlines to a new one at the same address.
+        if (!it->second->font_data.expired()) {
+            _lru.splice(_lru.begin(), _lru, it->second);
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->outline;
+        }
+        _erase(it->second);
+    }
+    _misses.fetch_add(1, std::memory_order_relaxed);
+    return {};
+}
+
+GlyphPathCache::Outline GlyphPathCache::insert(std::shared_ptr<void const> const &font_data, int glyph,
+                                               Geom::PathVector pathvector)
+{
+    Key const key{font_data.get(), glyph};
+    auto const bytes = _size(pathvector);
+    auto outline = std::make_shared<Geom::PathVector const>(std::move(pathvector));
+
+    std::scoped_lock lock(_mutex);
+    if (auto it = _entries.find(key); it != _entries.end()) {
+        if (!it->second->font_data.expired()) {
+            _lru.splice(_lru.begin(), _lru, it->second);
+            return it->second->outline;
+        }
+        _erase(it->second);
+    }
+    _lru.push_front(Entry{key, font_data, outline, bytes});
+    _entries.emplace(key, _lru.begin());
+    _bytes += bytes;
+    _evict();
+    return outline;
+}
+
+void GlyphPathCache::_erase(LRU::iterator it)
+{
+    _entries.erase(it->key);
+    _bytes -= it->bytes;
+    _lru.erase(it);
+}
+
+void GlyphPathCache::_evict()
+{
+    while (_bytes > MAX_BYTES && _lru.size() > 1) {
+        _erase(std::prev(_lru.end()));
+    }
+}
+
+Debug::Heap::Stats GlyphPathCache::stats() const
+{
+    std::scoped_lock lock(_mutex);
+    return {_bytes, _bytes, _hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed)};
+}
+
+void GlyphPathCache::clear()
+{
+    std::scoped_lock lock(_mutex);
+    _entries.clear();
+    _lru.clear();
+    _bytes = 0;
+}
+
+} // namespace Text
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::Text::GlyphPathCache - glyph outlines, shared between fonts and their users
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef LIBNRTYPE_GLYPH_PATH_CACHE_H
+#define LIBNRTYPE_GLYPH_PATH_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <2geom/pathvector.h>
+
+#include "debug/heap.h"
+
+namespace Inkscape {
+namespace Text {
+
+/**
+ * A bounded, thread-safe cache of glyph outlines, keyed on the font they came from.
+ *
+ * Outlines are handed out as shared pointers, so one that is evicted while a text layout or a
+ * drawing still uses it stays alive until they let go of it; it is only loaded again from the
+ * font by the next caller to ask for it. The least recently used outlines are discarded first.
+ *
+ * Only weak references to fonts are held, so the cache does not keep fonts alive. It is listed as
+ * a heap in the memory dialog, along with its hit rate.
+ */
+class GlyphPathCache final : public Debug::Heap
+{
+public:
+    using Outline = std::shared_ptr<Geom::PathVector const>;
+
+    /// The cache shared by all fonts.
+    static GlyphPathCache &get();
+
+    GlyphPathCache(GlyphPathCache const &) = delete;
+    GlyphPathCache &operator=(GlyphPathCache const &) = delete;
+
+    /**
+     * Return the cached outline of a glyph, or null if it has not been loaded or was evicted.
+     *
+     * @param font_data The data of the font, as returned by FontInstance::share_data().
+     */
+    Outline lookup(std::shared_ptr<void const> const &font_data, int glyph);
+
+    /// Add the outline of a glyph, and return it; if another thread got there first, theirs.
+    Outline insert(std::shared_ptr<void const> const &font_data, int glyph, Geom::PathVector pathvector);
+
+    /// Discard all outlines, for example after the installed fonts changed.
+    void clear();
+
+    int features() const override { return SIZE_AVAILABLE | USED_AVAILABLE | HITS_AVAILABLE; }
+    char const *name() const override { return "glyph outlines"; }
+    Stats stats() const override;
+    void force_collect() override {}
+
+private:
+    GlyphPathCache() = default;
+    ~GlyphPathCache() override = default;
+
+    using Key = std::pair<void const *, int>;
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        std::weak_ptr<void const> font_data; ///< Tells whether the font at the key's address is still the same.
+        Outline outline;
+        std::size_t bytes;
+    };
+    using LRU = std::list<Entry>;
+
+    static std::size_t _size(Geom::PathVector const &pathvector);
+    void _erase(LRU::iterator it);
+    void _evict();
+
+    mutable std::mutex _mutex;
+    LRU _lru; ///< Most recently used first.
+    std::unordered_map<Key, LRU::iterator, KeyHash> _entries;
+    std::size_t _bytes = 0;
+    std::atomic<unsigned long> _hits{};
+    std::atomic<unsigned long> _misses{};
+};
+
+} // namespace Text
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_GLYPH_PATH_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
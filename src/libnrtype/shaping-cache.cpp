@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::Text::ShapingCache - glyph strings shaped by Pango, shared between text layouts
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "shaping-cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace Inkscape {
+namespace Text {
+
+namespace {
+
+// HarfBuzz looks at no more than this many characters on either side of the shaped text
+// (HB_BUFFER_CONTEXT_LENGTH).
+constexpr int CONTEXT_LENGTH = 5;
+
+// Least recently used results are discarded above this size.
+constexpr std::size_t MAX_BYTES = 16 << 20;
+
+} // namespace
+
+ShapingCache &ShapingCache::get()
+{
+    // Never destroyed; FontFactory clears it while the fonts it refers to can still be released.
+    static auto const cache = [] {
+        auto const c = new ShapingCache;
+        Debug::register_extra_heap(*c);
+        return c;
+    }();
+    return *cache;
+}
+
+ShapingCache::Key::Key(Key &&other) noexcept
+    : font(std::exchange(other.font, nullptr))
+    , language(other.language)
+    , level(other.level)
+    , gravity(other.gravity)
+    , flags(other.flags)
+    , script(other.script)
+    , attrs(std::move(other.attrs))
+    , text(std::move(other.text))
+    , context_before(other.context_before)
+{
+    other.attrs.clear();
+}
+
+ShapingCache::Key::~Key()
+{
+    for (auto attr : attrs) {
+        pango_attribute_destroy(attr);
+    }
+    if (font) {
+        g_object_unref(font);
+    }
+}
+
+bool ShapingCache::Key::operator==(Key const &other) const
+{
+    if (font != other.font || language != other.language || level != other.level || gravity != other.gravity ||
+        flags != other.flags || script != other.script || context_before != other.context_before ||
+        text != other.text || attrs.size() != other.attrs.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < attrs.size(); i++) {
+        if (attrs[i]->klass->type != other.attrs[i]->klass->type || !pango_attribute_equal(attrs[i], other.attrs[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t ShapingCache::KeyHash::operator()(Key const *key) const
+{
+    auto hash = std::hash<std::string>{}(key->text);
+    hash = hash * 1128467 + std::hash<void const *>{}(key->font);
+    hash = hash * 1128467 + std::hash<void const *>{}(key->language);
+    hash = hash * 1128467 + key->level;
+    hash = hash * 1128467 + key->script;
+    hash = hash * 1128467 + key->context_before;
+    for (auto attr : key->attrs) {
+        hash = hash * 1128467 + attr->klass->type;
+    }
+    return hash;
+}
+
+ShapingCache::Key ShapingCache::_make_key(char const *item_text, int item_length, char const *paragraph_text,
+                                          int paragraph_length, PangoAnalysis const *analysis)
+{
+    auto const paragraph_end = paragraph_text + paragraph_length;
+    auto const item_end = item_text + item_length;
+
+    auto start = item_text;
+    for (int i = 0; i < CONTEXT_LENGTH && start > paragraph_text; i++) {
+        start = g_utf8_find_prev_char(paragraph_text, start);
+    }
+    auto end = item_end;
+    for (int i = 0; i < CONTEXT_LENGTH && end < paragraph_end; i++) {
+        end = g_utf8_next_char(end);
+    }
+
+    Key key;
+    key.font = analysis->font ? PANGO_FONT(g_object_ref(analysis->font)) : nullptr;
+    key.language = analysis->language;
+    key.level = analysis->level;
+    key.gravity = analysis->gravity;
+    key.flags = analysis->flags;
+    key.script = analysis->script;
+    for (auto l = analysis->extra_attrs; l; l = l->next) {
+        key.attrs.push_back(pango_attribute_copy(static_cast<PangoAttribute const *>(l->data)));
+    }
+    key.text.assign(start, end);
+    key.context_before = item_text - start;
+    return key;
+}
+
+std::size_t ShapingCache::_size(Entry const &entry)
+{
+    return sizeof(Entry) + entry.key.text.capacity() + entry.key.attrs.capacity() * sizeof(PangoAttribute *) +
+           entry.glyphs->num_glyphs * (sizeof(PangoGlyphInfo) + sizeof(int));
+}
+
+void ShapingCache::shape(char const *item_text, int item_length, char const *paragraph_text, int paragraph_length,
+                         PangoAnalysis const *analysis, PangoGlyphString *glyphs)
+{
+    auto key = _make_key(item_text, item_length, paragraph_text, paragraph_length, analysis);
+
+    {
+        std::scoped_lock lock(_mutex);
+        if (auto it = _entries.find(&key); it != _entries.end()) {
+            _lru.splice(_lru.begin(), _lru, it->second);
+            auto const cached = it->second->glyphs;
+            pango_glyph_string_set_size(glyphs, cached->num_glyphs);
+            std::copy_n(cached->glyphs, cached->num_glyphs, glyphs->glyphs);
+            std::copy_n(cached->log_clusters, cached->num_glyphs, glyphs->log_clusters);
+            _hits.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Shape without holding the lock; another thread shaping the same text just does it twice.
+    pango_shape_full(item_text, item_length, paragraph_text, paragraph_length, analysis, glyphs);
+    _misses.fetch_add(1, std::memory_order_relaxed);
+
+    std::scoped_lock lock(_mutex);
+    if (_entries.find(&key) != _entries.end()) {
+        return;
+    }
+    _lru.push_front(Entry{std::move(key), pango_glyph_string_copy(glyphs)});
+    _entries.emplace(&_lru.front().key, _lru.begin());
+    _bytes += _size(_lru.front());
+    _evict();
+}
+
+void ShapingCache::_evict()
+{
+    while (_bytes > MAX_BYTES && _lru.size() > 1) {
+        auto &entry = _lru.back();
+        _entries.erase(&entry.key);
+        _bytes -= _size(entry);
+        pango_glyph_string_free(entry.glyphs);
+        _lru.pop_back();
+    }
+}
+
+Debug::Heap::Stats ShapingCache::stats() const
+{
+    std::scoped_lock lock(_mutex);
+    return {_bytes, _bytes, _hits.load(std::memory_order_relaxed), _misses.load(std::memory_order_relaxed)};
+}
+
+void ShapingCache::clear()
+{
+    std::scoped_lock lock(_mutex);
+    _entries.clear();
+    for (auto &entry : _lru) {
+        pango_glyph_string_free(entry.glyphs);
+    }
+    _lru.clear();
+    _bytes = 0;
+}
+
+} // namespace Text
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
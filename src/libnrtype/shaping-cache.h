@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::Text::ShapingCache - glyph strings shaped by Pango, shared between text layouts
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef LIBNRTYPE_SHAPING_CACHE_H
+#define LIBNRTYPE_SHAPING_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <pango/pango.h>
+
+#include "debug/heap.h"
+
+namespace Inkscape {
+namespace Text {
+
+/**
+ * A bounded, thread-safe cache of the results of pango_shape_full().
+ *
+ * Shaping a run of text only depends on the font and analysis of its Pango item, the text itself,
+ * and a few characters of context on either side. Results are cached under all of these, so that
+ * when a document with thousands of labels is laid out again because one of them changed, the
+ * others are not shaped again. The least recently used results are discarded first.
+ *
+ * It is listed as a heap in the memory dialog, along with its hit rate.
+ */
+class ShapingCache final : public Debug::Heap
+{
+public:
+    /// The cache shared by all text layouts.
+    static ShapingCache &get();
+
+    ShapingCache(ShapingCache const &) = delete;
+    ShapingCache &operator=(ShapingCache const &) = delete;
+
+    /**
+     * Same as pango_shape_full(), but returns a cached result if there is one.
+     *
+     * @param paragraph_length The length of @a paragraph_text in bytes; unlike with Pango, it must
+     * not be -1.
+     */
+    void shape(char const *item_text, int item_length, char const *paragraph_text, int paragraph_length,
+               PangoAnalysis const *analysis, PangoGlyphString *glyphs);
+
+    /// Discard all results, for example after the installed fonts changed.
+    void clear();
+
+    int features() const override { return SIZE_AVAILABLE | USED_AVAILABLE | HITS_AVAILABLE; }
+    char const *name() const override { return "shaped text"; }
+    Stats stats() const override;
+    void force_collect() override {}
+
+private:
+    ShapingCache() = default;
+    ~ShapingCache() override = default;
+
+    struct Key
+    {
+        PangoFont *font;
+        PangoLanguage *language;
+        guint8 level;
+        guint8 gravity;
+        guint8 flags;
+        guint32 script;
+        std::vector<PangoAttribute *> attrs;
+        std::string text; ///< Context before, the text itself, and context after.
+        std::size_t context_before;
+
+        Key() = default;
+        Key(Key &&other) noexcept;
+        Key(Key const &) = delete;
+        ~Key();
+
+        bool operator==(Key const &other) const;
+    };
+
+    // Entries are looked up through pointers to the keys they hold.
+    struct KeyHash
+    {
+        std::size_t operator()(Key const *key) const;
+    };
+    struct KeyEqual
+    {
+        bool operator()(Key const *a, Key const *b) const { return *a == *b; }
+    };
+
+    struct Entry
+    {
+        Key key;
+        PangoGlyphString *glyphs;
+    };
+    using LRU = std::list<Entry>;
+
+    static Key _make_key(char const *item_text, int item_length, char const *paragraph_text, int paragraph_length,
+                         PangoAnalysis const *analysis);
+    static std::size_t _size(Entry const &entry);
+    void _evict();
+
+    mutable std::mutex _mutex;
+    LRU _lru; ///< Most recently used first.
+    std::unordered_map<Key const *, LRU::iterator, KeyHash, KeyEqual> _entries;
+    std::size_t _bytes = 0;
+    std::atomic<unsigned long> _hits{};
+    std::atomic<unsigned long> _misses{};
+};
+
+} // namespace Text
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_SHAPING_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
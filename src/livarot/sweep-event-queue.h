@@ -10,7 +10,7 @@
 #ifndef SEEN_LIVAROT_SWEEP_EVENT_QUEUE_H
 #define SEEN_LIVAROT_SWEEP_EVENT_QUEUE_H
 
-#include <2geom/forward.h>
+#include <2geom/point.h>
 class SweepEvent;
 class SweepTree;
 
@@ -19,7 +19,9 @@ class SweepTree;
  * The structure to hold the intersections events encountered during the sweep.  It's an array of
  * SweepEvent (not allocated with "new SweepEvent[n]" but with a malloc).  There's a list of
  * indices because it's a binary heap: inds[i] tell that events[inds[i]] has position i in the
- * heap.  Each SweepEvent has a field to store its index in the heap, too.
+ * heap.  Each SweepEvent has a field to store its index in the heap, too.  The position of each
+ * event is also stored alongside its heap index in keys, so that sifting events up and down the
+ * heap only touches these two arrays.
  */
 class SweepEventQueue
 {
@@ -91,6 +93,7 @@ private:
     int nbEvt;           /*!< Number of events currently in the heap. */
     int maxEvt;          /*!< Allocated size of the heap. */
     int *inds;           /*!< Indices. */
+    Geom::Point *keys;   /*!< keys[i] is the position of events[inds[i]]. */
     SweepEvent *events;  /*!< Sweep events. */
 };
 
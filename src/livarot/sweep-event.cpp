@@ -13,6 +13,16 @@
 #include "livarot/sweep-event.h"
 #include "livarot/Shape.h"
 
+namespace {
+
+/// Whether an event at @a a comes before one at @a b in the sweep, top to bottom then left to right.
+bool sweeps_before(Geom::Point const &a, Geom::Point const &b)
+{
+    return a[1] < b[1] || (a[1] == b[1] && a[0] < b[0]);
+}
+
+} // namespace
+
 SweepEventQueue::SweepEventQueue(int s) : nbEvt(0), maxEvt(s)
 {
     /* FIXME: use new[] for this, but this causes problems when delete[]
@@ -20,17 +30,19 @@ SweepEventQueue::SweepEventQueue(int s) : nbEvt(0), maxEvt(s)
     */
     events = (SweepEvent *) g_malloc(maxEvt * sizeof(SweepEvent));
     inds = new int[maxEvt];
+    keys = new Geom::Point[maxEvt];
 }
 
 SweepEventQueue::~SweepEventQueue()
 {
     g_free(events);
     delete []inds;
+    delete []keys;
 }
 
 SweepEvent *SweepEventQueue::add(SweepTree *iLeft, SweepTree *iRight, Geom::Point &px, double itl, double itr)
 {
-    if (nbEvt > maxEvt) {
+    if (nbEvt >= maxEvt) {
 	return nullptr;
     }
     
@@ -45,26 +57,23 @@ SweepEvent *SweepEventQueue::add(SweepTree *iLeft, SweepTree *iRight, Geom::Poin
 	s->pData[n].pending++;;
     }
 
-    events[n].ind = n;
-    inds[n] = n;
-
+    // Sift up, moving parents down until the new event's place is found.
     int curInd = n;
     while (curInd > 0) {
 	int const half = (curInd - 1) / 2;
-	int const no = inds[half];
-	if (px[1] < events[no].posx[1]
-	    || (px[1] == events[no].posx[1] && px[0] < events[no].posx[0]))
-	{
-	    events[n].ind = half;
-	    events[no].ind = curInd;
-	    inds[half] = n;
-	    inds[curInd] = no;
-	} else {
+	if (!sweeps_before(px, keys[half])) {
 	    break;
 	}
-	
+	int const no = inds[half];
+	events[no].ind = curInd;
+	inds[curInd] = no;
+	keys[curInd] = keys[half];
 	curInd = half;
     }
+
+    events[n].ind = curInd;
+    inds[curInd] = n;
+    keys[curInd] = px;
   
     return events + n;
 }
@@ -116,98 +125,65 @@ void SweepEventQueue::remove(SweepEvent *e)
     }
     
     int const n = e->ind;
-    int to = inds[n];
+    int const freed = inds[n];
     e->MakeDelete();
-    relocate(&events[--nbEvt], to);
+    // keep the events packed, by moving the last one into the freed slot
+    relocate(&events[--nbEvt], freed);
 
+    // then fill the hole in the heap with its last element, and sift that into place
     int const moveInd = nbEvt;
     if (moveInd == n) {
 	return;
     }
     
-    to = inds[moveInd];
-
-    events[to].ind = n;
-    inds[n] = to;
+    int const to = inds[moveInd];
+    Geom::Point const px = keys[moveInd];
 
     int curInd = n;
-    Geom::Point const px = events[to].posx;
     bool didClimb = false;
     while (curInd > 0) {
 	int const half = (curInd - 1) / 2;
-	int const no = inds[half];
-	if (px[1] < events[no].posx[1]
-	    || (px[1] == events[no].posx[1] && px[0] < events[no].posx[0]))
-	{
-	  events[to].ind = half;
-	  events[no].ind = curInd;
-	  inds[half] = to;
-	  inds[curInd] = no;
-	  didClimb = true;
-	} else {
+	if (!sweeps_before(px, keys[half])) {
 	    break;
 	}
+	int const no = inds[half];
+	events[no].ind = curInd;
+	inds[curInd] = no;
+	keys[curInd] = keys[half];
 	curInd = half;
+	didClimb = true;
     }
     
-    if (didClimb) {
-	return;
-    }
-    
-    while (2 * curInd + 1 < nbEvt) {
-	int const child1 = 2 * curInd + 1;
-	int const child2 = child1 + 1;
-	int const no1 = inds[child1];
-	int const no2 = inds[child2];
-	if (child2 < nbEvt) {
-	    if (px[1] > events[no1].posx[1]
-		|| (px[1] == events[no1].posx[1]
-		    && px[0] > events[no1].posx[0]))
-	    {
-		if (events[no2].posx[1] > events[no1].posx[1]
-		    || (events[no2].posx[1] == events[no1].posx[1]
-			&& events[no2].posx[0] > events[no1].posx[0]))
-		{
-		    events[to].ind = child1;
-		    events[no1].ind = curInd;
-		    inds[child1] = to;
-		    inds[curInd] = no1;
-		    curInd = child1;
-		} else {
-		    events[to].ind = child2;
-		    events[no2].ind = curInd;
-		    inds[child2] = to;
-		    inds[curInd] = no2;
-		    curInd = child2;
-		}
-	    } else {
-		if (px[1] > events[no2].posx[1]
-		    || (px[1] == events[no2].posx[1]
-			&& px[0] > events[no2].posx[0]))
-		{
-		    events[to].ind = child2;
-		    events[no2].ind = curInd;
-		    inds[child2] = to;
-		    inds[curInd] = no2;
-		    curInd = child2;
+    if (!didClimb) {
+	while (2 * curInd + 1 < nbEvt) {
+	    int const child1 = 2 * curInd + 1;
+	    int const child2 = child1 + 1;
+	    int child = child1;
+	    if (child2 < nbEvt) {
+		if (sweeps_before(keys[child1], px)) {
+		    if (!sweeps_before(keys[child1], keys[child2])) {
+			child = child2;
+		    }
+		} else if (sweeps_before(keys[child2], px)) {
+		    child = child2;
 		} else {
 		    break;
 		}
+	    } else if (!sweeps_before(keys[child1], px)) {
+		break;
 	    }
-	} else {
-	    if (px[1] > events[no1].posx[1]
-		|| (px[1] == events[no1].posx[1]
-		    && px[0] > events[no1].posx[0]))
-	    {
-		events[to].ind = child1;
-		events[no1].ind = curInd;
-		inds[child1] = to;
-		inds[curInd] = no1;
-	    }
-	    
-	    break;
+
+	    int const no = inds[child];
+	    events[no].ind = curInd;
+	    inds[curInd] = no;
+	    keys[curInd] = keys[child];
+	    curInd = child;
 	}
     }
+
+    events[to].ind = curInd;
+    inds[curInd] = to;
+    keys[curInd] = px;
 }
 
 
@@ -47,6 +47,16 @@ SweepTree::ConvertTo(Shape *iSrc, int iBord, int iWeight, int iStartPoint)
     src = iSrc;
     bord = iBord;
     evt[LEFT] = evt[RIGHT] = nullptr;
+
+    // The rounded geometry of the source shape stays the same during a sweep, so look it up once
+    // here instead of at every step of the searches in the tree.
+    Shape::dg_arete const &e = src->getEdge(bord);
+    orig = src->pData[e.st].rx;
+    norm = src->eData[bord].rdx;
+    if (e.st > e.en) {
+        norm = -norm;
+    }
+    norm = norm.ccw();
 }
 
 
@@ -72,15 +82,10 @@ SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
                 SweepTree *&insertR, bool sweepSens)
 {
     // get the edge associated with this node: one point+one direction
-    // since we're dealing with line, the direction (bNorm) is taken downwards
-    Geom::Point bOrig, bNorm;
-    bOrig = src->pData[src->getEdge(bord).st].rx;
-    bNorm = src->eData[bord].rdx;
-    if (src->getEdge(bord).st > src->getEdge(bord).en) {
-        bNorm = -bNorm;
-    }
-    // rotate to get the normal to the edge
-    bNorm=bNorm.ccw();
+    // since we're dealing with line, the direction (bNorm) is taken downwards,
+    // and rotated to get the normal to the edge (see ConvertTo())
+    Geom::Point const &bOrig = orig;
+    Geom::Point const &bNorm = norm;
 
     Geom::Point diff;
     diff = px - bOrig;
@@ -99,14 +104,7 @@ SweepTree::Find(Geom::Point const &px, SweepTree *newOne, SweepTree *&insertL,
         // sweepSens is needed (actually only used by the Scan() functions) because if the sweepline goes upward,
         // signs change
         // prendre en compte les directions
-        Geom::Point nNorm;
-        nNorm = newOne->src->eData[newOne->bord].rdx;
-        if (newOne->src->getEdge(newOne->bord).st >
-            newOne->src->getEdge(newOne->bord).en)
-	{
-            nNorm = -nNorm;
-	}
-        nNorm=nNorm.ccw();
+        Geom::Point const &nNorm = newOne->norm;
 
         if (sweepSens) {
             y = cross(bNorm, nNorm);
@@ -159,18 +157,11 @@ int
 SweepTree::Find(Geom::Point const &px, SweepTree * &insertL,
 		 SweepTree * &insertR)
 {
-    Geom::Point bOrig, bNorm;
     // The start point of the original edge vector
-    bOrig = src->pData[src->getEdge(bord).st].rx;
-    // The edge vector
-    bNorm = src->eData[bord].rdx;
-    // Flip the edge vector if it's bottom to top or horizontal and right to left
-    if (src->getEdge(bord).st > src->getEdge(bord).en)
-    {
-        bNorm = -bNorm;
-    }
-    // rotate the edge vector counter clockwise by 90 degrees
-    bNorm=bNorm.ccw();
+    Geom::Point const &bOrig = orig;
+    // The edge vector, flipped if it's bottom to top or horizontal and right to left, and
+    // rotated counter clockwise by 90 degrees (see ConvertTo())
+    Geom::Point const &bNorm = norm;
 
     // draw a vector from the start point to the actual point
     Geom::Point diff;
@@ -513,6 +504,8 @@ SweepTree::Relocate(SweepTree * to)
   AVLTree::Relocate(to);
   to->src = src;
   to->bord = bord;
+  to->orig = orig;
+  to->norm = norm;
   to->evt[LEFT] = evt[LEFT];
   to->evt[RIGHT] = evt[RIGHT];
   if (unsigned(bord) < src->swsData.size())
@@ -537,6 +530,8 @@ SweepTree::SwapWithRight(SweepTreeList &/*list*/, SweepEventQueue &/*queue*/)
 
     std::swap(tL->src, tR->src);
     std::swap(tL->bord, tR->bord);
+    std::swap(tL->orig, tR->orig);
+    std::swap(tL->norm, tR->norm);
 }
 
 /*
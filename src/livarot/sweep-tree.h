@@ -47,6 +47,11 @@ public:
                                edges can come from 2 different polygons.) */
     int bord;             /*!< Edge index in the Shape. */
 
+    Geom::Point orig;     /*!< Rounded start point of the edge, copied from the Shape so that Find()
+                               does not have to look it up for every node it visits. */
+    Geom::Point norm;     /*!< The rounded edge vector oriented top to bottom (or left to right if
+                               horizontal) and rotated counter-clockwise by 90 degrees. Cached like orig. */
+
     SweepTree();
     ~SweepTree() override;
 
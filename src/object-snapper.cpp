@@ -17,6 +17,7 @@
 #include <2geom/line.h>
 #include <2geom/path-intersection.h>
 #include <2geom/path-sink.h>
+#include <algorithm>
 #include <memory>
 
 #include "desktop.h"
@@ -395,6 +396,23 @@ void Inkscape::ObjectSnapper::_collectPaths(Geom::Point /*p*/,
     }
 }
 
+/// Measure the paths and curves of a snap target, unless that was done already.
+static std::vector<Inkscape::SnapCandidatePath::SegmentBounds> const &get_segment_bounds(Inkscape::SnapCandidatePath &target)
+{
+    if (target.segment_bounds.empty()) {
+        target.segment_bounds.reserve(target.path_vector.size());
+        for (auto const &path : target.path_vector) {
+            auto &bounds = target.segment_bounds.emplace_back();
+            bounds.path = path.boundsFast();
+            bounds.curves.reserve(path.size_default());
+            for (std::size_t i = 0; i < path.size_default(); i++) {
+                bounds.curves.push_back(path[i].boundsFast());
+            }
+        }
+    }
+    return target.segment_bounds;
+}
+
 void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
                                      SnapCandidatePoint const &p,
                                      std::vector<SnapCandidatePoint> *unselected_nodes,
@@ -432,25 +450,32 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
     bool strict_snapping = _snapmanager->snapprefs.getStrictSnapping();
     bool snap_perp = _snapmanager->snapprefs.isTargetSnappable(Inkscape::SNAPTARGET_PATH_PERPENDICULAR);
     bool snap_tang = _snapmanager->snapprefs.isTargetSnappable(Inkscape::SNAPTARGET_PATH_TANGENTIAL);
+    Geom::Coord const tolerance = getSnapperTolerance();
 
     //dt->getSnapIndicator()->remove_debugging_points();
-    for (const auto & it_p : *_paths_to_snap_to) {
+    for (auto & it_p : *_paths_to_snap_to) {
         if (_allowSourceToSnapToTarget(p.getSourceType(), it_p.target_type, strict_snapping)) {
             bool const being_edited = node_tool_active && it_p.currently_being_edited;
             //if true then this pathvector it_pv is currently being edited in the node tool
 
-            for (auto &it_pv : it_p.path_vector) {
-                // Find a nearest point for each curve within this path
-                // n curves will return n time values with 0 <= t <= 1
-                std::vector<double> anp = it_pv.nearestTimePerCurve(p_doc);
+            auto const &segment_bounds = get_segment_bounds(it_p);
+            for (std::size_t i = 0; i < it_p.path_vector.size(); i++, num_path++) {
+                // No point on a path or curve is closer than its bounds, so only those curves that
+                // are near enough need to be looked at
+                if (!segment_bounds[i].path || Geom::distance(p_doc, *segment_bounds[i].path) >= tolerance) {
+                    continue;
+                }
+                auto const &it_pv = it_p.path_vector[i];
+                auto const &curve_bounds = segment_bounds[i].curves;
 
-                //std::cout << "#nearest points = " << anp.size() << " | p = " << p.getPoint() << std::endl;
-                // Now we will examine each of the nearest points, and determine whether it's within snapping range and if we should snap to it
-                std::vector<double>::const_iterator np = anp.begin();
-                unsigned int index = 0;
-                for (; np != anp.end(); ++np, index++) {
+                // Find the nearest point on each curve that is within range, and determine whether we should snap to it
+                for (unsigned int index = 0; index < curve_bounds.size(); index++) {
+                    if (Geom::distance(p_doc, curve_bounds[index]) >= tolerance) {
+                        continue;
+                    }
                     Geom::Curve const *curve = &it_pv.at(index);
-                    Geom::Point const sp_doc = curve->pointAt(*np);
+                    double const np = curve->nearestTime(p_doc);
+                    Geom::Point const sp_doc = curve->pointAt(np);
                     //dt->getSnapIndicator()->set_new_debugging_point(sp_doc*dt->doc2dt());
                     bool c1 = true;
                     bool c2 = true;
@@ -478,17 +503,17 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
                     if (!being_edited || (c1 && c2)) {
                         Geom::Coord dist = Geom::distance(sp_doc, p_doc);
                         // std::cout << "  dist -> " << dist << std::endl;
-                        if (dist < getSnapperTolerance()) {
+                        if (dist < tolerance) {
                             // Add the curve we have snapped to
                             Geom::Point sp_tangent_dt = Geom::Point(0,0);
                             if (p.getSourceType() == Inkscape::SNAPSOURCE_GUIDE_ORIGIN) {
                                 // We currently only use the tangent when snapping guides, so only in this case we will
                                 // actually calculate the tangent to avoid wasting CPU cycles
-                                Geom::Point sp_tangent_doc = curve->unitTangentAt(*np);
+                                Geom::Point sp_tangent_doc = curve->unitTangentAt(np);
                                 sp_tangent_dt = dt->doc2dt(sp_tangent_doc) - dt->doc2dt(Geom::Point(0,0));
                             }
                             bool always = getSnapperAlwaysSnap(p.getSourceType());
-                            isr.curves.emplace_back(sp_dt, sp_tangent_dt, num_path, index, dist, getSnapperTolerance(), always, false, curve, p.getSourceType(), p.getSourceNum(), it_p.target_type, it_p.target_bbox);
+                            isr.curves.emplace_back(sp_dt, sp_tangent_dt, num_path, index, dist, tolerance, always, false, curve, p.getSourceType(), p.getSourceNum(), it_p.target_type, it_p.target_bbox);
                             if (snap_tang || snap_perp) {
                                 // For each curve that's within snapping range, we will now also search for tangential and perpendicular snaps
                                 _snapPathsTangPerp(snap_tang, snap_perp, isr, p, curve, dt);
@@ -496,7 +521,6 @@ void Inkscape::ObjectSnapper::_snapPaths(IntermSnapResults &isr,
                         }
                     }
                 }
-                num_path++;
             } // End of: for (Geom::PathVector::iterator ....)
         }
     }
@@ -586,8 +610,17 @@ void Inkscape::ObjectSnapper::_snapPathsConstrained(IntermSnapResults &isr,
     bool strict_snapping = _snapmanager->snapprefs.getStrictSnapping();
 
     // Find all intersections of the constrained path with the snap target candidates
-    for (const auto & k : *_paths_to_snap_to) {
+    auto const constraint_bounds = constraint_path.boundsFast();
+    for (auto & k : *_paths_to_snap_to) {
         if (_allowSourceToSnapToTarget(p.getSourceType(), k.target_type, strict_snapping)) {
+            // Skip the intersection math for paths that cannot reach the constraint
+            auto const &segment_bounds = get_segment_bounds(k);
+            if (std::none_of(segment_bounds.begin(), segment_bounds.end(), [&] (auto const &bounds) {
+                    return bounds.path && constraint_bounds && bounds.path->intersects(*constraint_bounds);
+                })) {
+                continue;
+            }
+
             // Do the intersection math
             std::vector<Geom::PVIntersection> inters = constraint_path.intersect(k.path_vector);
 
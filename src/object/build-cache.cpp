@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::BuildCache - attribute values parsed in parallel ahead of building the object tree
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "build-cache.h"
+
+#include <cstring>
+#include <utility>
+
+#include "display/dispatch-pool.h"
+#include "display/threading.h"
+#include "svg/svg.h"
+#include "xml/node.h"
+
+namespace Inkscape {
+
+namespace {
+
+// Below this many attributes, parsing them as the objects are built is just as fast.
+constexpr std::size_t MIN_PARALLEL_ENTRIES = 64;
+
+} // namespace
+
+BuildCache::BuildCache(XML::Node *root)
+{
+    // Collect the values on this thread; the workers only ever see the strings.
+    _collect(root);
+    if (_entries.size() < MIN_PARALLEL_ENTRIES) {
+        _entries.clear();
+        return;
+    }
+
+    get_global_dispatch_pool()->dispatch(_entries.size(), [this] (int i, int) {
+        auto &entry = _entries[i];
+        if (entry.path_value) {
+            entry.path = sp_svg_read_pathv(entry.path_value.pointer());
+        }
+        if (entry.style_value) {
+            entry.style = cr_declaration_parse_list_from_buf(reinterpret_cast<guchar const *>(entry.style_value.pointer()), CR_UTF_8);
+        }
+    });
+
+    _index.reserve(_entries.size());
+    for (std::size_t i = 0; i < _entries.size(); i++) {
+        _index.emplace(_entries[i].repr, i);
+    }
+}
+
+BuildCache::~BuildCache()
+{
+    for (auto &entry : _entries) {
+        if (entry.style) {
+            cr_declaration_destroy(entry.style);
+        }
+    }
+}
+
+void BuildCache::_collect(XML::Node *repr)
+{
+    if (repr->type() != XML::NodeType::ELEMENT_NODE) {
+        return;
+    }
+
+    auto const style = repr->attribute("style");
+    auto const path = std::strcmp(repr->name(), "svg:path") == 0 ? repr->attribute("d") : nullptr;
+    if ((style && *style) || path) {
+        auto &entry = _entries.emplace_back(repr);
+        if (style && *style) {
+            entry.style_value = Util::share_unsafe(style);
+        }
+        if (path) {
+            entry.path_value = Util::share_unsafe(path);
+        }
+    }
+
+    for (auto child = repr->firstChild(); child; child = child->next()) {
+        _collect(child);
+    }
+}
+
+BuildCache::Entry *BuildCache::_find(XML::Node const *repr)
+{
+    auto it = _index.find(repr);
+    return it != _index.end() ? &_entries[it->second] : nullptr;
+}
+
+std::optional<Geom::PathVector> BuildCache::takePath(XML::Node const *repr, char const *value)
+{
+    auto entry = _find(repr);
+    if (!entry || !entry->path || entry->path_value.pointer() != value) {
+        return {};
+    }
+    return std::exchange(entry->path, {});
+}
+
+CRDeclaration *BuildCache::takeStyle(XML::Node const *repr, char const *value)
+{
+    auto entry = _find(repr);
+    if (!entry || entry->style_value.pointer() != value) {
+        return nullptr;
+    }
+    return std::exchange(entry->style, nullptr);
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::BuildCache - attribute values parsed in parallel ahead of building the object tree
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_OBJECT_BUILD_CACHE_H
+#define SEEN_INKSCAPE_OBJECT_BUILD_CACHE_H
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <2geom/pathvector.h>
+
+#include "3rdparty/libcroco/src/cr-declaration.h"
+#include "inkgc/gc-alloc.h"
+#include "util/share.h"
+
+namespace Inkscape {
+
+namespace XML {
+class Node;
+} // namespace XML
+
+/**
+ * Attribute values of a repr tree, parsed in parallel before its objects are built.
+ *
+ * Building the object tree is inherently serial, as objects register their ids, resolve
+ * references and connect to each other while they are built. Most of the time spent opening
+ * a large document, however, goes into parsing path data and style attributes, which depends on
+ * nothing but the attribute value. This is done for the whole tree up front, using the global
+ * dispatch pool, and picked up by the objects as they read their attributes.
+ *
+ * Results are matched against the attribute value they were parsed from, so an attribute that
+ * was changed in the meantime is simply parsed again by its object. The entries live in memory
+ * scanned by the garbage collector, so the nodes and values they refer to stay alive, and a new
+ * value can never turn up at the address of an old one.
+ */
+class BuildCache
+{
+public:
+    explicit BuildCache(XML::Node *root);
+    ~BuildCache();
+
+    BuildCache(BuildCache const &) = delete;
+    BuildCache &operator=(BuildCache const &) = delete;
+
+    /// Take the path data parsed from @a value, the 'd' attribute of @a repr.
+    std::optional<Geom::PathVector> takePath(XML::Node const *repr, char const *value);
+
+    /// Take the declarations parsed from @a value, the 'style' attribute of @a repr.
+    /// The caller must destroy them. Returns nullptr if they were not parsed in advance.
+    CRDeclaration *takeStyle(XML::Node const *repr, char const *value);
+
+private:
+    struct Entry
+    {
+        XML::Node const *repr;
+        Util::ptr_shared path_value;
+        Util::ptr_shared style_value;
+        std::optional<Geom::PathVector> path;
+        CRDeclaration *style = nullptr;
+    };
+
+    void _collect(XML::Node *repr);
+    Entry *_find(XML::Node const *repr);
+
+    std::vector<Entry, GC::Alloc<Entry, GC::SCANNED, GC::MANUAL>> _entries;
+    std::unordered_map<XML::Node const *, std::size_t> _index;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_OBJECT_BUILD_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
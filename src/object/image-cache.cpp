@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::ImageCache - bitmap images loaded in the background and shared between <image> elements
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "image-cache.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "display/cairo-utils.h"
+#include "display/task-scheduler.h"
+#include "display/threading.h"
+#include "sp-image.h"
+#include "uri.h"
+
+namespace Inkscape {
+
+struct ImageCache::Load
+{
+    explicit Load(Key &&key) : key(std::move(key)) {}
+
+    Key const key;
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    enum { QUEUED, RUNNING, DONE } state = QUEUED;
+    std::shared_ptr<Pixbuf const> pixbuf; ///< The result of loading, until it is first taken.
+    std::weak_ptr<Pixbuf const> shared;   ///< The image handed out to elements.
+    bool stale = false;                   ///< Whether a sweep found the result not taken yet.
+};
+
+namespace {
+
+/// Whether the file an image was loaded from was modified since, as in SPImage::refresh_if_outdated().
+bool is_outdated(Pixbuf const &pixbuf)
+{
+    if (!pixbuf.modificationTime()) {
+        return false;
+    }
+    GStatBuf st;
+    std::memset(&st, 0, sizeof(st));
+    if (!g_file_test(pixbuf.originalPath().c_str(), G_FILE_TEST_EXISTS) || g_stat(pixbuf.originalPath().c_str(), &st)) {
+        return false;
+    }
+    return st.st_mtime != pixbuf.modificationTime();
+}
+
+} // namespace
+
+ImageCache &ImageCache::get()
+{
+    static ImageCache cache;
+    return cache;
+}
+
+std::size_t ImageCache::KeyHash::operator()(Key const *key) const
+{
+    auto hash = std::hash<std::string>{}(key->href);
+    hash = hash * 1128467 + key->length;
+    hash = hash * 1128467 + std::hash<std::string>{}(key->base);
+    hash = hash * 1128467 + std::hash<double>{}(key->svgdpi);
+    return hash;
+}
+
+ImageCache::Key ImageCache::_make_key(char const *href, char const *base, double svgdpi)
+{
+    if (!href) {
+        href = "";
+    }
+
+    Key key;
+    key.length = std::strlen(href);
+    key.base = base ? base : "";
+    key.svgdpi = svgdpi;
+
+    // Data URIs are often megabytes long; rather than keeping a copy for as long as the image is
+    // used, keep a digest.
+    if (g_ascii_strncasecmp(href, "data:", 5) == 0) {
+        auto const digest = g_compute_checksum_for_string(G_CHECKSUM_SHA256, href, key.length);
+        key.href = digest;
+        g_free(digest);
+    } else {
+        key.href = href;
+    }
+
+    return key;
+}
+
+/**
+ * Decode an image in a way that is safe to do off the main thread: a raster image embedded in a
+ * data URI or referring to a local file. Return nullptr for anything else, and for images that
+ * failed to load, to be loaded by SPImage::readImage() on the main thread instead.
+ */
+Pixbuf *ImageCache::_decode(char const *href, std::string const &base, double svgdpi)
+{
+    Pixbuf *pixbuf = nullptr;
+
+    if (g_ascii_strncasecmp(href, "data:", 5) == 0) {
+        auto const data = std::string_view(href);
+        auto const header = data.substr(0, data.find(','));
+        if (header.find("svg") == std::string_view::npos) {
+            pixbuf = Pixbuf::create_from_data_uri(href + 5, svgdpi);
+        }
+    } else if (*href) {
+        try {
+            auto const url = URI::from_href_and_basedir(href, base.empty() ? nullptr : base.c_str());
+            if (url.hasScheme("file")) {
+                auto const filename = url.toNativeFilename();
+                auto const dot = filename.rfind('.');
+                if (dot == std::string::npos || g_ascii_strcasecmp(filename.c_str() + dot + 1, "svg") != 0) {
+                    pixbuf = Pixbuf::create_from_file(filename, svgdpi);
+                }
+            }
+        } catch (...) {
+            // Malformed reference; leave the warning to readImage().
+        }
+    }
+
+    if (pixbuf) {
+        pixbuf->ensurePixelFormat(Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
+    }
+    return pixbuf;
+}
+
+/**
+ * Forget finished loads whose image is no longer used. A result that was not taken by the time of
+ * two sweeps is dropped as well: the element it was loaded for was changed or removed before its
+ * update, or looked up the image differently.
+ */
+void ImageCache::_sweep()
+{
+    for (auto it = _loads.begin(); it != _loads.end();) {
+        bool unused;
+        {
+            auto &load = *it->second;
+            std::scoped_lock lock(load.mutex);
+            if (load.state == Load::DONE && load.pixbuf) {
+                unused = load.stale && load.shared.expired();
+                load.stale = true;
+            } else {
+                unused = load.state == Load::DONE && load.shared.expired();
+            }
+        }
+        it = unused ? _loads.erase(it) : std::next(it);
+    }
+    _sweep_at = std::max<std::size_t>(64, 2 * _loads.size());
+}
+
+void ImageCache::prefetch(char const *href, char const *base, double svgdpi)
+{
+    if (!href) {
+        return;
+    }
+
+    auto key = _make_key(href, base, svgdpi);
+
+    std::shared_ptr<Load> load;
+    {
+        std::scoped_lock lock(_mutex);
+        if (auto it = _loads.find(&key); it != _loads.end()) {
+            load = it->second;
+            std::scoped_lock load_lock(load->mutex);
+            if (load->state != Load::DONE || load->pixbuf || !load->shared.expired()) {
+                return; // Loading, or loaded and in use.
+            }
+            load->state = Load::QUEUED;
+            load->stale = false;
+        } else {
+            if (_loads.size() >= _sweep_at) {
+                _sweep();
+            }
+            load = std::make_shared<Load>(std::move(key));
+            _loads.emplace(&load->key, load);
+        }
+    }
+
+    // The reference is only kept until the image is decoded.
+    get_global_task_scheduler()->post([load, href = std::string(href)] {
+        std::unique_lock lock(load->mutex);
+        if (load->state != Load::QUEUED) {
+            return; // Taken over by load().
+        }
+        load->state = Load::RUNNING;
+        lock.unlock();
+
+        auto const pixbuf = _decode(href.c_str(), load->key.base, load->key.svgdpi);
+
+        lock.lock();
+        load->pixbuf.reset(pixbuf);
+        load->state = Load::DONE;
+        load->done_cv.notify_all();
+    });
+}
+
+std::shared_ptr<Pixbuf const> ImageCache::load(char const *href, char const *absref, char const *base, double svgdpi)
+{
+    auto key = _make_key(href, base, svgdpi);
+
+    std::shared_ptr<Load> load;
+    {
+        std::scoped_lock lock(_mutex);
+        if (auto it = _loads.find(&key); it != _loads.end()) {
+            load = it->second;
+        } else {
+            if (_loads.size() >= _sweep_at) {
+                _sweep();
+            }
+            load = std::make_shared<Load>(std::move(key));
+            load->state = Load::DONE;
+            _loads.emplace(&load->key, load);
+        }
+    }
+
+    std::unique_lock lock(load->mutex);
+    if (load->state == Load::QUEUED) {
+        // Not started yet; rather than waiting behind other tasks, do it here.
+        load->state = Load::RUNNING;
+        lock.unlock();
+        auto const pixbuf = _decode(href ? href : "", load->key.base, load->key.svgdpi);
+        lock.lock();
+        load->pixbuf.reset(pixbuf);
+        load->state = Load::DONE;
+        load->done_cv.notify_all();
+    } else {
+        load->done_cv.wait(lock, [&] { return load->state == Load::DONE; });
+    }
+
+    auto result = load->pixbuf ? load->pixbuf : load->shared.lock();
+    if (result && is_outdated(*result)) {
+        result.reset();
+    }
+
+    bool share = true;
+    if (!result) {
+        // Not loaded in the background, failed to, or must be loaded again.
+        lock.unlock();
+        auto const pixbuf = SPImage::readImage(href, absref, base, svgdpi);
+        if (pixbuf) {
+            pixbuf->ensurePixelFormat(Pixbuf::PF_CAIRO);
+        }
+        result.reset(pixbuf);
+        lock.lock();
+        // The image may have come from the fallback reference, which is not part of the key.
+        share = !absref;
+    }
+
+    load->pixbuf.reset();
+    if (share) {
+        load->shared = result;
+    }
+    lock.unlock();
+
+    if (result) {
+        _retain(result);
+    }
+    return result;
+}
+
+void ImageCache::set_retained_bytes(std::size_t bytes)
+{
+    std::scoped_lock lock(_mutex);
+    _max_retained_bytes = bytes;
+    _trim();
+}
+
+void ImageCache::_retain(std::shared_ptr<Pixbuf const> const &pixbuf)
+{
+    std::scoped_lock lock(_mutex);
+    if (_max_retained_bytes == 0) {
+        return;
+    }
+    auto const size = (std::size_t)pixbuf->rowstride() * pixbuf->height();
+    if (auto it = std::find(_retained.begin(), _retained.end(), pixbuf); it != _retained.end()) {
+        _retained.erase(it);
+        _retained_bytes -= size;
+    }
+    _retained.push_back(pixbuf);
+    _retained_bytes += size;
+    _trim();
+}
+
+void ImageCache::_trim()
+{
+    while (!_retained.empty() && _retained_bytes > _max_retained_bytes) {
+        auto const &pixbuf = _retained.front();
+        _retained_bytes -= (std::size_t)pixbuf->rowstride() * pixbuf->height();
+        _retained.pop_front();
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::ImageCache - bitmap images loaded in the background and shared between <image> elements
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_OBJECT_IMAGE_CACHE_H
+#define SEEN_INKSCAPE_OBJECT_IMAGE_CACHE_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Inkscape {
+
+class Pixbuf;
+
+/**
+ * Loads the images of <image> elements, ahead of time and only once.
+ *
+ * Decoding the images of a document used to take up most of the time spent opening it if it had
+ * many embedded photos, one image after the other, as the images were updated. Instead, an image
+ * now starts loading on the shared task scheduler as soon as its element reads its reference,
+ * while the rest of the document is still being built, and the update only picks up the result.
+ *
+ * Elements that refer to the same data or file share the same image, for as long as any of them
+ * holds it. Images from files are loaded again when the file was modified.
+ *
+ * Only PNG, JPEG and other formats read by GdkPixbuf are loaded in the background. SVG images
+ * are loaded as documents, which can only be done on the main thread; they are loaded when first
+ * needed, and are shared all the same.
+ */
+class ImageCache
+{
+public:
+    static ImageCache &get();
+
+    ImageCache(ImageCache const &) = delete;
+    ImageCache &operator=(ImageCache const &) = delete;
+
+    /// Start loading an image in the background, if it can be and was not already.
+    /// The arguments are those of SPImage::readImage(), less the fallback absolute reference.
+    void prefetch(char const *href, char const *base, double svgdpi);
+
+    /**
+     * Get an image, waiting for it if it is being loaded, or else loading it now.
+     *
+     * @return The image, in the pixel format expected by the renderer, or nullptr if it could
+     * not be loaded.
+     */
+    std::shared_ptr<Pixbuf const> load(char const *href, char const *absref, char const *base, double svgdpi);
+
+    /**
+     * Keep the most recently loaded images, up to @a bytes of them, even when no element uses them
+     * anymore, so that documents opened later find them loaded. Nothing is kept by default.
+     */
+    void set_retained_bytes(std::size_t bytes);
+
+private:
+    ImageCache() = default;
+
+    /**
+     * What identifies an image. The fallback absolute reference is left out: it is only read if
+     * the reference cannot be, and is often removed right after the reference is changed.
+     */
+    struct Key
+    {
+        std::string href;   ///< The reference, or for a data URI a digest of it.
+        std::size_t length; ///< The length of the reference.
+        std::string base;
+        double svgdpi;
+
+        bool operator==(Key const &other) const = default;
+    };
+
+    // Loads are looked up through pointers to the keys they hold.
+    struct KeyHash
+    {
+        std::size_t operator()(Key const *key) const;
+    };
+    struct KeyEqual
+    {
+        bool operator()(Key const *a, Key const *b) const { return *a == *b; }
+    };
+
+    struct Load;
+
+    static Key _make_key(char const *href, char const *base, double svgdpi);
+    static Pixbuf *_decode(char const *href, std::string const &base, double svgdpi);
+    void _sweep();
+    void _retain(std::shared_ptr<Pixbuf const> const &pixbuf);
+    void _trim();
+
+    std::mutex _mutex;
+    std::unordered_map<Key const *, std::shared_ptr<Load>, KeyHash, KeyEqual> _loads;
+    std::size_t _sweep_at = 64; ///< Number of loads above which finished ones are forgotten.
+
+    std::deque<std::shared_ptr<Pixbuf const>> _retained; ///< Least recently loaded first.
+    std::size_t _retained_bytes = 0;
+    std::size_t _max_retained_bytes = 0;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_OBJECT_IMAGE_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -30,6 +30,7 @@
 // Added for preserveAspectRatio support -- EAF
 #include "attributes.h"
 #include "document.h"
+#include "image-cache.h"
 #include "print.h"
 #include "snap-candidate.h"
 #include "snap-preferences.h"
@@ -163,6 +164,15 @@ void SPImage::set(SPAttr key, const gchar* value) {
         case SPAttr::XLINK_HREF:
             g_free (this->href);
             this->href = (value) ? g_strdup (value) : nullptr;
+            if (this->href && this->document) {
+                // Start decoding now, while the rest of the document is being built.
+                double svgdpi = 96;
+                if (getRepr()->attribute("inkscape:svg-dpi")) {
+                    svgdpi = g_ascii_strtod(getRepr()->attribute("inkscape:svg-dpi"), nullptr);
+                }
+                Inkscape::ImageCache::get().prefetch(Inkscape::getHrefAttribute(*getRepr()).second,
+                                                     document->getDocumentBase(), svgdpi);
+            }
             this->requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG | SP_IMAGE_HREF_MODIFIED_FLAG);
             break;
 
@@ -244,36 +254,30 @@ void SPImage::update(SPCtx *ctx, unsigned int flags) {
     if (flags & SP_IMAGE_HREF_MODIFIED_FLAG) {
         pixbuf.reset();
         if (href) {
-            Inkscape::Pixbuf *pb = nullptr;
             double svgdpi = 96;
             if (getRepr()->attribute("inkscape:svg-dpi")) {
                 svgdpi = g_ascii_strtod(getRepr()->attribute("inkscape:svg-dpi"), nullptr);
             }
             dpi = svgdpi;
-            pb = readImage(Inkscape::getHrefAttribute(*getRepr()).second,
-                           getRepr()->attribute("sodipodi:absref"),
-                           document->getDocumentBase(), svgdpi);
-            if (!pb) {
+            // Usually loaded in the background already, see set().
+            pixbuf = Inkscape::ImageCache::get().load(Inkscape::getHrefAttribute(*getRepr()).second,
+                                                      getRepr()->attribute("sodipodi:absref"),
+                                                      document->getDocumentBase(), svgdpi);
+            if (!pixbuf) {
                 missing = true;
                 // Passing in our previous size allows us to preserve the image's expected size.
                 auto broken_width = width._set ? width.computed : 640;
                 auto broken_height = height._set ? height.computed : 640;
-                pb = getBrokenImage(broken_width, broken_height);
+                auto pb = getBrokenImage(broken_width, broken_height);
+                pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
+                pixbuf = std::shared_ptr<Inkscape::Pixbuf>(pb);
             }
             else {
                 missing = false;
             }
 
-            if (pb) {
-                if (color_profile) {
-                    if (auto cp = document->getDocumentCMS().getSpace(color_profile)) {
-                        pb->ensurePixelFormat(Inkscape::Pixbuf::PF_GDK);
-                        // XXX TODO cp->transformToRGB(pb);
-                    }
-                }
-                pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
-                pixbuf = std::shared_ptr<Inkscape::Pixbuf>(pb);
-            }
+            // XXX TODO transform the pixbuf with the color profile, if any. Make a copy first: the
+            // pixbuf may be shared with other images.
         }
     }
 
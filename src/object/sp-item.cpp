@@ -26,6 +26,7 @@
 #include "display/drawing-item.h"
 #include "attributes.h"
 #include "document.h"
+#include "document-spatial-index.h"
 #include "preferences.h"
 
 #include "inkscape.h"
@@ -513,6 +514,10 @@ void SPItem::build(SPDocument *document, Inkscape::XML::Node *repr) {
     object->readAttr(SPAttr::CONNECTION_POINTS);
     object->readAttr(SPAttr::INKSCAPE_HIGHLIGHT_COLOR);
 
+    if (!cloned) {
+        document->getSpatialIndex().invalidate(this);
+    }
+
     SPObject::build(document, repr);
 #ifdef OBJECT_TRACE
     objectTrace( "SPItem::build", false);
@@ -521,6 +526,10 @@ void SPItem::build(SPDocument *document, Inkscape::XML::Node *repr) {
 
 void SPItem::release()
 {
+    if (!cloned && document) {
+        document->getSpatialIndex().remove(this);
+    }
+
     // Note: do this here before the clip_ref is deleted, since calling
     // ensureUpToDate() for triggered routing may reference
     // the deleted clip_ref.
@@ -771,6 +780,9 @@ void SPItem::update(SPCtx *ctx, unsigned flags)
     // Any of the modifications defined in sp-object.h might change bbox,
     // so we invalidate it unconditionally
     bbox_valid = false;
+    if (!cloned && document) {
+        document->getSpatialIndex().invalidate(this);
+    }
 
     viewport = ictx->viewport; // Cache viewport
 
@@ -24,6 +24,7 @@
 #include <2geom/curves.h>
 
 #include "attributes.h"
+#include "build-cache.h"
 #include "sp-guide.h"
 #include "sp-lpe-item.h"
 #include "style.h"
@@ -200,7 +201,9 @@ void SPPath::set(SPAttr key, const gchar* value) {
 
        case SPAttr::D:
             if (value) {
-                setCurve(SPCurve(sp_svg_read_pathv(value)));
+                auto const cache = document->getBuildCache();
+                auto pathv = cache ? cache->takePath(getRepr(), value) : std::nullopt;
+                setCurve(SPCurve(pathv ? std::move(*pathv) : sp_svg_read_pathv(value)));
             } else {
                 setCurve(nullptr);
             }
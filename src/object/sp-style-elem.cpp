@@ -455,6 +455,7 @@ static void clear_style_sheet(SPStyleElem &self)
     }
 
     self.style_sheet = nullptr;
+    self.document->invalidateStyleSheetIndex();
 }
 
 void SPStyleElem::read_content() {
@@ -492,6 +493,7 @@ void SPStyleElem::read_content() {
             // If not the first, then chain up this style_sheet
             cr_stylesheet_append_stylesheet(topsheet, style_sheet);
         }
+        document->invalidateStyleSheetIndex();
     } else {
         cr_stylesheet_destroy (style_sheet);
         style_sheet = nullptr;
@@ -13,6 +13,9 @@
 
 #include "path-boolop.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <glibmm/i18n.h>
@@ -28,6 +31,8 @@
 #include "path-util.h"
 
 #include "display/curve.h"
+#include "display/dispatch-pool.h"
+#include "display/threading.h"
 #include "livarot/Path.h"
 #include "livarot/Shape.h"
 #include "object/object-set.h"  // This file defines some member functions of ObjectSet.
@@ -149,6 +154,92 @@ static void sort_and_clean_intersection_times(std::vector<Geom::PathVectorTime>
     }
 }
 
+/**
+ * Union the polygons of several paths.
+ *
+ * Rather than folding the operands into the result one at a time, which makes every sweep run
+ * over the ever-growing result, the polygons are merged pairwise in a balanced tree. The unions
+ * of each level are independent and run in parallel. The operands are first ordered along a
+ * Z-order curve through the centres of their bounding boxes, so that the pairs merged at each
+ * level are near each other and intermediate results stay small.
+ *
+ * @param paths The paths to union. Edges of the result refer to them by their index.
+ * @param fill_rules The fill rule of each path.
+ * @param bounds The bounding box of each path.
+ */
+static std::unique_ptr<Shape> union_paths(std::vector<Path *> const &paths, std::vector<FillRule> const &fill_rules,
+                                          std::vector<Geom::OptRect> const &bounds)
+{
+    auto const pool = Inkscape::get_global_dispatch_pool();
+    int const count = paths.size();
+
+    Geom::OptRect total;
+    for (auto const &b : bounds) {
+        total.unionWith(b);
+    }
+
+    // Interleave the bits of the quantized bounding box centres.
+    auto z_order = [&] (Geom::OptRect const &b) -> std::uint32_t {
+        if (!b || !total) {
+            return 0;
+        }
+        auto quantize = [] (double x, double min, double size) -> std::uint32_t {
+            return size > 0 ? std::clamp((x - min) / size, 0.0, 1.0) * 0xffff : 0;
+        };
+        auto const x = quantize(b->midpoint().x(), total->left(), total->width());
+        auto const y = quantize(b->midpoint().y(), total->top(), total->height());
+        std::uint32_t key = 0;
+        for (int bit = 0; bit < 16; bit++) {
+            key |= ((x >> bit) & 1) << (2 * bit) | ((y >> bit) & 1) << (2 * bit + 1);
+        }
+        return key;
+    };
+
+    std::vector<std::pair<std::uint32_t, int>> order;
+    order.reserve(count);
+    for (int i = 0; i < count; i++) {
+        order.emplace_back(z_order(bounds[i]), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<std::unique_ptr<Shape>> shapes(count);
+    pool->dispatch_threshold(count, count > 1, [&] (int i, int) {
+        int const index = order[i].second;
+        Shape tmp;
+        paths[index]->Fill(&tmp, index);
+        shapes[i] = std::make_unique<Shape>();
+        shapes[i]->ConvertToShape(&tmp, fill_rules[index]);
+    });
+
+    while (shapes.size() > 1) {
+        std::vector<std::unique_ptr<Shape>> merged((shapes.size() + 1) / 2);
+        pool->dispatch_threshold(merged.size(), merged.size() > 1, [&] (int i, int) {
+            auto &a = shapes[2 * i];
+            if (2 * i + 1 == static_cast<int>(shapes.size())) {
+                merged[i] = std::move(a);
+                return;
+            }
+            auto &b = shapes[2 * i + 1];
+
+            // Due to quantization of the input coordinates, either shape may be empty; the union
+            // is then just the other one.
+            if (a->numberOfEdges() == 0) {
+                merged[i] = std::move(b);
+            } else if (b->numberOfEdges() == 0) {
+                merged[i] = std::move(a);
+            } else {
+                merged[i] = std::make_unique<Shape>();
+                merged[i]->Booleen(b.get(), a.get(), bool_op_union);
+            }
+            a.reset();
+            b.reset();
+        });
+        shapes = std::move(merged);
+    }
+
+    return std::move(shapes.front());
+}
+
 /*
  * Flattening
  */
@@ -485,20 +576,44 @@ void Inkscape::ObjectSet::_pathBoolOp(BooleanOp bop)
     }
 
     // Compute the intersections and self-intersections, and use this information when converting to livarot paths.
-    for (int i = 0; i < operands.size(); i++) {
+    // Only operands with overlapping bounding boxes can intersect. The tests of each operand
+    // against the ones before it run in parallel, and their results are then applied in order.
+    auto const pool = Inkscape::get_global_dispatch_pool();
+    bool const parallel = operands.size() > 2;
+
+    std::vector<Geom::OptRect> bounds;
+    bounds.reserve(operands.size());
+    for (auto const &operand : operands) {
+        bounds.emplace_back(operand.pathv.boundsFast());
+    }
+
+    std::vector<std::vector<std::pair<int, std::vector<Geom::PathVectorIntersection>>>> intersections(operands.size());
+    pool->dispatch_threshold(operands.size(), parallel, [&] (int i, int) {
         for (int j = 0; j < i; j++) {
-            distribute_intersection_times(operands[i].cuts, operands[j].cuts, operands[i].pathv.intersect(operands[j].pathv));
+            if (bounds[i] && bounds[j] && bounds[i]->intersects(*bounds[j])) {
+                intersections[i].emplace_back(j, operands[i].pathv.intersect(operands[j].pathv));
+            }
+        }
+    });
+
+    for (int i = 0; i < operands.size(); i++) {
+        for (auto const &[j, found] : intersections[i]) {
+            distribute_intersection_times(operands[i].cuts, operands[j].cuts, found);
         }
     }
+    intersections.clear();
 
-    for (auto &operand : operands) {
+    pool->dispatch_threshold(operands.size(), parallel, [&] (int i, int) {
+        auto &operand = operands[i];
         distribute_intersection_times(operand.cuts, operand.cuts, operand.pathv.intersectSelf());
         sort_and_clean_intersection_times(operand.cuts);
 
         operand.path = std::make_unique<Path>();
         operand.path->LoadPathVector(operand.pathv, operand.cuts);
         operand.path->ConvertWithBackData(RELATIVE_THRESHOLD, true);
+    });
 
+    for (auto &operand : operands) {
         if (operand.path->descr_cmd.size() <= 1) {
             return;
         }
@@ -519,7 +634,18 @@ void Inkscape::ObjectSet::_pathBoolOp(BooleanOp bop)
     Path::cut_position  *toCut=nullptr;
     int                  nbToCut=0;
 
-    if (bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff) {
+    if (bop == bool_op_union && operands.size() > 2) {
+        std::vector<Path *> paths;
+        std::vector<FillRule> fill_rules;
+        for (auto &operand : operands) {
+            paths.emplace_back(operand.path.get());
+            fill_rules.emplace_back(operand.fill_rule);
+        }
+
+        delete theShape;
+        theShape = union_paths(paths, fill_rules, bounds).release();
+
+    } else if (bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff) {
         // true boolean op
         // get the polygons of each path, with the winding rule specified, and apply the operation iteratively
 
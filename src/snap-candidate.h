@@ -20,6 +20,7 @@
 #include <2geom/pathvector.h>
 #include <cstdio>
 #include <utility>
+#include <vector>
 
 #include "snap-enums.h"
 
@@ -152,6 +153,16 @@ public:
     Geom::OptRect target_bbox;
     bool currently_being_edited; // true for the path that's currently being edited in the node tool (if any)
 
+    /* Bounds of each path in path_vector and of each of its curves, filled in by the object snapper
+     * on first use. The same paths are snapped to for every point of a selection, and most of their
+     * curves can be skipped without computing the nearest point on them.
+     */
+    struct SegmentBounds
+    {
+        Geom::OptRect path;
+        std::vector<Geom::Rect> curves;
+    };
+    std::vector<SegmentBounds> segment_bounds;
 };
 } // end of namespace Inkscape
 #endif /* !SEEN_SNAP_CANDIDATE_H */
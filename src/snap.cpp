@@ -27,6 +27,8 @@
 #include <2geom/transforms.h>
 
 #include "desktop.h"
+#include "document.h"
+#include "document-spatial-index.h"
 #include "preferences.h"
 #include "pure-transform.h"
 #include "selection.h"
@@ -837,6 +839,20 @@ void SnapManager::_findCandidates(SPObject* parent,
         _findCandidates_already_called = true;
         _obj_snapper_candidates->clear();
         _align_snapper_candidates->clear();
+
+        // Only items that are in view can become candidates; rather than walking the whole tree,
+        // ask the spatial index for them and only descend into their ancestors. The index holds
+        // visual bounds without clips and masks, which contain the geometric bounds, so items are
+        // found even where their clip hides them. Clip paths and masks are only looked for on the
+        // items found.
+        _items_in_view.clear();
+        auto const area = dt->get_display_area().bounds() * dt->dt2doc();
+        for (auto item : getDocument()->getSpatialIndex().intersecting(area)) {
+            SPObject const *o = item;
+            while (o && _items_in_view.insert(o).second) {
+                o = o->parent;
+            }
+        }
     }
     recursion_level++;
 
@@ -844,6 +860,9 @@ void SnapManager::_findCandidates(SPObject* parent,
     bbox_to_snap_incl.expandBy(object.getSnapperTolerance()); // see?
 
     for (auto& o: parent->children) {
+        if (!clip_or_mask && !_items_in_view.count(&o)) {
+            continue;
+        }
         auto item = cast<SPItem>(&o);
         if (item && !(dt->itemIsHidden(item) && !clip_or_mask)) {
             // Fix LPE boolops self-snapping
@@ -19,6 +19,7 @@
 #define SEEN_SNAP_H
 
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "guide-snapper.h"
@@ -441,6 +442,9 @@ private:
                        bool const _clip_or_mask,
                        Geom::Affine const additional_affine);
     bool _findCandidates_already_called;
+    /// Items whose bounds intersect the display area, and their ancestors; looked up in the
+    /// document's spatial index so that _findCandidates() can skip the rest of the tree.
+    std::unordered_set<SPObject const *> _items_in_view;
 
     std::unique_ptr<std::vector<Inkscape::SnapCandidateItem>> _obj_snapper_candidates;
     std::unique_ptr<std::vector<Inkscape::SnapCandidateItem>> _align_snapper_candidates;
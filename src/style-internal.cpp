@@ -24,8 +24,13 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <sigc++/bind.h>
 #include <glibmm/regex.h>
 #include <glibmm/ustring.h>
@@ -40,6 +45,7 @@
 #include "document.h"
 
 #include "bad-uri-exception.h"
+#include "debug/heap.h"
 #include "extract-uri.h"
 #include "preferences.h"
 #include "streq.h"
@@ -1238,6 +1244,135 @@ const Glib::ustring SPIEastAsian::get_value() const
     return ret;
 }
 
+// SPISharedString ------------------------------------------------------
+
+struct SPISharedString::Record
+{
+    std::string value;
+    std::atomic<unsigned> refs{1};
+    bool interned = true;
+};
+
+namespace {
+
+/**
+ * The table of shared string values. It is listed as a heap in the memory dialog.
+ */
+class SharedStringTable final : public Inkscape::Debug::Heap
+{
+public:
+    static SharedStringTable &get()
+    {
+        // Never destroyed, as values may be released during static destruction.
+        static auto const table = [] {
+            auto const t = new SharedStringTable;
+            Inkscape::Debug::register_extra_heap(*t);
+            return t;
+        }();
+        return *table;
+    }
+
+    SPISharedString::Record *acquire(std::string_view str)
+    {
+        std::scoped_lock lock(_mutex);
+
+        if (auto it = _records.find(str); it != _records.end()) {
+            it->second->refs.fetch_add(1, std::memory_order_relaxed);
+            return it->second;
+        }
+
+        auto const record = new SPISharedString::Record{std::string(str)};
+        _records.emplace(record->value, record);
+        _bytes += _size(record);
+        return record;
+    }
+
+    void release(SPISharedString::Record *record)
+    {
+        // Taking the lock for every release keeps a record from being looked up while it is freed.
+        std::scoped_lock lock(_mutex);
+
+        if (record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            _records.erase(record->value);
+            _bytes -= _size(record);
+            delete record;
+        }
+    }
+
+    int features() const override { return SIZE_AVAILABLE | USED_AVAILABLE; }
+    char const *name() const override { return "shared style values"; }
+
+    Stats stats() const override
+    {
+        std::scoped_lock lock(_mutex);
+        auto const table = _records.bucket_count() * sizeof(void *) + _records.size() * (sizeof(void *) + sizeof(decltype(_records)::value_type));
+        return {_bytes + table, _bytes + table};
+    }
+
+    void force_collect() override {}
+
+private:
+    static std::size_t _size(SPISharedString::Record const *record)
+    {
+        return sizeof(*record) + (record->value.capacity() > std::string().capacity() ? record->value.capacity() + 1 : 0);
+    }
+
+    mutable std::mutex _mutex;
+    std::unordered_map<std::string_view, SPISharedString::Record *> _records;
+    std::size_t _bytes = 0;
+};
+
+} // namespace
+
+SPISharedString::SPISharedString(char const *str, bool intern)
+{
+    if (!str) {
+        return;
+    }
+    if (intern) {
+        _record = SharedStringTable::get().acquire(str);
+    } else {
+        _record = new Record{str, 1, false};
+    }
+}
+
+SPISharedString::SPISharedString(SPISharedString const &other)
+    : _record(other._record)
+{
+    // The other reference keeps the record alive, so this needs no lock.
+    if (_record) {
+        _record->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SPISharedString::~SPISharedString()
+{
+    if (!_record) {
+        return;
+    }
+    if (_record->interned) {
+        SharedStringTable::get().release(_record);
+    } else if (_record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete _record;
+    }
+}
+
+char const *SPISharedString::c_str() const
+{
+    return _record ? _record->value.c_str() : nullptr;
+}
+
+bool SPISharedString::operator==(SPISharedString const &other) const
+{
+    if (_record == other._record) {
+        return true;
+    }
+    if (!_record || !other._record || (_record->interned && other._record->interned)) {
+        return false;
+    }
+    return _record->value == other._record->value;
+}
+
 // SPIString ------------------------------------------------------------
 
 void
@@ -1268,7 +1403,9 @@ SPIString::read( gchar const *str ) {
         }
 
         set = true;
-        _value = g_strdup(str);
+        // Path data is rarely the same on two objects, and can be long; hashing it and taking the
+        // table's lock for each path would cost more than it saves.
+        _value = SPISharedString(str, id() != SPAttr::D);
     }
 }
 
@@ -1297,7 +1434,7 @@ const Glib::ustring SPIString::get_value() const
 
 char const *SPIString::value() const
 {
-    return _value ? _value : get_default_value();
+    return _value ? _value.c_str() : get_default_value();
 }
 
 char const *SPIString::get_default_value() const
@@ -1316,16 +1453,14 @@ char const *SPIString::get_default_value() const
 void
 SPIString::clear() {
     SPIBase::clear();
-    g_free(_value);
-    _value = nullptr;
+    _value = {};
 }
 
 void
 SPIString::cascade( const SPIBase* const parent ) {
     if( const SPIString* p = dynamic_cast<const SPIString*>(parent) ) {
         if( inherits && (!set || inherit) ) {
-            g_free(_value);
-            _value = g_strdup(p->_value);
+            _value = p->_value;
         }
     } else {
         std::cerr << "SPIString::cascade(): Incorrect parent type" << std::endl;
@@ -1339,8 +1474,7 @@ SPIString::merge( const SPIBase* const parent ) {
             if( (!set || inherit) && p->set && !(p->inherit) ) {
                 set     = p->set;
                 inherit = p->inherit;
-                g_free(_value);
-                _value = g_strdup(p->_value);
+                _value = p->_value;
             }
         }
     }
@@ -1349,7 +1483,7 @@ SPIString::merge( const SPIBase* const parent ) {
 bool
 SPIString::equals(const SPIBase& rhs) const {
     if( const SPIString* r = dynamic_cast<const SPIString*>(&rhs) ) {
-        return g_strcmp0(_value, r->_value) == 0 && SPIBase::equals(rhs);
+        return _value == r->_value && SPIBase::equals(rhs);
     } else {
         return false;
     }
@@ -609,6 +609,52 @@ public:
 };
 
 
+/**
+ * The value of a string property, shared with all other properties of the same value.
+ *
+ * Values are interned in a process-wide table of reference-counted strings, so that copying,
+ * cascading or merging a property only takes another reference. When thousands of objects
+ * inherit the same font family, it is stored once. A value never changes; setting a property
+ * makes it refer to another value instead.
+ *
+ * Values that are rarely shared, like path data, can be left out of the table; they are then
+ * only shared by copying.
+ *
+ * Only these string values are shared. Every other property of a computed SPStyle is still held
+ * by each object on its own.
+ */
+class SPISharedString
+{
+public:
+    SPISharedString() = default;
+    /**
+     * Look up (or add) @a str in the table, or if not @a intern, make a value of its own. A null
+     * @a str gives a null value.
+     */
+    explicit SPISharedString(char const *str, bool intern = true);
+    SPISharedString(SPISharedString const &other);
+    SPISharedString(SPISharedString &&other) noexcept : _record(std::exchange(other._record, nullptr)) {}
+    SPISharedString &operator=(SPISharedString other) noexcept
+    {
+        std::swap(_record, other._record);
+        return *this;
+    }
+    ~SPISharedString();
+
+    /// The string, or null if there is none.
+    char const *c_str() const;
+
+    explicit operator bool() const { return _record; }
+
+    /// Equal interned strings share a record, so for those this is a pointer comparison.
+    bool operator==(SPISharedString const &other) const;
+
+    struct Record;
+
+private:
+    Record *_record = nullptr;
+};
+
 /// String type internal to SPStyle.
 // Used for 'marker', ..., 'font', 'font-family', 'inkscape-font-specification'
 class SPIString : public SPIBase
@@ -621,9 +667,7 @@ public:
 
     SPIString(const SPIString &rhs) { *this = rhs; }
 
-    ~SPIString() override {
-        g_free(_value);
-    }
+    ~SPIString() override = default;
 
     void read( gchar const *str ) override;
     const Glib::ustring get_value() const override;
@@ -636,8 +680,7 @@ public:
             return *this;
         }
         SPIBase::operator=(rhs);
-        g_free(_value);
-        _value = g_strdup(rhs._value);
+        _value = rhs._value;
         return *this;
     }
 
@@ -649,7 +692,7 @@ public:
   private:
     char const *get_default_value() const;
 
-    gchar *_value = nullptr;
+    SPISharedString _value;
 };
 
 /// Shapes type internal to SPStyle.
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::StyleSheetIndex - style sheet rules indexed by the ids, classes and elements they match
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "style-sheet-index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xml/node.h"
+
+namespace Inkscape {
+
+namespace {
+
+// The characters separating class names, as in cr_utils_is_white_space().
+bool is_white_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+char const *local_name(char const *qname)
+{
+    char const *ret = std::strrchr(qname, ':');
+    return ret ? ret + 1 : qname;
+}
+
+char const *str(CRString const *s)
+{
+    return s && s->stryng ? s->stryng->str : nullptr;
+}
+
+} // namespace
+
+StyleSheetIndex::StyleSheetIndex(CRCascade *cascade)
+{
+    if (cr_cascade_get_sheet(cascade, ORIGIN_UA) || cr_cascade_get_sheet(cascade, ORIGIN_USER)) {
+        _usable = false;
+        return;
+    }
+
+    for (auto sheet = cr_cascade_get_sheet(cascade, ORIGIN_AUTHOR); sheet; sheet = sheet->next) {
+        for (auto stmt = sheet->statements; stmt; stmt = stmt->next) {
+            switch (stmt->type) {
+                case RULESET_STMT:
+                    if (stmt->kind.ruleset) {
+                        for (auto sel = stmt->kind.ruleset->sel_list; sel; sel = sel->next) {
+                            if (sel->simple_sel) {
+                                _add(stmt, sel->simple_sel);
+                            }
+                        }
+                    }
+                    break;
+                case AT_IMPORT_RULE_STMT:
+                case AT_MEDIA_RULE_STMT:
+                    // Rules of other style sheets, or applying under conditions; leave them to libcroco.
+                    _usable = false;
+                    return;
+                default:
+                    // Font faces, pages and character sets do not apply to elements.
+                    break;
+            }
+        }
+    }
+}
+
+void StyleSheetIndex::_add(CRStatement *ruleset, CRSimpleSel *selector)
+{
+    cr_simple_sel_compute_specificity(selector);
+    auto const entry = Entry{_count++, ruleset, selector, selector->specificity};
+
+    // Only the last compound selector is about the element itself.
+    auto last = selector;
+    while (last->next) {
+        last = last->next;
+    }
+
+    // libcroco ignores the classes, ids, etc. of a compound selector starting with '*'.
+    if (!(last->type_mask & UNIVERSAL_SELECTOR)) {
+        // Every id and class of the compound must match, so any one of them will do as a key.
+        // Ids are the most selective.
+        for (auto add = last->add_sel; add; add = add->next) {
+            if (add->type == ID_ADD_SELECTOR && str(add->content.id_name)) {
+                _ids[str(add->content.id_name)].push_back(entry);
+                return;
+            }
+        }
+        for (auto add = last->add_sel; add; add = add->next) {
+            if (add->type == CLASS_ADD_SELECTOR && str(add->content.class_name)) {
+                _classes[str(add->content.class_name)].push_back(entry);
+                return;
+            }
+        }
+        if ((last->type_mask & TYPE_SELECTOR) && str(last->name)) {
+            _elements[str(last->name)].push_back(entry);
+            return;
+        }
+    }
+
+    _others.push_back(entry);
+}
+
+void StyleSheetIndex::_collect(Buckets const &buckets, std::string_view key, std::vector<Entry const *> &candidates)
+{
+    if (auto it = buckets.find(key); it != buckets.end()) {
+        for (auto const &entry : it->second) {
+            candidates.push_back(&entry);
+        }
+    }
+}
+
+std::vector<CRDeclaration *> StyleSheetIndex::match(CRSelEng *sel_eng, XML::Node const *node) const
+{
+    std::vector<Entry const *> candidates;
+
+    if (auto id = node->attribute("id")) {
+        _collect(_ids, id, candidates);
+    }
+
+    if (auto klass = node->attribute("class")) {
+        std::vector<std::string_view> seen;
+        for (auto p = klass; *p;) {
+            if (is_white_space(*p)) {
+                p++;
+                continue;
+            }
+            auto const start = p;
+            while (*p && !is_white_space(*p)) {
+                p++;
+            }
+            auto const name = std::string_view(start, p - start);
+            if (std::find(seen.begin(), seen.end(), name) == seen.end()) {
+                seen.push_back(name);
+                _collect(_classes, name, candidates);
+            }
+        }
+    }
+
+    _collect(_elements, local_name(node->name()), candidates);
+
+    for (auto const &entry : _others) {
+        candidates.push_back(&entry);
+    }
+
+    // Restore the order of the style sheets, which decides between rules of equal specificity.
+    std::sort(candidates.begin(), candidates.end(), [] (Entry const *a, Entry const *b) { return a->order < b->order; });
+
+    // Like libcroco, list a ruleset once for each of its selectors that matches, and give it the
+    // specificity of the last one.
+    std::vector<CRStatement *> rulesets;
+    std::unordered_map<CRStatement const *, unsigned long> specificity;
+    for (auto const entry : candidates) {
+        gboolean matches = FALSE;
+        if (cr_sel_eng_matches_node(sel_eng, entry->selector, node, &matches) == CR_OK && matches) {
+            rulesets.push_back(entry->ruleset);
+            specificity[entry->ruleset] = entry->specificity;
+        }
+    }
+
+    // The cascade of put_css_properties_in_props_list() in libcroco, for a single origin: a
+    // declaration replaces an earlier one of the same property if its ruleset is at least as
+    // specific, unless the earlier one is important. The replacement goes to the end of the list.
+    std::vector<CRDeclaration *> props;
+    for (auto const ruleset : rulesets) {
+        if (!ruleset->parent_sheet) {
+            continue;
+        }
+        auto const spec = specificity[ruleset];
+
+        for (auto decl = ruleset->kind.ruleset->decl_list; decl; decl = decl->next) {
+            auto const property = str(decl->property);
+            if (!property) {
+                continue;
+            }
+
+            auto it = std::find_if(props.begin(), props.end(), [&] (CRDeclaration const *d) {
+                return std::strcmp(str(d->property), property) == 0;
+            });
+            if (it == props.end()) {
+                props.push_back(decl);
+                continue;
+            }
+
+            auto const prev = *it;
+            auto const prev_spec = prev->parent_statement ? specificity[prev->parent_statement] : 0;
+            if (spec >= prev_spec && !prev->important) {
+                props.erase(it);
+                props.push_back(decl);
+            }
+        }
+    }
+
+    return props;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::StyleSheetIndex - style sheet rules indexed by the ids, classes and elements they match
+ *//*
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_STYLE_SHEET_INDEX_H
+#define SEEN_INKSCAPE_STYLE_SHEET_INDEX_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "3rdparty/libcroco/src/cr-cascade.h"
+#include "3rdparty/libcroco/src/cr-sel-eng.h"
+
+namespace Inkscape {
+
+namespace XML {
+class Node;
+} // namespace XML
+
+/**
+ * The selectors of a document's style sheets, indexed by what their last compound selector
+ * requires of an element: an id, a class or an element name. Selectors that require none of
+ * these, such as '*' or ':first-child', are tested against every element.
+ *
+ * libcroco tests every rule of every style sheet against every element it styles, which makes
+ * styling quadratic for documents with thousands of class rules, as written by PDF converters.
+ * With the index, each element is only tested against the rules that could possibly match it.
+ *
+ * The declarations are then cascaded exactly as libcroco does it, so results do not change.
+ * Style sheets using features the index does not handle (@import and @media rules, or user
+ * agent and user style sheets) are not indexed, and must be matched by libcroco.
+ */
+class StyleSheetIndex
+{
+public:
+    explicit StyleSheetIndex(CRCascade *cascade);
+
+    StyleSheetIndex(StyleSheetIndex const &) = delete;
+    StyleSheetIndex &operator=(StyleSheetIndex const &) = delete;
+
+    /// Whether the style sheets could be indexed. If not, match() must not be used.
+    bool usable() const { return _usable; }
+
+    /**
+     * Find the declarations that apply to an element.
+     *
+     * @return One declaration per property, in the order of the property list that
+     * cr_sel_eng_get_matched_properties_from_cascade() would return.
+     */
+    std::vector<CRDeclaration *> match(CRSelEng *sel_eng, XML::Node const *node) const;
+
+private:
+    struct Entry
+    {
+        unsigned order;        ///< Position of the selector in the style sheets.
+        CRStatement *ruleset;
+        CRSimpleSel *selector;
+        unsigned long specificity;
+    };
+
+    /// Hashes keys given as any kind of string, so that lookups need not copy them.
+    struct KeyHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view key) const { return std::hash<std::string_view>{}(key); }
+    };
+    using Buckets = std::unordered_map<std::string, std::vector<Entry>, KeyHash, std::equal_to<>>;
+
+    void _add(CRStatement *ruleset, CRSimpleSel *selector);
+    static void _collect(Buckets const &buckets, std::string_view key, std::vector<Entry const *> &candidates);
+
+    bool _usable = true;
+    unsigned _count = 0;
+    Buckets _ids;
+    Buckets _classes;
+    Buckets _elements;
+    std::vector<Entry> _others;
+};
+
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_STYLE_SHEET_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -34,8 +34,10 @@
 #include "colors/manager.h"
 #include "document.h"
 #include "preferences.h"
+#include "style-sheet-index.h"
 
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
+#include "object/build-cache.h"
 #include "object/sp-paint-server.h"
 #include "object/uri.h"
 
@@ -567,7 +569,13 @@ SPStyle::read( SPObject *object, Inkscape::XML::Node *repr ) {
     // std::cout << " MERGING STYLE ATTRIBUTE" << std::endl;
     gchar const *val = repr->attribute("style");
     if( val != nullptr && *val ) {
-        _mergeString( val );
+        auto const cache = object && document ? document->getBuildCache() : nullptr;
+        if (auto const decl_list = cache ? cache->takeStyle(repr, val) : nullptr) {
+            _mergeDeclList( decl_list, SPStyleSrc::STYLE_PROP );
+            cr_declaration_destroy(decl_list);
+        } else {
+            _mergeString( val );
+        }
     }
 
     /* 2 Style sheet */
@@ -998,13 +1006,24 @@ SPStyle::_mergeObjectStylesheet( SPObject const *const object, SPDocument *const
         _mergeObjectStylesheet(object, parent);
     }
 
+    //XML Tree being directly used here while it shouldn't be.
+    auto const repr = object->getRepr();
+
+    if (auto const index = document->getStyleSheetIndex(); index && repr->type() == Inkscape::XML::NodeType::ELEMENT_NODE) {
+        auto const decls = index->match(sel_eng, repr);
+        // In reverse order, as in _mergeProps().
+        for (auto it = decls.rbegin(); it != decls.rend(); ++it) {
+            _mergeDecl(*it, SPStyleSrc::STYLE_SHEET);
+        }
+        return;
+    }
+
     CRPropList *props = nullptr;
 
-    //XML Tree being directly used here while it shouldn't be.
     CRStatus status =
         cr_sel_eng_get_matched_properties_from_cascade(sel_eng,
                                                        document->getStyleCascade(),
-                                                       object->getRepr(),
+                                                       repr,
                                                        &props);
     g_return_if_fail(status == CR_OK);
     /// \todo Check what errors can occur, and handle them properly.
@@ -14,13 +14,18 @@
  * is provided by the generosity of Peter Selinger, to whom we are grateful.
  *
  */
+#include <atomic>
 #include <iomanip>
+#include <mutex>
+#include <vector>
 #include <potracelib.h>
 
 #include "inkscape-potrace.h"
 #include "bitmap.h"
 
 #include "async/progress.h"
+#include "display/task-scheduler.h"
+#include "display/threading.h"
 #include "trace/filterset.h"
 #include "trace/quantize.h"
 #include "trace/imagemap-gdk.h"
@@ -28,6 +33,8 @@
 
 namespace {
 
+using Inkscape::Trace::GrayMap;
+
 struct potrace_state_deleter { void operator()(potrace_state_t *p) { potrace_state_free(p); }; };
 using potrace_state_uniqptr = std::unique_ptr<potrace_state_t, potrace_state_deleter>;
 
@@ -39,6 +46,133 @@ Glib::ustring twohex(int value)
     return Inkscape::ustring::format_classic(std::hex, std::setfill('0'), std::setw(2), value);
 }
 
+/**
+ * Black where the brightness of \a gm is at least \a floor and below \a threshold, white elsewhere.
+ */
+GrayMap brightnessBand(GrayMap const &gm, double floor, double threshold)
+{
+    auto map = GrayMap(gm.width, gm.height);
+
+    double const low = 3.0 * floor * 256.0;
+    double const cutoff = 3.0 * threshold * 256.0;
+    for (int y = 0; y < gm.height; y++) {
+        for (int x = 0; x < gm.width; x++) {
+            double brightness = gm.getPixel(x, y);
+            bool black = brightness >= low && brightness < cutoff;
+            map.setPixel(x, y, black ? GrayMap::BLACK : GrayMap::WHITE);
+        }
+    }
+
+    return map;
+}
+
+void invertGrayMap(GrayMap &map)
+{
+    for (int y = 0; y < map.height; y++) {
+        for (int x = 0; x < map.width; x++) {
+            auto brightness = map.getPixel(x, y);
+            brightness = GrayMap::WHITE - brightness;
+            map.setPixel(x, y, brightness);
+        }
+    }
+}
+
+/**
+ * Progress of layers traced in parallel, forwarded to a Progress that may only be used by one
+ * thread at a time as the average over all layers.
+ *
+ * As soon as any layer is cancelled, all of them are.
+ */
+class LayerProgress
+{
+public:
+    class Layer final
+        : public Inkscape::Async::Progress<double>
+    {
+    public:
+        Layer(LayerProgress &shared, int index)
+            : shared(&shared), index(index) {}
+
+    private:
+        LayerProgress *shared;
+        int index;
+
+        bool _keepgoing() const override { return shared->keepgoing(); }
+        bool _report(double const &progress) override { return shared->report(index, progress); }
+    };
+
+    LayerProgress(Inkscape::Async::Progress<double> &parent, int count)
+        : parent(&parent)
+        , done(count, 0.0) {}
+
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+private:
+    Inkscape::Async::Progress<double> *parent;
+    std::mutex mutex;
+    std::vector<double> done;
+    double total = 0.0;
+    std::atomic<bool> cancelled{};
+
+    bool keepgoing()
+    {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        // Cancellation is polled very often; don't queue up behind other layers for it.
+        auto lock = std::unique_lock(mutex, std::try_to_lock);
+        if (lock && !parent->keepgoing()) {
+            cancel();
+        }
+        return !cancelled.load(std::memory_order_relaxed);
+    }
+
+    bool report(int index, double progress)
+    {
+        auto lock = std::scoped_lock(mutex);
+        total += progress - done[index];
+        done[index] = progress;
+        if (!parent->report(total / done.size())) {
+            cancel();
+        }
+        return !cancelled.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Call \a trace_layer(i, progress) for each of \a count layers concurrently on the shared task
+ * scheduler, and return the paths in layer order.
+ *
+ * Layers are background tasks, which leave a worker free for redrawing the canvas. The calling
+ * thread traces the layers no worker has taken up yet itself.
+ */
+template <typename F>
+std::vector<Geom::PathVector> traceLayers(int count, Inkscape::Async::Progress<double> &progress, F const &trace_layer)
+{
+    std::vector<Geom::PathVector> paths(count);
+    auto shared = LayerProgress(progress, count);
+
+    // Declared last, so that it waits for the tasks before the above are destroyed.
+    auto group = Inkscape::task_group(Inkscape::get_global_task_scheduler(),
+                                      Inkscape::task_scheduler::priority::background);
+    for (int i = 0; i < count; i++) {
+        group.run([&, i] {
+            try {
+                auto layer = LayerProgress::Layer(shared, i);
+                paths[i] = trace_layer(i, layer);
+                layer.report_or_throw(1.0);
+            } catch (...) {
+                // Don't carry on with the other layers if one of them failed.
+                shared.cancel();
+                throw;
+            }
+        });
+    }
+    group.wait();
+
+    return paths;
+}
+
 } // namespace
 
 namespace Inkscape {
@@ -154,18 +288,7 @@ std::optional<GrayMap> PotraceTracingEngine::filter(Glib::RefPtr<Gdk::Pixbuf> co
     } else if (traceType == TraceType::BRIGHTNESS || traceType == TraceType::BRIGHTNESS_MULTI) {
 
         // Brightness threshold
-        auto gm = gdkPixbufToGrayMap(pixbuf);
-        map = GrayMap(gm.width, gm.height);
-
-        double floor = 3.0 * brightnessFloor * 256.0;
-        double cutoff = 3.0 * brightnessThreshold * 256.0;
-        for (int y = 0; y < gm.height; y++) {
-            for (int x = 0; x < gm.width; x++) {
-                double brightness = gm.getPixel(x, y);
-                bool black = brightness >= floor && brightness < cutoff;
-                map->setPixel(x, y, black ? GrayMap::BLACK : GrayMap::WHITE);
-            }
-        }
+        map = brightnessBand(gdkPixbufToGrayMap(pixbuf), brightnessFloor, brightnessThreshold);
 
         // map->writePPM(map, "brightness.ppm");
 
@@ -180,13 +303,7 @@ std::optional<GrayMap> PotraceTracingEngine::filter(Glib::RefPtr<Gdk::Pixbuf> co
 
     // Invert the image if necessary.
     if (map && invert) {
-        for (int y = 0; y < map->height; y++) {
-            for (int x = 0; x < map->width; x++) {
-                auto brightness = map->getPixel(x, y);
-                brightness = GrayMap::WHITE - brightness;
-                map->setPixel(x, y, brightness);
-            }
-        }
+        invertGrayMap(*map);
     }
 
     return map;
@@ -241,7 +358,7 @@ Glib::RefPtr<Gdk::Pixbuf> PotraceTracingEngine::preview(Glib::RefPtr<Gdk::Pixbuf
 /**
  * This is the actual wrapper of the call to Potrace.
  */
-Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Async::Progress<double> &progress)
+Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Async::Progress<double> &progress) const
 {
     auto potraceBitmap = potrace_bitmap_uniqptr(bm_new(grayMap.width, grayMap.height));
     if (!potraceBitmap) {
@@ -270,9 +387,11 @@ Geom::PathVector PotraceTracingEngine::grayMapToPath(GrayMap const &grayMap, Asy
 
     auto throttled = Async::ProgressStepThrottler(progress, 0.02);
 
-    potraceParams->progress.data = &throttled;
-    potraceParams->progress.callback = [] (double progress, void *data) { reinterpret_cast<decltype(throttled)*>(data)->report(progress); };
-    auto potraceState = potrace_state_uniqptr(potrace_trace(potraceParams, potraceBitmap.get()));
+    // Use a copy of the parameters, as layers may be traced concurrently.
+    auto params = *potraceParams;
+    params.progress.data = &throttled;
+    params.progress.callback = [] (double progress, void *data) { reinterpret_cast<decltype(throttled)*>(data)->report(progress); };
+    auto potraceState = potrace_state_uniqptr(potrace_trace(&params, potraceBitmap.get()));
 
     potraceBitmap.reset();
 
@@ -328,40 +447,60 @@ TraceResult PotraceTracingEngine::traceBrightnessMulti(Glib::RefPtr<Gdk::Pixbuf>
     double constexpr high  = 0.9; // top of range
     double const     delta = (high - low) / multiScanNrColors;
 
-    brightnessFloor = 0.0; // Set bottom to black
-
-    TraceResult results;
-
-    for (int i = 0; i < multiScanNrColors; i++) {
-        auto subprogress = Async::SubProgress(progress, (double)i / multiScanNrColors, 1.0 / multiScanNrColors);
+    auto const gm = gdkPixbufToGrayMap(pixbuf);
 
-        brightnessThreshold = low + delta * i;
+    auto threshold = [&] (int i) { return low + delta * i; };
 
-        auto grayMap = filter(pixbuf);
-        if (!grayMap) {
-            continue;
+    auto traceLevel = [&] (double floor, double threshold, Async::Progress<double> &subprogress) {
+        auto grayMap = brightnessBand(gm, floor, threshold);
+        if (invert) {
+            invertGrayMap(grayMap);
         }
 
         subprogress.report_or_throw(0.2);
 
         auto sub_gmtopath = Async::SubProgress(subprogress, 0.2, 0.8);
-        auto pv = grayMapToPath(*grayMap, sub_gmtopath);
-        if (pv.empty()) {
+        return grayMapToPath(grayMap, sub_gmtopath);
+    };
+
+    // When tiling, the floor of each level is the threshold of the last level that was not empty.
+    // Levels are rarely empty, so assume that it is the threshold of the previous level, and trace
+    // a level again below if this turns out to be wrong.
+    auto floors = std::vector<double>(multiScanNrColors, 0.0);
+    if (!multiScanStack) {
+        for (int i = 1; i < multiScanNrColors; i++) {
+            floors[i] = threshold(i - 1);
+        }
+    }
+
+    auto paths = traceLayers(multiScanNrColors, progress, [&] (int i, Async::Progress<double> &subprogress) {
+        return traceLevel(floors[i], threshold(i), subprogress);
+    });
+
+    TraceResult results;
+
+    double floor = 0.0; // Set bottom to black
+    for (int i = 0; i < multiScanNrColors; i++) {
+        if (floor != floors[i]) {
+            auto retrace = Async::ProgressAlways<double>();
+            progress.throw_if_cancelled();
+            paths[i] = traceLevel(floor, threshold(i), retrace);
+        }
+
+        if (paths[i].empty()) {
             continue;
         }
 
         // get style info
-        int grayVal = 256.0 * brightnessThreshold;
+        int grayVal = 256.0 * threshold(i);
         auto style = Glib::ustring::compose("fill-opacity:1.0;fill:#%1%2%3", twohex(grayVal), twohex(grayVal), twohex(grayVal));
 
         // g_message("### GOT '%s' \n", style.c_str());
-        results.emplace_back(style.raw(), std::move(pv));
+        results.emplace_back(style.raw(), std::move(paths[i]));
 
         if (!multiScanStack) {
-            brightnessFloor = brightnessThreshold;
+            floor = threshold(i);
         }
-
-        subprogress.report_or_throw(1.0);
     }
 
     // Remove the bottom-most scan, if requested.
@@ -377,30 +516,16 @@ TraceResult PotraceTracingEngine::traceBrightnessMulti(Glib::RefPtr<Gdk::Pixbuf>
  */
 TraceResult PotraceTracingEngine::traceQuant(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf, Async::Progress<double> &progress)
 {
-    auto imap = filterIndexed(pixbuf);
+    auto const imap = filterIndexed(pixbuf);
 
-    // Create and clear a gray map
-    auto gm = GrayMap(imap.width, imap.height);
-    for (int row = 0; row < gm.height; row++) {
-        for (int col = 0; col < gm.width; col++) {
-            gm.setPixel(col, row, GrayMap::WHITE);
-        }
-    }
-
-    TraceResult results;
-
-    for (int colorIndex = 0; colorIndex < imap.nrColors; colorIndex++) {
-        auto subprogress = Async::SubProgress(progress, (double)colorIndex / imap.nrColors, 1.0 / imap.nrColors);
-
-        // Update the graymap for the current color index
+    auto paths = traceLayers(imap.nrColors, progress, [&] (int colorIndex, Async::Progress<double> &subprogress) {
+        // Make the graymap for the current color index; when stacking, it also covers all previous ones.
+        auto gm = GrayMap(imap.width, imap.height);
         for (int row = 0; row < imap.height; row++) {
             for (int col = 0; col < imap.width; col++) {
                 int index = imap.getPixel(col, row);
-                if (index == colorIndex) {
-                    gm.setPixel(col, row, GrayMap::BLACK);
-                } else if (!multiScanStack) {
-                    gm.setPixel(col, row, GrayMap::WHITE);
-                }
+                bool black = index == colorIndex || (multiScanStack && index < colorIndex);
+                gm.setPixel(col, row, black ? GrayMap::BLACK : GrayMap::WHITE);
             }
         }
 
@@ -408,16 +533,18 @@ TraceResult PotraceTracingEngine::traceQuant(Glib::RefPtr<Gdk::Pixbuf> const &pi
 
         // Now we have a traceable graymap
         auto sub_gmtopath = Async::SubProgress(subprogress, 0.2, 0.8);
-        auto pv = grayMapToPath(gm, sub_gmtopath);
+        return grayMapToPath(gm, sub_gmtopath);
+    });
 
-        if (!pv.empty()) {
+    TraceResult results;
+
+    for (int colorIndex = 0; colorIndex < imap.nrColors; colorIndex++) {
+        if (!paths[colorIndex].empty()) {
             // get style info
             auto rgb = imap.clut[colorIndex];
             auto style = Glib::ustring::compose("fill:#%1%2%3", twohex(rgb.r), twohex(rgb.g), twohex(rgb.b));
-            results.emplace_back(style.raw(), std::move(pv));
+            results.emplace_back(style.raw(), std::move(paths[colorIndex]));
         }
-
-        subprogress.report_or_throw(1.0);
     }
 
     // Remove the bottom-most scan, if requested.
@@ -105,7 +105,7 @@ private:
     IndexedMap filterIndexed(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf) const;
     std::optional<GrayMap> filter(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf) const;
 
-    Geom::PathVector grayMapToPath(GrayMap const &gm, Async::Progress<double> &progress);
+    Geom::PathVector grayMapToPath(GrayMap const &gm, Async::Progress<double> &progress) const;
 
     void writePaths(potrace_path_t *paths, Geom::PathBuilder &builder, std::unordered_set<Geom::Point> &points, Async::Progress<double> &progress) const;
 };
@@ -9,15 +9,22 @@
  *
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
+#include <algorithm>
 #include <memory>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
 #include <glib.h>
 
 #include "pool.h"
 #include "imagemap.h"
 #include "quantize.h"
 
+#include "display/dispatch-pool.h"
+#include "display/threading.h"
+
 namespace Inkscape {
 namespace Trace {
 
@@ -446,20 +453,57 @@ void octreeBuildArea(Pool<Ocnode> &pool, RgbMap const &rgbmap, Ocnode **ref, int
     // affects result quality for almost same performance :/
 }
 
+/**
+ * same as octreeBuildArea, but build the trees of the two halves of large areas
+ * in parallel, each from its own share of the <npools> pools.
+ */
+void octreeBuildAreaParallel(dispatch_pool &dispatch, Pool<Ocnode> *pools, int npools, RgbMap const &rgbmap, Ocnode **ref, int x1, int y1, int x2, int y2, int ncolor)
+{
+    // Areas of fewer pixels are not worth splitting among threads.
+    int constexpr min_area = 1 << 16;
+
+    int dx = x2 - x1, dy = y2 - y1;
+    if (npools < 2 || dx * dy < min_area) {
+        octreeBuildArea(pools[0], rgbmap, ref, x1, y1, x2, y2, ncolor);
+        return;
+    }
+
+    // Split like octreeBuildArea, which yields the same tree.
+    int xm = x1 + dx / 2, ym = y1 + dy / 2;
+    int half = npools / 2;
+    Ocnode *refs[2] = {};
+    dispatch.dispatch(2, [&] (int i, int) {
+        auto sub_pools = i == 0 ? pools : pools + half;
+        int sub_npools = i == 0 ? half : npools - half;
+        if (dx > dy) {
+            octreeBuildAreaParallel(dispatch, sub_pools, sub_npools, rgbmap, &refs[i],
+                                    i == 0 ? x1 : xm, y1, i == 0 ? xm : x2, y2, ncolor);
+        } else {
+            octreeBuildAreaParallel(dispatch, sub_pools, sub_npools, rgbmap, &refs[i],
+                                    x1, i == 0 ? y1 : ym, x2, i == 0 ? ym : y2, ncolor);
+        }
+    });
+
+    // Nodes of the second half are freed to and reused from the first pool from now on; this is
+    // fine, as all pools live as long as the tree.
+    octreeMerge(pools[0], nullptr, ref, refs[0], refs[1]);
+}
+
 /**
  * build an octree associated to the <rgbmap> color map,
- * pruned to <ncolor> colors.
+ * pruned to <ncolor> colors. the nodes are allocated from
+ * the <npools> pools, and are to be freed to the first.
  */
-Ocnode *octreeBuild(Pool<Ocnode> &pool, RgbMap const &rgbmap, int ncolor)
+Ocnode *octreeBuild(dispatch_pool &dispatch, Pool<Ocnode> *pools, int npools, RgbMap const &rgbmap, int ncolor)
 {
     // create the octree
     Ocnode *node = nullptr;
-    octreeBuildArea(pool,
-                    rgbmap, &node,
-                    0, 0, rgbmap.width, rgbmap.height, ncolor);
+    octreeBuildAreaParallel(dispatch, pools, npools,
+                            rgbmap, &node,
+                            0, 0, rgbmap.width, rgbmap.height, ncolor);
 
     // prune the octree
-    octreePrune(pool, &node, ncolor);
+    octreePrune(pools[0], &node, ncolor);
 
     return node;
 }
@@ -495,17 +539,78 @@ int distRGB(RGB rgb1, RGB rgb2)
 }
 
 /**
- * find the index of closest color in a palette
+ * Finds the index of the closest color in a palette, with the same result as a linear search.
+ *
+ * The color cube is divided into cells, and each cell lists the palette colors that can be the
+ * closest to some color in it: those not farther from all of the cell than another palette color
+ * is from any of it. Only these are searched, in palette order, so that ties go the same way.
  */
-int findRGB(RGB const *rgbs, int ncolor, RGB rgb)
+class PaletteLookup
 {
-    int index = -1, dist = 0;
-    for (int k = 0; k < ncolor; k++) {
-        int d = distRGB(rgbs[k], rgb);
-        if (index == -1 || d < dist) { dist = d; index = k; }
+public:
+    PaletteLookup(RGB const *rgbs, int ncolor)
+        : rgbs(rgbs)
+    {
+        offsets.reserve(CELLS * CELLS * CELLS + 1);
+        std::vector<int> mindist(ncolor);
+
+        for (int r = 0; r < CELLS; r++) {
+            for (int g = 0; g < CELLS; g++) {
+                for (int b = 0; b < CELLS; b++) {
+                    int bound = -1;
+                    for (int k = 0; k < ncolor; k++) {
+                        auto const [near_r, far_r] = distCell(rgbs[k].r, r);
+                        auto const [near_g, far_g] = distCell(rgbs[k].g, g);
+                        auto const [near_b, far_b] = distCell(rgbs[k].b, b);
+                        mindist[k] = near_r * near_r + near_g * near_g + near_b * near_b;
+                        int maxdist = far_r * far_r + far_g * far_g + far_b * far_b;
+                        if (bound == -1 || maxdist < bound) {
+                            bound = maxdist;
+                        }
+                    }
+
+                    offsets.push_back(candidates.size());
+                    for (int k = 0; k < ncolor; k++) {
+                        if (mindist[k] <= bound) {
+                            candidates.push_back(k);
+                        }
+                    }
+                }
+            }
+        }
+        offsets.push_back(candidates.size());
     }
-    return index;
-}
+
+    int find(RGB rgb) const
+    {
+        int cell = ((rgb.r >> CELL_BITS) * CELLS + (rgb.g >> CELL_BITS)) * CELLS + (rgb.b >> CELL_BITS);
+        int index = -1, dist = 0;
+        for (auto i = offsets[cell]; i < offsets[cell + 1]; i++) {
+            int k = candidates[i];
+            int d = distRGB(rgbs[k], rgb);
+            if (index == -1 || d < dist) { dist = d; index = k; }
+        }
+        return index;
+    }
+
+private:
+    static int constexpr CELL_BITS = 4;
+    static int constexpr CELLS = 256 >> CELL_BITS; ///< Number of cells along each axis.
+
+    RGB const *rgbs;
+    std::vector<unsigned> offsets;  ///< Start of the candidates of each cell.
+    std::vector<int> candidates;
+
+    /// Distance of a color component to the nearest and farthest values in a cell.
+    static std::pair<int, int> distCell(int value, int cell)
+    {
+        int lo = cell << CELL_BITS;
+        int hi = lo + (1 << CELL_BITS) - 1;
+        int near = value < lo ? lo - value : value > hi ? value - hi : 0;
+        int far = std::max(std::abs(value - lo), std::abs(value - hi));
+        return {near, far};
+    }
+};
 
 } // namespace
 
@@ -518,14 +623,17 @@ IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor)
 
     auto imap = IndexedMap(rgbmap.width, rgbmap.height);
 
-    Pool<Ocnode> pool;
-    auto tree = octreeBuild(pool, rgbmap, ncolor);
+    auto dispatch = get_global_dispatch_pool();
+
+    // Nodes are drawn from a pool per thread building the tree, but freed to the first one only.
+    std::vector<Pool<Ocnode>> pools(dispatch->size());
+    auto tree = octreeBuild(*dispatch, pools.data(), pools.size(), rgbmap, ncolor);
 
     auto rgbs = std::make_unique<RGB[]>(ncolor);
     int index = 0;
     octreeIndex(tree, rgbs.get(), index);
 
-    octreeDelete(pool, tree);
+    octreeDelete(pools[0], tree);
 
     // stacking with increasing contrasts
     std::sort(rgbs.get(), rgbs.get() + ncolor, [] (auto &ra, auto &rb) {
@@ -540,13 +648,23 @@ IndexedMap rgbMapQuantize(RgbMap const &rgbmap, int ncolor)
     imap.nrColors = index;
 
     // fill in new map pixels
-    for (int y = 0; y < rgbmap.height; y++) {
+    auto const lookup = PaletteLookup(rgbs.get(), ncolor);
+    int constexpr min_pixels = 1 << 16;
+    dispatch->dispatch_threshold(rgbmap.height, rgbmap.width * rgbmap.height > min_pixels, [&] (int y, int) {
+        auto src = rgbmap.row(y);
+        auto dst = imap.row(y);
+        // Neighbouring pixels often have the same color.
+        RGB last{};
+        int last_index = -1;
         for (int x = 0; x < rgbmap.width; x++) {
-            auto rgb = rgbmap.getPixel(x, y);
-            int index = findRGB(rgbs.get(), ncolor, rgb);
-            imap.setPixel(x, y, index);
+            auto rgb = src[x];
+            if (last_index == -1 || !(rgb == last)) {
+                last = rgb;
+                last_index = lookup.find(rgb);
+            }
+            dst[x] = last_index;
         }
-    }
+    });
 
     return imap;
 }
@@ -2555,6 +2555,9 @@ void InkscapePreferences::initPageBehavior()
     _undo_size.init("/options/undo/size", 1.0, 32000.0, 1.0, 1.0, 200.0, true, false);
     _page_behavior.add_line(false, _("Maximum _Undo Size:"), _undo_size, "",
                          _("How large the undo log will be allowed to get before being trimmed to free memory."), false );
+    _undo_memory.init("/options/undo/memory", 1.0, 65536.0, 1.0, 16.0, 256.0, true, false);
+    _page_behavior.add_line(false, _("Maximum Undo _Memory:"), _undo_memory, C_("mebibyte (2^20 bytes) abbreviation","MiB"),
+                         _("How much memory the undo log will be allowed to use before the oldest changes are removed, whether or not its size is limited."), false );
     _undo_limit.changed_signal.connect(sigc::mem_fun(_undo_size, &Gtk::Widget::set_sensitive));
     _undo_size.set_sensitive(_undo_limit.get_active());
 
@@ -14,12 +14,14 @@
 
 #include "undo-history.h"
 
+#include <glibmm/i18n.h>
 #include <gtkmm/cellrendererpixbuf.h>
 
 #include "document-undo.h"
 #include "document.h"
 #include "inkscape.h"
 #include "ui/pack.h"
+#include "util/format_size.h"
 #include "util/signal-blocker.h"
 
 namespace Inkscape::UI::Dialog {
@@ -37,6 +39,11 @@ UndoHistory::UndoHistory()
     UI::pack_start(*this, _scrolled_window);
     _scrolled_window.set_policy(Gtk::PolicyType::NEVER, Gtk::PolicyType::AUTOMATIC);
 
+    _stats_label.set_xalign(0.0);
+    _stats_label.set_margin(4);
+    _stats_label.add_css_class("dim-label");
+    UI::pack_end(*this, _stats_label, UI::PackOptions::shrink);
+
     _event_list_view.set_enable_search(false);
     _event_list_view.set_headers_visible(false);
 
@@ -76,6 +83,9 @@ UndoHistory::UndoHistory()
     _callback_connections[EventLog::CALLB_SELECTION_CHANGE] =
         _event_list_selection->signal_changed().connect(sigc::mem_fun(*this, &Inkscape::UI::Dialog::UndoHistory::_onListSelectionChange));
 
+    // The event log selects the current event on every undo, redo and commit.
+    _event_list_selection->signal_changed().connect(sigc::mem_fun(*this, &UndoHistory::_updateStats));
+
     _callback_connections[EventLog::CALLB_EXPAND] =
         _event_list_view.signal_row_expanded().connect(sigc::mem_fun(*this, &Inkscape::UI::Dialog::UndoHistory::_onExpandEvent));
 
@@ -101,6 +111,7 @@ void UndoHistory::documentReplaced()
 
 void UndoHistory::disconnectEventLog()
 {
+    _commit_connection.disconnect();
     if (_event_log) {
         _event_log->removeDialogConnection(&_event_list_view, &_callback_connections);
         _event_list_view.unset_model();
@@ -117,7 +128,23 @@ void UndoHistory::connectEventLog()
         _event_list_view.set_model(_event_list_store);
         _event_log->addDialogConnection(&_event_list_view, &_callback_connections);
         _event_list_view.scroll_to_row(_event_list_store->get_path(_event_list_selection->get_selected()));
+        _commit_connection = document->connectCommit(sigc::mem_fun(*this, &UndoHistory::_updateStats));
+    }
+    _updateStats();
+}
+
+void UndoHistory::_updateStats()
+{
+    auto document = getDocument();
+    if (!document) {
+        _stats_label.set_text({});
+        return;
     }
+
+    auto const stats = DocumentUndo::getStats(document);
+    auto const kib = (stats.undo_bytes + stats.redo_bytes + 1023) / 1024;
+    _stats_label.set_text(Glib::ustring::compose(_("%1 undo, %2 redo steps, %3 KiB"),
+                                                 stats.undo_steps, stats.redo_steps, Util::format_size(kib)));
 }
 
 void
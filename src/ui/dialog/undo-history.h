@@ -19,9 +19,11 @@
 #include <glibmm/propertyproxy.h>
 #include <glibmm/refptr.h>
 #include <gtkmm/cellrenderertext.h>
+#include <gtkmm/label.h>
 #include <gtkmm/scrolledwindow.h>
 #include <gtkmm/treemodel.h>
 #include <gtkmm/treeselection.h>
+#include <sigc++/scoped_connection.h>
 
 #include "event-log.h"
 #include "ui/dialog/dialog-base.h"
@@ -84,6 +86,8 @@ private:
     EventLog *_event_log = nullptr;
 
     Gtk::ScrolledWindow _scrolled_window;
+    Gtk::Label _stats_label;
+    sigc::scoped_connection _commit_connection;
 
     Glib::RefPtr<Gtk::TreeModel> _event_list_store;
     Gtk::TreeView _event_list_view;
@@ -93,6 +97,7 @@ private:
 
     void disconnectEventLog();
     void connectEventLog();
+    void _updateStats();
 
     void _onListSelectionChange();
     void _onExpandEvent(const Gtk::TreeModel::iterator &iter, const Gtk::TreeModel::Path &path);
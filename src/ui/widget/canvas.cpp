@@ -23,8 +23,6 @@
 #include <thread>
 #include <utility>
 #include <vector>
-#include <boost/asio/thread_pool.hpp>
-#include <boost/asio/post.hpp>
 #include <gtkmm/eventcontrollerfocus.h>
 #include <gtkmm/eventcontrollerkey.h>
 #include <gtkmm/eventcontrollermotion.h>
@@ -50,6 +48,8 @@
 #include "display/control/snap-indicator.h"
 #include "display/drawing.h"
 #include "display/drawing-item.h"
+#include "display/task-scheduler.h"
+#include "display/threading.h"
 #include "document.h"
 #include "events/canvas-event.h"
 #include "helper/geom.h"
@@ -279,8 +279,7 @@ public:
     bool background_in_stores_required() const { return !q->get_opengl_enabled() && SP_RGBA32_A_U(page) == 255 && SP_RGBA32_A_U(desk) == 255; } // Enable solid colour optimisation if both page and desk are solid (as opposed to checkerboard).
 
     // Async redraw process.
-    std::optional<boost::asio::thread_pool> pool;
-    int numthreads;
+    std::shared_ptr<task_scheduler> pool;
     int get_numthreads() const;
 
     Synchronizer sync;
@@ -387,13 +386,8 @@ Canvas::Canvas()
     };
     d->prefs.numthreads.action = [this] {
         if (!d->active) return;
-        int const new_numthreads = d->get_numthreads();
-        if (d->numthreads == new_numthreads) return;
-        d->numthreads = new_numthreads;
+        // Restart rendering, so that it picks up the shared worker threads resized to match.
         d->deactivate();
-        d->deactivate_graphics();
-        d->pool.emplace(d->numthreads);
-        d->activate_graphics();
         d->activate();
     };
 
@@ -414,10 +408,6 @@ Canvas::Canvas()
     // OpenGL switch.
     set_opengl_enabled(d->prefs.request_opengl);
 
-    // Async redraw process.
-    d->numthreads = d->get_numthreads();
-    d->pool.emplace(d->numthreads);
-
     d->sync.connectExit([this] { d->after_redraw(); });
 }
 
@@ -694,7 +684,10 @@ void CanvasPrivate::launch_redraw()
     rd.margin = prefs.prerender;
     rd.redraw_delay = prefs.debug_delay_redraw ? std::make_optional<int>(prefs.debug_delay_redraw_time) : std::nullopt;
     rd.render_time_limit = prefs.render_time_limit;
-    rd.numthreads = get_numthreads();
+    // Render on the shared worker threads. Picking the scheduler up afresh for every redraw
+    // follows changes to the thread count, which replace it.
+    pool = get_global_task_scheduler();
+    rd.numthreads = std::min(get_numthreads(), pool->size());
     rd.background_in_stores_required = background_in_stores_required();
     rd.page = page;
     rd.desk = desk;
@@ -706,7 +699,7 @@ void CanvasPrivate::launch_redraw()
 
     abort_flags.store((int)AbortFlags::None, std::memory_order_relaxed);
 
-    boost::asio::post(*pool, [this] { init_tiler(); });
+    pool->post([this] { init_tiler(); }, task_scheduler::priority::interactive);
 }
 
 void CanvasPrivate::after_redraw()
@@ -2130,7 +2123,7 @@ void CanvasPrivate::init_tiler()
     rd.numactive = rd.numthreads;
 
     for (int i = 0; i < rd.numthreads - 1; i++) {
-        boost::asio::post(*pool, [=, this] { render_tile(i); });
+        pool->post([=, this] { render_tile(i); }, task_scheduler::priority::interactive);
     }
 
     render_tile(rd.numthreads - 1);
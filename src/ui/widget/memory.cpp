@@ -13,6 +13,7 @@
 
 #include "memory.h"
 
+#include <iomanip>
 #include <sigc++/functors/mem_fun.h>
 #include <glibmm/i18n.h>
 #include <glibmm/main.h>
@@ -34,6 +35,22 @@ using Inkscape::Util::format_size;
 
 namespace Inkscape::UI::Widget {
 
+namespace {
+
+Glib::ustring format_hit_rate(unsigned long hits, unsigned long misses)
+{
+    auto const lookups = hits + misses;
+    if (lookups == 0) {
+        return {};
+    }
+    // TRANSLATORS: Cache hit rate, e.g. "97.5% of 1200".
+    return Glib::ustring::compose(_("%1%% of %2"),
+                                  Glib::ustring::format(std::fixed, std::setprecision(1), 100.0 * hits / lookups),
+                                  lookups);
+}
+
+} // namespace
+
 struct Memory::Private
 {
     class ModelColumns : public Gtk::TreeModel::ColumnRecord
@@ -43,8 +60,9 @@ struct Memory::Private
         Gtk::TreeModelColumn<Glib::ustring> used;
         Gtk::TreeModelColumn<Glib::ustring> slack;
         Gtk::TreeModelColumn<Glib::ustring> total;
+        Gtk::TreeModelColumn<Glib::ustring> hit_rate;
 
-        ModelColumns() { add(name); add(used); add(slack); add(total); }
+        ModelColumns() { add(name); add(used); add(slack); add(total); add(hit_rate); }
     };
 
     Private()
@@ -57,6 +75,8 @@ struct Memory::Private
         //  More typical usage is to call this memory "free" rather than "slack".
         view.append_column(_("Slack"), columns.slack);
         view.append_column(_("Total"), columns.total);
+        // TRANSLATORS: Share of lookups in a cache that found what they looked for.
+        view.append_column(_("Hit Rate"), columns.hit_rate);
     }
 
     void update();
@@ -112,6 +132,11 @@ void Memory::Private::update()
             } else {
                 row->set_value(columns.slack, Glib::ustring(_("Unknown")));
             }
+            if ( features & Debug::Heap::HITS_AVAILABLE ) {
+                row->set_value(columns.hit_rate, format_hit_rate(stats.hits, stats.misses));
+            } else {
+                row->set_value(columns.hit_rate, Glib::ustring());
+            }
 
             ++row;
         }
@@ -145,6 +170,8 @@ void Memory::Private::update()
         row->set_value(columns.slack, Glib::ustring(_("Unknown")));
     }
 
+    row->set_value(columns.hit_rate, Glib::ustring());
+
     ++row;
 
     while ( row != model->children().end() ) {
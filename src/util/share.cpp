@@ -30,6 +30,33 @@ ptr_shared share_string(char const *string, std::size_t length) {
     return share_unsafe(new_string);
 }
 
+ptr_shared StringArena::share(char const *string) {
+    g_return_val_if_fail(string != nullptr, share_unsafe(nullptr));
+    return share(string, std::strlen(string));
+}
+
+ptr_shared StringArena::share(char const *string, std::size_t length) {
+    g_return_val_if_fail(string != nullptr, share_unsafe(nullptr));
+    if (length >= MAX_LENGTH) {
+        return share_string(string, length);
+    }
+
+    char *new_string;
+    {
+        std::scoped_lock lock(_mutex);
+        if (!_block || _used + length + 1 > BLOCK_SIZE) {
+            _block = new (GC::ATOMIC) char[BLOCK_SIZE];
+            _used = 0;
+        }
+        new_string = _block + _used;
+        _used += length + 1;
+    }
+
+    std::memcpy(new_string, string, length);
+    new_string[length] = 0;
+    return share_unsafe(new_string);
+}
+
 }
 }
 
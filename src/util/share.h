@@ -17,6 +17,7 @@
 #include "inkgc/gc-core.h"
 #include <cstring>
 #include <cstddef>
+#include <mutex>
 
 namespace Inkscape {
 namespace Util {
@@ -96,6 +97,38 @@ inline ptr_shared share_static_string(char const *string) {
     return share_unsafe(string);
 }
 
+/**
+ * Shares short strings by carving them out of larger garbage-collected blocks, rather than
+ * allocating each of them separately.
+ *
+ * A block is collected once none of the strings in it is referenced any more, so the strings
+ * may outlive the arena and be passed around like any other shared string. The arena itself
+ * must live in memory that is scanned by the garbage collector, which keeps its current block
+ * alive.
+ *
+ * Only strings are allocated this way. Nodes and their attribute records are left to the garbage
+ * collector, since the undo log, observers and other documents may still refer to them after
+ * their document is gone; there is no point at which a document could release them all.
+ */
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(StringArena const &) = delete;
+    StringArena &operator=(StringArena const &) = delete;
+
+    ptr_shared share(char const *string);
+    ptr_shared share(char const *string, std::size_t length);
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 4096;
+    /// Longer strings are allocated separately, so that they do not keep a block alive.
+    static constexpr std::size_t MAX_LENGTH = 256;
+
+    std::mutex _mutex;
+    char *_block = nullptr;
+    std::size_t _used = 0;
+};
+
 }
 }
 
@@ -14,6 +14,7 @@
 #define SEEN_INKSCAPE_XML_SP_REPR_DOC_H
 
 #include "xml/node.h"
+#include "util/share.h"
 
 namespace Inkscape {
 namespace XML {
@@ -103,6 +104,14 @@ public:
      * It should be made non-public in the future.
      */
     virtual NodeObserver *logger()=0;
+
+    /**
+     * @brief Copy a string for use as the content or an attribute value of one of this document's nodes
+     *
+     * Like the logger, this is an implementation detail of nodes. The copy may be shared by
+     * any number of nodes, in this document or another one, and is never modified.
+     */
+    virtual Util::ptr_shared shareString(char const *string)=0;
 };
 
 }
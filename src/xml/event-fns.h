@@ -10,6 +10,8 @@
 #ifndef SEEN_INKSCAPE_XML_SP_REPR_ACTION_FNS_H
 #define SEEN_INKSCAPE_XML_SP_REPR_ACTION_FNS_H
 
+#include <cstddef>
+
 namespace Inkscape {
 namespace XML {
 
@@ -32,6 +34,8 @@ void sp_repr_undo_log (Inkscape::XML::Event *log);
 void sp_repr_replay_log (Inkscape::XML::Event *log);
 Inkscape::XML::Event *sp_repr_coalesce_log (Inkscape::XML::Event *a, Inkscape::XML::Event *b);
 void sp_repr_free_log (Inkscape::XML::Event *log);
+void sp_repr_compact_log (Inkscape::XML::Event *log);
+std::size_t sp_repr_log_bytes (Inkscape::XML::Event const *log, Inkscape::XML::Event const *end = nullptr);
 void sp_repr_debug_print_log(Inkscape::XML::Event const *log);
 
 #endif
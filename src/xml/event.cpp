@@ -15,7 +15,11 @@
  */
 
 #include <glib.h> // g_assert()
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
 
 #include "event.h"
 #include "event-fns.h"
@@ -26,6 +30,79 @@
 
 int Inkscape::XML::Event::_next_serial=0;
 
+namespace {
+
+// Attribute values shorter than this are not worth compacting.
+constexpr std::size_t COMPACT_MIN_LENGTH = 1024;
+
+std::size_t string_bytes(Inkscape::Util::ptr_shared value) {
+    return value ? std::strlen(value) + 1 : 0;
+}
+
+}
+
+/**
+ * The value before a compact attribute change: what remains of it after removing the start and
+ * end it has in common with the value after the change, which the event still holds.
+ */
+struct Inkscape::XML::EventChgAttr::Delta {
+    std::size_t prefix;
+    std::size_t suffix;
+    std::string oldmid;
+
+    /// Rebuild the value before the change from the value after it.
+    Inkscape::Util::ptr_shared rebuild(char const *newval) const
+    {
+        auto const value = std::string_view(newval);
+        std::string result;
+        result.reserve(prefix + oldmid.size() + suffix);
+        result.append(value.substr(0, prefix));
+        result.append(oldmid);
+        result.append(value.substr(value.size() - suffix));
+        return Inkscape::Util::share_string(result.c_str(), result.size());
+    }
+};
+
+Inkscape::XML::EventChgAttr::~EventChgAttr() {
+    delete _delta;
+}
+
+void Inkscape::XML::EventChgAttr::compact() {
+    if (_delta || !oldval || !newval) {
+        return;
+    }
+
+    auto const oldstr = std::string_view(oldval);
+    auto const newstr = std::string_view(newval);
+    if (std::min(oldstr.size(), newstr.size()) < COMPACT_MIN_LENGTH) {
+        return;
+    }
+
+    auto const common = std::min(oldstr.size(), newstr.size());
+    std::size_t prefix = std::mismatch(oldstr.begin(), oldstr.begin() + common, newstr.begin()).first - oldstr.begin();
+    std::size_t suffix = std::mismatch(oldstr.rbegin(), oldstr.rbegin() + (common - prefix), newstr.rbegin()).first - oldstr.rbegin();
+
+    // Not worth it unless most of the value is unchanged.
+    if (oldstr.size() - prefix - suffix > oldstr.size() / 2) {
+        return;
+    }
+
+    _delta = new Delta;
+    _delta->prefix = prefix;
+    _delta->suffix = suffix;
+    _delta->oldmid = oldstr.substr(prefix, oldstr.size() - prefix - suffix);
+
+    // Let the old value be collected, unless something else still uses it.
+    oldval = Inkscape::Util::ptr_shared();
+}
+
+std::size_t Inkscape::XML::EventChgAttr::bytes() const {
+    if (_delta) {
+        return sizeof(*this) + sizeof(Delta) + _delta->oldmid.capacity() + string_bytes(newval);
+    }
+    return sizeof(*this) + string_bytes(oldval) + string_bytes(newval);
+}
+
 void
 sp_repr_begin_transaction (Inkscape::XML::Document *doc)
 {
@@ -166,7 +243,7 @@ void Inkscape::XML::EventDel::_undoOne(
 void Inkscape::XML::EventChgAttr::_undoOne(
     Inkscape::XML::NodeObserver &observer
 ) const {
-    observer.notifyAttributeChanged(*this->repr, this->key, this->newval, this->oldval);
+    observer.notifyAttributeChanged(*this->repr, this->key, this->newval, _delta ? _delta->rebuild(this->newval) : this->oldval);
 }
 
 void Inkscape::XML::EventChgContent::_undoOne(
@@ -234,7 +311,7 @@ void Inkscape::XML::EventDel::_replayOne(
 void Inkscape::XML::EventChgAttr::_replayOne(
     Inkscape::XML::NodeObserver &observer
 ) const {
-    observer.notifyAttributeChanged(*this->repr, this->key, this->oldval, this->newval);
+    observer.notifyAttributeChanged(*this->repr, this->key, _delta ? _delta->rebuild(this->newval) : this->oldval, this->newval);
 }
 
 void Inkscape::XML::EventChgContent::_replayOne(
@@ -292,6 +369,39 @@ sp_repr_free_log (Inkscape::XML::Event *log)
     }
 }
 
+/**
+ * Store the attribute changes of a log in less memory; see EventChgAttr::compact().
+ */
+void
+sp_repr_compact_log (Inkscape::XML::Event *log)
+{
+    for ( ; log ; log = log->next ) {
+        if (auto chg_attr = dynamic_cast<Inkscape::XML::EventChgAttr *>(log)) {
+            chg_attr->compact();
+        }
+    }
+}
+
+/**
+ * Approximate memory used by the events of a log, up to @a end, in bytes. Values shared between
+ * events, or with the document, are counted for each of them.
+ */
+std::size_t
+sp_repr_log_bytes (Inkscape::XML::Event const *log, Inkscape::XML::Event const *end)
+{
+    std::size_t bytes = 0;
+    for ( ; log != end ; log = log->next ) {
+        if (auto chg_attr = dynamic_cast<Inkscape::XML::EventChgAttr const *>(log)) {
+            bytes += chg_attr->bytes();
+        } else if (auto chg_content = dynamic_cast<Inkscape::XML::EventChgContent const *>(log)) {
+            bytes += sizeof(*chg_content) + string_bytes(chg_content->oldval) + string_bytes(chg_content->newval);
+        } else {
+            bytes += sizeof(Inkscape::XML::EventChgOrder); // the largest of the others
+        }
+    }
+    return bytes;
+}
+
 namespace {
 
 template <typename T> struct ActionRelations;
@@ -343,8 +453,9 @@ Inkscape::XML::Event *Inkscape::XML::EventDel::_optimizeOne() {
 Inkscape::XML::Event *Inkscape::XML::EventChgAttr::_optimizeOne() {
     Inkscape::XML::EventChgAttr *chg_attr=dynamic_cast<Inkscape::XML::EventChgAttr *>(this->next);
 
-    /* consecutive chgattrs on the same key can be combined */
-    if ( chg_attr) {
+    /* consecutive chgattrs on the same key can be combined,
+     * unless either no longer holds its old value */
+    if ( chg_attr && !chg_attr->isCompact() && !this->isCompact() ) {
         if ( chg_attr->repr == this->repr &&
              chg_attr->key == this->key )
         {
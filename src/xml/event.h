@@ -16,6 +16,7 @@
 typedef unsigned int GQuark;
 #include <glibmm/ustring.h>
 
+#include <cstddef>
 #include <iterator>
 #include "util/share.h"
 #include "util/forward-pointer-iterator.h"
@@ -167,15 +168,32 @@ public:
                  Event *next)
     : Event(repr, next), key(k),
       oldval(ov), newval(nv) {}
+    ~EventChgAttr() override;
 
     /// GQuark corresponding to the changed attribute's name
     GQuark key;
-    /// Value of the attribute before the change
+    /// Value of the attribute before the change, or NULL once the event is compact
     Inkscape::Util::ptr_shared oldval;
     /// Value of the attribute after the change
     Inkscape::Util::ptr_shared newval;
 
+    /**
+     * @brief Keep only the part of a long old value that differs from the new value
+     *
+     * The old value is rebuilt from the new one when the event is undone or replayed, so the
+     * event does not depend on the attribute's value at that time.
+     */
+    void compact();
+    /// Whether the old value has been replaced by its difference from the new one
+    bool isCompact() const { return _delta != nullptr; }
+
+    /// Approximate memory used by the event, including its values
+    std::size_t bytes() const;
+
 private:
+    struct Delta;
+    Delta *_delta = nullptr;
+
     Event *_optimizeOne() override;
     void _undoOne(NodeObserver &observer) const override;
     void _replayOne(NodeObserver &observer) const override;
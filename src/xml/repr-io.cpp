@@ -11,11 +11,17 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <libxml/parser.h>
+#include <libxml/parserInternals.h>
 #include <libxml/xinclude.h>
 
 #include "xml/repr.h"
@@ -48,6 +54,10 @@ using Inkscape::XML::AttributeVector;
 using Inkscape::XML::rebase_href_attrs;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
+static Document *sp_repr_sax_read(xmlInputReadCallback read_cb, xmlInputCloseCallback close_cb, void *io_context,
+                                  char const *url, char const *encoding, int parse_options,
+                                  const gchar *default_ns);
+static void sp_repr_finish_read(Node *root, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
@@ -93,6 +103,7 @@ public:
     int setFile( char const * filename );
 
     xmlDocPtr readXml();
+    Document *readRepr(const gchar *default_ns);
 
     static int readCb( void * context, char * buffer, int len );
     static int closeCb( void * context );
@@ -170,7 +181,7 @@ int XmlSource::setFile(char const *filename)
     return retVal;
 }
 
-xmlDocPtr XmlSource::readXml()
+static int xml_source_parse_options()
 {
     int parse_options = XML_PARSE_HUGE | XML_PARSE_RECOVER;
 
@@ -178,7 +189,20 @@ xmlDocPtr XmlSource::readXml()
     bool allowNetAccess = prefs->getBool("/options/externalresources/xml/allow_net_access", false);
     if (!allowNetAccess) parse_options |= XML_PARSE_NONET;
 
-    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), parse_options);
+    return parse_options;
+}
+
+xmlDocPtr XmlSource::readXml()
+{
+    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), xml_source_parse_options());
+}
+
+/**
+ * Parse the source straight into a repr tree, without building a libxml2 document first.
+ */
+Document *XmlSource::readRepr(const gchar *default_ns)
+{
+    return sp_repr_sax_read(readCb, closeCb, this, filename, getEncoding(), xml_source_parse_options(), default_ns);
 }
 
 int XmlSource::readCb( void * context, char * buffer, int len )
@@ -300,11 +324,16 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns, bo
     XmlSource src;
 
     if (src.setFile(filename) == 0) {
-        doc = src.readXml();
-        if (xinclude && doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
-            g_warning("XInclude processing failed for %s", filename);
+        if (xinclude) {
+            // XInclude processing operates on a libxml2 document.
+            doc = src.readXml();
+            if (doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
+                g_warning("XInclude processing failed for %s", filename);
+            }
+            rdoc = sp_repr_do_read(doc, default_ns);
+        } else {
+            rdoc = src.readRepr(default_ns);
         }
-        rdoc = sp_repr_do_read(doc, default_ns);
     }
 
     if (doc) {
@@ -323,9 +352,6 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns, bo
  */
 Document *sp_repr_read_mem (const gchar * buffer, gint length, const gchar *default_ns)
 {
-    xmlDocPtr doc;
-    Document * rdoc;
-
     xmlSubstituteEntitiesDefault(1);
 
     g_return_val_if_fail (buffer != nullptr, NULL);
@@ -335,13 +361,23 @@ Document *sp_repr_read_mem (const gchar * buffer, gint length, const gchar *defa
                                        // proper solution would be to check the preference "/options/externalresources/xml/allow_net_access"
                                        // as done in XmlSource::readXml which gets called by the analogous sp_repr_read_file()
                                        // but sp_repr_read_mem() seems to be called in locations where Inkscape::Preferences::get() fails badly
-    doc = xmlReadMemory (const_cast<gchar *>(buffer), length, nullptr, nullptr, parser_options);
 
-    rdoc = sp_repr_do_read (doc, default_ns);
-    if (doc) {
-        xmlFreeDoc (doc);
-    }
-    return rdoc;
+    struct MemorySource
+    {
+        gchar const *data;
+        gint remaining;
+    } source{buffer, std::max(length, 0)};
+
+    auto const read_cb = [] (void *context, char *out, int len) -> int {
+        auto &src = *static_cast<MemorySource *>(context);
+        int const n = std::min(len, src.remaining);
+        memcpy(out, src.data, n);
+        src.data += n;
+        src.remaining -= n;
+        return n;
+    };
+
+    return sp_repr_sax_read(read_cb, nullptr, &source, nullptr, nullptr, parser_options, default_ns);
 }
 
 /**
@@ -430,6 +466,275 @@ void repair_namespace(Node *repr, const gchar *prefix) {
 
 }
 
+namespace {
+
+/**
+ * Builds a repr tree from the SAX events of libxml2, without an intermediate libxml2 document.
+ *
+ * The resulting tree is the same as sp_repr_do_read() produces from the document libxml2 would
+ * have built: namespace declarations are dropped, whitespace-only text is dropped unless
+ * xml:space="preserve" is in effect, and CDATA sections are kept apart from text.
+ */
+class ReprBuilder
+{
+public:
+    explicit ReprBuilder(xmlParserCtxtPtr ctxt)
+        : _ctxt(ctxt)
+        , _doc(new Inkscape::XML::SimpleDocument())
+    {}
+
+    ~ReprBuilder()
+    {
+        if (_doc) {
+            Inkscape::GC::release(_doc);
+        }
+    }
+
+    static void install(xmlSAXHandler &sax)
+    {
+        sax.startElementNs = &startElementNs;
+        sax.endElementNs = &endElementNs;
+        sax.characters = &characters;
+        sax.ignorableWhitespace = &characters;
+        sax.cdataBlock = &cdataBlock;
+        sax.comment = &comment;
+        sax.processingInstruction = &processingInstruction;
+    }
+
+    /// Return the document, or null if it has no single root element.
+    Document *finish(const gchar *default_ns)
+    {
+        _flushText();
+        if (!_root) {
+            return nullptr;
+        }
+        if (!_multiple_roots) {
+            sp_repr_finish_read(_root, default_ns);
+        }
+        return std::exchange(_doc, nullptr);
+    }
+
+private:
+    struct Frame
+    {
+        Node *node;
+        int space_preserve; ///< As xmlNodeGetSpacePreserve(): 1 preserve, 0 default, -1 unspecified.
+    };
+
+    static ReprBuilder &get(void *ctx) { return *static_cast<ReprBuilder *>(static_cast<xmlParserCtxtPtr>(ctx)->_private); }
+
+    /// Return the qualified name for a namespace URI and local name, interned.
+    char const *_qualifiedName(xmlChar const *localname, xmlChar const *prefix, xmlChar const *uri)
+    {
+        // Names come from the parser's dictionary, so their addresses identify them.
+        auto const key = std::make_tuple(localname, prefix, uri);
+        auto it = _names.find(key);
+        if (it != _names.end()) {
+            return it->second;
+        }
+
+        char const *name = nullptr;
+        auto const ns_prefix = uri ? sp_xml_ns_uri_prefix(reinterpret_cast<char const *>(uri),
+                                                          reinterpret_cast<char const *>(prefix))
+                                   : nullptr;
+        if (ns_prefix) {
+            gchar *qname = g_strconcat(ns_prefix, ":", localname, nullptr);
+            name = g_intern_string(qname);
+            g_free(qname);
+        } else {
+            name = g_intern_string(reinterpret_cast<char const *>(localname));
+        }
+        _names.emplace(key, name);
+        return name;
+    }
+
+    void _append(Node *repr)
+    {
+        if (_stack.empty()) {
+            _doc->appendChild(repr);
+        } else {
+            _stack.back().node->appendChild(repr);
+        }
+        Inkscape::GC::release(repr);
+    }
+
+    void _flushText()
+    {
+        if (_text.empty()) {
+            return;
+        }
+
+        // Note: this only handles XML's rules for white space. SVG's specific rules
+        // are handled in sp-string.cpp.
+        bool const preserve = !_stack.empty() && _stack.back().space_preserve == 1;
+        bool const blank = std::all_of(_text.begin(), _text.end(), [] (char c) { return g_ascii_isspace(c); });
+
+        if (!_stack.empty() && (preserve || !blank)) {
+            _append(_doc->createTextNode(_text.c_str(), _text_is_cdata));
+        }
+        _text.clear();
+    }
+
+    void _addText(xmlChar const *ch, int len, bool cdata)
+    {
+        if (cdata != _text_is_cdata) {
+            _flushText();
+            _text_is_cdata = cdata;
+        }
+        _text.append(reinterpret_cast<char const *>(ch), len);
+    }
+
+    static void startElementNs(void *ctx, xmlChar const *localname, xmlChar const *prefix, xmlChar const *uri,
+                               int /*nb_namespaces*/, xmlChar const ** /*namespaces*/,
+                               int nb_attributes, int nb_defaulted, xmlChar const **attributes)
+    {
+        auto &self = get(ctx);
+        self._flushText();
+
+        if (self._stack.empty() && self._root) {
+            // Like sp_repr_do_read(), reject documents with several root elements.
+            self._multiple_roots = true;
+            xmlStopParser(self._ctxt);
+            return;
+        }
+
+        Node *repr = self._doc->createElement(self._qualifiedName(localname, prefix, uri));
+        int space_preserve = self._stack.empty() ? -1 : self._stack.back().space_preserve;
+
+        // Attributes defaulted from the DTD come last; libxml2 only adds them to its tree on request.
+        for (int i = 0; i < nb_attributes - nb_defaulted; i++) {
+            auto const attr = attributes + 5 * i;
+            auto const name = self._qualifiedName(attr[0], attr[1], attr[2]);
+            self._value.assign(reinterpret_cast<char const *>(attr[3]), reinterpret_cast<char const *>(attr[4]));
+            repr->setAttribute(name, self._value.c_str());
+
+            if (!strcmp(name, "xml:space")) {
+                if (self._value == "preserve") {
+                    space_preserve = 1;
+                } else if (self._value == "default") {
+                    space_preserve = 0;
+                }
+            }
+        }
+
+        self._append(repr);
+        self._stack.push_back({repr, space_preserve});
+        if (!self._root) {
+            self._root = repr;
+        }
+    }
+
+    static void endElementNs(void *ctx, xmlChar const * /*localname*/, xmlChar const * /*prefix*/,
+                             xmlChar const * /*uri*/)
+    {
+        auto &self = get(ctx);
+        self._flushText();
+        if (!self._stack.empty()) {
+            self._stack.pop_back();
+        }
+    }
+
+    static void characters(void *ctx, xmlChar const *ch, int len)
+    {
+        get(ctx)._addText(ch, len, false);
+    }
+
+    static void cdataBlock(void *ctx, xmlChar const *value, int len)
+    {
+        get(ctx)._addText(value, len, true);
+    }
+
+    static void comment(void *ctx, xmlChar const *value)
+    {
+        auto &self = get(ctx);
+        if (self._ctxt->inSubset) {
+            return; // Part of the DTD.
+        }
+        self._flushText();
+        self._append(self._doc->createComment(reinterpret_cast<char const *>(value)));
+    }
+
+    static void processingInstruction(void *ctx, xmlChar const *target, xmlChar const *data)
+    {
+        auto &self = get(ctx);
+        if (self._ctxt->inSubset) {
+            return;
+        }
+        self._flushText();
+        self._append(self._doc->createPI(reinterpret_cast<char const *>(target),
+                                         reinterpret_cast<char const *>(data)));
+    }
+
+    struct NameHash
+    {
+        std::size_t operator()(std::tuple<xmlChar const *, xmlChar const *, xmlChar const *> const &key) const
+        {
+            auto const h = std::hash<void const *>();
+            return h(std::get<0>(key)) ^ (h(std::get<1>(key)) * 31) ^ (h(std::get<2>(key)) * 131);
+        }
+    };
+
+    xmlParserCtxtPtr _ctxt;
+    Document *_doc;
+    Node *_root = nullptr;
+    bool _multiple_roots = false;
+    std::vector<Frame> _stack;
+    std::string _text;
+    bool _text_is_cdata = false;
+    std::string _value;
+    std::unordered_map<std::tuple<xmlChar const *, xmlChar const *, xmlChar const *>, char const *, NameHash> _names;
+};
+
+} // namespace
+
+/**
+ * Parses XML from the given input callbacks straight into a Document.
+ *
+ * Returns nullptr if the input has no root element.
+ */
+static Document *sp_repr_sax_read(xmlInputReadCallback read_cb, xmlInputCloseCallback close_cb, void *io_context,
+                                  char const *url, char const *encoding, int parse_options,
+                                  const gchar *default_ns)
+{
+    xmlSAXHandler sax;
+    xmlSAXVersion(&sax, 2);
+    ReprBuilder::install(sax);
+
+    // The remaining handlers are libxml2's own, which keep track of the DTD and its entities.
+    xmlParserCtxtPtr ctxt = xmlCreateIOParserCtxt(&sax, nullptr, read_cb, close_cb, io_context, XML_CHAR_ENCODING_NONE);
+    if (!ctxt) {
+        return nullptr;
+    }
+
+    if (encoding) {
+        if (auto handler = xmlFindCharEncodingHandler(encoding)) {
+            xmlSwitchToEncoding(ctxt, handler);
+        }
+    }
+    if (url && ctxt->input && !ctxt->input->filename) {
+        ctxt->input->filename = reinterpret_cast<char *>(xmlStrdup(reinterpret_cast<xmlChar const *>(url)));
+    }
+
+    // Entities are expanded by the parser, as there are no entity reference nodes to keep them in.
+    xmlCtxtUseOptions(ctxt, parse_options | XML_PARSE_NOENT);
+
+    Document *rdoc = nullptr;
+    {
+        ReprBuilder builder(ctxt);
+        ctxt->_private = &builder;
+        xmlParseDocument(ctxt);
+        rdoc = builder.finish(default_ns);
+    }
+
+    if (ctxt->myDoc) {
+        xmlFreeDoc(ctxt->myDoc);
+        ctxt->myDoc = nullptr;
+    }
+    xmlFreeParserCtxt(ctxt);
+
+    return rdoc;
+}
+
 /**
  * Reads in a XML file to create a Document
  */
@@ -468,34 +773,42 @@ Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns)
     }
 
     if (root != nullptr) {
-        /* promote elements of some XML documents that don't use namespaces
-         * into their default namespace */
-        if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
-            g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
-            repair_namespace(root, "svg");
-        } else if ( default_ns && !strchr(root->name(), ':') ) {
-            if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
-                promote_to_namespace(root, "svg");
-            }
-            if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
-                promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
-            }
-        }
+        sp_repr_finish_read(root, default_ns);
+    }
 
+    return rdoc;
+}
 
-        // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
-        // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
-        // icons.svg). How can one tell if a file is internal?
-        if ( !strcmp(root->name(), "svg:svg" ) ) {
-            Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-            bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
-            if( clean ) {
-                sp_attribute_clean_tree( root );
-            }
+/**
+ * Fix up the namespaces of a freshly read document and clean it, if enabled.
+ */
+static void sp_repr_finish_read(Node *root, const gchar *default_ns)
+{
+    /* promote elements of some XML documents that don't use namespaces
+     * into their default namespace */
+    if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
+        g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
+        repair_namespace(root, "svg");
+    } else if ( default_ns && !strchr(root->name(), ':') ) {
+        if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
+            promote_to_namespace(root, "svg");
+        }
+        if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
+            promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
         }
     }
 
-    return rdoc;
+
+    // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
+    // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
+    // icons.svg). How can one tell if a file is internal?
+    if ( !strcmp(root->name(), "svg:svg" ) ) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
+        if( clean ) {
+            sp_attribute_clean_tree( root );
+        }
+    }
 }
 
 gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
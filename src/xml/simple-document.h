@@ -74,10 +74,13 @@ protected:
         return new SimpleDocument(*this);
     }
     NodeObserver *logger() override { return this; }
+    Util::ptr_shared shareString(char const *string) override { return _strings.share(string); }
 
 private:
     bool _in_transaction;
     LogBuilder _log_builder;
+    /// Holds the text of the document's nodes, so that loading does not allocate every string separately.
+    Util::StringArena _strings;
 };
 
 }
@@ -167,7 +167,6 @@ public:
 } // namespace
 
 using Util::ptr_shared;
-using Util::share_string;
 using Util::share_unsafe;
 
 SimpleNode::SimpleNode(int code, Document *document)
@@ -293,7 +292,7 @@ void SimpleNode::_setParent(SimpleNode *parent) {
 
 void SimpleNode::setContent(gchar const *content) {
     ptr_shared old_content=_content;
-    ptr_shared new_content = ( content ? share_string(content) : ptr_shared() );
+    ptr_shared new_content = ( content ? _document->shareString(content) : ptr_shared() );
 
     Debug::EventTracker<> tracker;
     if (new_content) {
@@ -319,13 +318,13 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
     g_assert(std::none_of(name, name + strlen(name), [](char c) { return g_ascii_isspace(c); }));
 
     // Check usefulness of attributes on elements in the svg namespace, optionally don't add them to tree.
-    Glib::ustring element = g_quark_to_string(_name);
-    //g_message("setAttribute:  %s: %s: %s", element.c_str(), name, value);
-    gchar* cleaned_value = g_strdup( value );
+    gchar const *element = g_quark_to_string(_name);
+    //g_message("setAttribute:  %s: %s: %s", element, name, value);
+    gchar const *cleaned_value = value;
+    Glib::ustring cleaned_style;
 
     // Only check elements in SVG name space and don't block setting attribute to NULL.
-    // .raw() is only for performance reasons because Glib::ustring.== is slow
-    if (value != nullptr && element.raw().starts_with("svg:")) {
+    if (value != nullptr && g_str_has_prefix(element, "svg:")) {
 
         Inkscape::Preferences *prefs = Inkscape::Preferences::get();
         if( prefs->getBool("/options/svgoutput/check_on_editing") ) {
@@ -340,7 +339,6 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
             if( (attr_warn || attr_remove) && value != nullptr ) {
                 bool is_useful = sp_attribute_check_attribute( element, id, name, attr_warn );
                 if( !is_useful && attr_remove ) {
-                    g_free( cleaned_value );
                     return; // Don't add to tree.
                 }
             }
@@ -348,8 +346,8 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
             // Check style properties -- Note: if element is not yet inserted into
             // tree (and thus has no parent), default values will not be tested.
             if( !strcmp( name, "style" ) && (flags >= SP_ATTRCLEAN_STYLE_WARN) ) {
-                g_free( cleaned_value );
-                cleaned_value = g_strdup( sp_attribute_clean_style( this, value, flags ).c_str() );
+                cleaned_style = sp_attribute_clean_style( this, value, flags );
+                cleaned_value = cleaned_style.c_str();
                 // if( g_strcmp0( value, cleaned_value ) ) {
                 //     g_warning( "SimpleNode::setAttribute: %s", id.c_str() );
                 //     g_warning( "     original: %s", value);
@@ -374,7 +372,7 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
 
     ptr_shared new_value=ptr_shared();
     if (cleaned_value) { // set value of attribute
-        new_value = share_string(cleaned_value);
+        new_value = _document->shareString(cleaned_value);
         tracker.set<DebugSetAttribute>(*this, key, new_value);
         if (!ref) {
 	    _attributes.emplace_back(key, new_value);
@@ -391,9 +389,8 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
     if ( new_value != old_value && (!old_value || !new_value || strcmp(old_value, new_value))) {
         _document->logger()->notifyAttributeChanged(*this, key, old_value, new_value);
         _observers.notifyAttributeChanged(*this, key, old_value, new_value);
-        //g_warning( "setAttribute notified: %s: %s: %s: %s", name, element.c_str(), old_value, new_value ); 
+        //g_warning( "setAttribute notified: %s: %s: %s: %s", name, element, old_value, new_value ); 
     }
-    g_free( cleaned_value );
 }
 
 void SimpleNode::setCodeUnsafe(int code) {